@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <Core/Emulator.h>
+#include <Core/Config.h>
+#include <Core/ThreadPool.h>
+#include <Core/InstanceGroup.h>
+
+//! Game Boy frames per second (4194304 Hz / 70224 cycles)
+static const double FRAME_RATE = 4194304.0 / 70224.0;
+
+//! Frames an instance runs before handing its worker back
+static const uint64_t SLICE_FRAMES = 30;
+
+//! Buttons to hold from a frame on
+struct ScriptEvent {
+	uint64_t frame;
+	uint8_t buttons;
+};
+
+//! One emulator of the batch
+struct Job {
+	std::unique_ptr<Emulator> emulator;
+	const std::vector<ScriptEvent>* script;
+	size_t nextEvent;
+	uint8_t held;
+	uint64_t last;
+};
+
+static const std::map<std::string, uint8_t> nameToBit = {
+	{ "a", 1 << 0 }, { "b", 1 << 1 }, { "select", 1 << 2 }, { "start", 1 << 3 },
+	{ "right", 1 << 4 }, { "left", 1 << 5 }, { "up", 1 << 6 }, { "down", 1 << 7 }
+};
+
+/*! \brief Read an input script
+ *
+ *  One "<frame> <buttons>" line per change, buttons joined by + (ie. "120 start",
+ *  "300 right+a") or "-" to release everything. Lines starting with # are comments.
+ */
+static bool loadScript(const std::string& path, std::vector<ScriptEvent>& script) {
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		ScriptEvent event;
+		std::string buttons;
+		if (line.empty() || line[0] == '#' || !(fields >> event.frame)) {
+			continue;
+		}
+		if (!(fields >> buttons)) {
+			return false;
+		}
+
+		event.buttons = 0;
+		if (buttons != "-") {
+			std::istringstream names(buttons);
+			std::string name;
+			while (std::getline(names, name, '+')) {
+				const auto bit = nameToBit.find(name);
+				if (bit == nameToBit.end()) {
+					return false;
+				}
+				event.buttons |= bit->second;
+			}
+		}
+		if (!script.empty() && event.frame < script.back().frame) {
+			return false;
+		}
+		script.push_back(event);
+	}
+	return true;
+}
+
+//! Buttons a job holds on a frame
+static uint8_t scriptButtons(Job& job, const uint64_t frame) {
+	const std::vector<ScriptEvent>& script = *job.script;
+	while (job.nextEvent < script.size() && script[job.nextEvent].frame <= frame) {
+		job.held = script[job.nextEvent].buttons;
+		job.nextEvent += 1;
+	}
+	return job.held;
+}
+
+//! Run a few frames of a job, and queue the rest (worker thread)
+static void runSlice(ThreadPool& pool, Job& job) {
+	Emulator& emulator = *job.emulator;
+	const uint64_t sliceEnd = std::min(job.last, emulator.FrameCount() + SLICE_FRAMES);
+
+	while (emulator.running && emulator.FrameCount() < sliceEnd) {
+		emulator.input.QueueButtons(scriptButtons(job, emulator.FrameCount()));
+		emulator.RunFrame();
+	}
+
+	if (emulator.running && emulator.FrameCount() < job.last) {
+		pool.Submit([&pool, &job] { runSlice(pool, job); });
+	}
+}
+
+int main(int argc, char **argv) {
+	std::cout << "mfemu_batch v." << VERSION << " rev." << COMMIT << std::endl << std::endl;
+
+	std::string romFile("test.gb");
+	std::string confFile = Config::DEFAULT_FILE;
+	std::vector<std::string> scriptFiles;
+	int instances = 1;
+	long long frames = 3600;
+	int threads = 0;
+	bool shareMachines = false;
+	int mergeEvery = InstanceGroup::DEFAULT_MERGE_EVERY;
+
+	EmulatorFlags emulatorFlags;
+	emulatorFlags.headless = true;
+	emulatorFlags.audio = false;
+	emulatorFlags.rewindEvery = 0;
+
+	for (int i = 1; i < argc; i += 1) {
+		if (argv[i][0] == '-') {
+			switch (argv[i][1]) {
+			case 'n':
+				instances = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+				if (instances < 1) {
+					std::cout << "Invalid instance count provided (not an integer or less than 1)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 'f':
+				frames = i + 1 < argc ? atoll(argv[i + 1]) : 0;
+				if (frames < 1) {
+					std::cout << "Invalid frame count provided (not an integer or less than 1)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 'j':
+				threads = i + 1 < argc ? atoi(argv[i + 1]) : -1;
+				if (threads < 0) {
+					std::cout << "Invalid thread count provided (not an integer or negative)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 's':
+				if (i + 1 >= argc) {
+					std::cout << "No input script provided" << std::endl;
+					return 1;
+				}
+				scriptFiles.push_back(argv[i + 1]);
+				i += 1;
+				break;
+			case 'l':
+				if (i + 1 >= argc) {
+					std::cout << "No save state file provided" << std::endl;
+					return 1;
+				}
+				emulatorFlags.stateFile = std::string(argv[i + 1]);
+				i += 1;
+				break;
+			case 'c':
+				if (i + 1 >= argc) {
+					std::cout << "No configuration file provided" << std::endl;
+					return 1;
+				}
+				confFile = std::string(argv[i + 1]);
+				i += 1;
+				break;
+			case 'm':
+				shareMachines = true;
+				break;
+			case 'M':
+				mergeEvery = i + 1 < argc ? atoi(argv[i + 1]) : -1;
+				if (mergeEvery < 0) {
+					std::cout << "Invalid merge interval provided (not an integer or negative)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 'b':
+				emulatorFlags.useBootrom = false;
+				break;
+			case 'F':
+				emulatorFlags.forceFifo = true;
+				break;
+			default:
+				std::cout << "Usage: " << argv[0] << " [flags] <file.gb>\r\n"
+					<< "\r\nRuns many headless instances of one ROM across a thread pool.\r\n"
+					<< "\r\nOptions are listed below:\r\n"
+					<< "\t-h   : get this help\r\n"
+					<< "\t-n X : run X instances (default: 1)\r\n"
+					<< "\t-f X : run X frames per instance (default: 3600)\r\n"
+					<< "\t-j X : use X threads, 0 for one per core (default: 0)\r\n"
+					<< "\t-s X : input script X, repeat for more (instance N uses script N modulo the count)\r\n"
+					<< "\t       (one \"<frame> <buttons>\" line per change, ie. \"120 start\", \"300 right+a\", \"400 -\")\r\n"
+					<< "\t-m   : run instances in the same state with the same input once (single thread)\r\n"
+					<< "\t-M X : with -m, merge machines back into the same state every X frames, 0 for never\r\n"
+					<< "\t       (hashes every machine's state, default: " << InstanceGroup::DEFAULT_MERGE_EVERY << ")\r\n"
+					<< "\t-l X : start every instance from save state X\r\n"
+					<< "\t-c X : load configuration from file X (default: " << Config::DEFAULT_FILE << ")\r\n"
+					<< "\t-F   : use the pixel FIFO renderer\r\n"
+					<< "\t-b   : skip the DMG boot rom [experimental]\r\n" << std::endl;
+				return 0;
+			}
+		} else {
+			romFile = std::string(argv[i]);
+		}
+	}
+
+	Config config;
+	if (config.LoadFromFile(confFile)) {
+		std::cout << "[INFO] Loaded conf from " << confFile << "\r\n";
+	}
+
+	std::vector<std::vector<ScriptEvent>> scripts(scriptFiles.empty() ? 1 : scriptFiles.size());
+	for (size_t i = 0; i < scriptFiles.size(); ++i) {
+		if (!loadScript(scriptFiles[i], scripts[i])) {
+			std::cout << "Invalid input script " << scriptFiles[i] << std::endl;
+			return 1;
+		}
+	}
+
+	// Load the ROM once, every instance shares it
+	Emulator base(romFile, emulatorFlags, config);
+	if (!base.Start()) {
+		return 1;
+	}
+
+	std::vector<Job> jobs(instances);
+	for (int i = 0; i < instances; ++i) {
+		jobs[i].script = &scripts[i % scripts.size()];
+		jobs[i].nextEvent = 0;
+		jobs[i].held = 0;
+		jobs[i].last = base.FrameCount() + frames;
+	}
+
+	std::unique_ptr<InstanceGroup> group;
+	double seconds;
+	if (shareMachines) {
+		group.reset(new InstanceGroup(base, instances, mergeEvery));
+		std::cout << "[INFO] Running " << instances << " instances for " << frames << " frames on shared machines" << std::endl;
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<uint8_t> actions(instances);
+		for (uint64_t frame = base.FrameCount(); frame < jobs[0].last; ++frame) {
+			for (int i = 0; i < instances; ++i) {
+				actions[i] = scriptButtons(jobs[i], frame);
+			}
+			group->RunFrame(actions);
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} else {
+		for (Job& job : jobs) {
+			job.emulator = base.Fork();
+		}
+
+		ThreadPool pool(threads);
+		std::cout << "[INFO] Running " << instances << " instances for " << frames << " frames on "
+			<< pool.Size() << " threads" << std::endl;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (Job& job : jobs) {
+			pool.Submit([&pool, &job] { runSlice(pool, job); });
+		}
+		pool.Wait();
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	uint64_t totalFrames = 0;
+	for (int i = 0; i < instances; ++i) {
+		const Emulator& emulator = group ? group->Instance(i) : *jobs[i].emulator;
+		std::vector<ChunkHash> chunks;
+		totalFrames += emulator.FrameCount() - base.FrameCount();
+		std::cout << "Instance " << i << ": frame " << emulator.FrameCount()
+			<< (emulator.running ? "" : " (halted)")
+			<< ", state " << std::hex << std::setw(16) << std::setfill('0') << SaveState::Hash(emulator, chunks)
+			<< std::dec << std::setfill(' ') << std::endl;
+	}
+
+	const double fps = totalFrames / seconds;
+	std::cout << std::endl << totalFrames << " frames in " << std::fixed << std::setprecision(3) << seconds << "s: "
+		<< std::setprecision(1) << fps << " frames/s (" << fps / FRAME_RATE << "x realtime)" << std::endl;
+	if (group) {
+		std::cout << "Each emulated frame served " << std::setprecision(2) << group->Sharing()
+			<< " instances on average, " << group->Machines() << " machines at the end" << std::endl;
+	}
+	return 0;
+}
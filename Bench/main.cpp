@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <Core/Emulator.h>
+
+//! Result of a benchmark (time per operation, over all samples)
+struct BenchResult {
+	std::string name;
+	std::string unit;       //!< What an operation is (ie. ns/op, ns/frame)
+	uint64_t iterations;    //!< Operations per sample
+	size_t samples;
+	double min, median, p99;
+};
+
+//! Benchmark options
+struct BenchOptions {
+	size_t samples = 51;
+	double scale = 1.0;     //!< Multiplies the operations per sample
+	std::string filter;     //!< Only run benchmarks whose name contains this
+	std::string romFile;    //!< ROM for the frame benchmarks (default: built-in homebrew)
+};
+
+//! Time-critical parts of the machine, without the Emulator around them
+struct Machine {
+	ROM rom;
+	GPU gpu;
+	APU apu;
+	Input input;
+	MMU mmu;
+	CPU cpu;
+
+	explicit Machine(const std::vector<uint8_t>& image) : rom(image), mmu(&rom, &gpu, &input, &apu), cpu(&mmu) {
+		gpu.InitScreen(nullptr);
+		mmu.usingBootstrap = false;
+	}
+};
+
+//! Keeps results alive so the compiler can't drop the benchmarked work
+static volatile uint32_t sink;
+
+/*! \brief Homebrew benchmark ROM
+ *
+ *  Fills the tiles and both maps, places 40 sprites and the window, turns
+ *  the LCD on, then every frame: HALT until VBlank, scroll, and crunch
+ *  256 bytes of WRAM. Exercises every layer, interrupts and a mix of
+ *  ALU/memory opcodes. Made to run without the boot rom.
+ */
+static std::vector<uint8_t> homebrewROM() {
+	static const uint8_t code[] = {
+		0xf3,                   // di
+		0x31, 0xfe, 0xff,       // ld sp,$fffe
+		0x21, 0x00, 0x80,       // ld hl,$8000
+		0x7d,                   // tiles: ld a,l
+		0xac,                   //        xor h
+		0x22,                   //        ld (hl+),a
+		0x7c,                   //        ld a,h
+		0xfe, 0x98,             //        cp $98
+		0x20, 0xf8,             //        jr nz,tiles
+		0x7d,                   // maps:  ld a,l
+		0x22,                   //        ld (hl+),a
+		0x7c,                   //        ld a,h
+		0xfe, 0xa0,             //        cp $a0
+		0x20, 0xf9,             //        jr nz,maps
+		0x21, 0x00, 0xfe,       // ld hl,$fe00
+		0x06, 0x00,             // ld b,0
+		0x78,                   // oam:   ld a,b
+		0x87,                   //        add a,a
+		0x80,                   //        add a,b
+		0xc6, 0x10,             //        add a,16
+		0x22,                   //        ld (hl+),a   ; y = 16 + 3b
+		0x78,                   //        ld a,b
+		0x87,                   //        add a,a
+		0x87,                   //        add a,a
+		0xc6, 0x08,             //        add a,8
+		0x22,                   //        ld (hl+),a   ; x = 8 + 4b
+		0x78,                   //        ld a,b
+		0x22,                   //        ld (hl+),a   ; tile = b
+		0xaf,                   //        xor a
+		0x22,                   //        ld (hl+),a   ; flags = 0
+		0x04,                   //        inc b
+		0x78,                   //        ld a,b
+		0xfe, 0x28,             //        cp 40
+		0x20, 0xea,             //        jr nz,oam
+		0x3e, 0xe4,             // ld a,$e4
+		0xe0, 0x47,             // ldh (BGP),a
+		0xe0, 0x48,             // ldh (OBP0),a
+		0x3e, 0x50,             // ld a,80
+		0xe0, 0x4a,             // ldh (WY),a
+		0x3e, 0x57,             // ld a,87
+		0xe0, 0x4b,             // ldh (WX),a
+		0x3e, 0x01,             // ld a,1
+		0xe0, 0xff,             // ldh (IE),a      ; VBlank
+		0x3e, 0xf3,             // ld a,$f3
+		0xe0, 0x40,             // ldh (LCDC),a    ; LCD, window (9c00), tiles 8000, sprites, BG
+		0xfb,                   // ei
+		0x76,                   // main:  halt
+		0xf0, 0x43,             //        ldh a,(SCX)
+		0x3c,                   //        inc a
+		0xe0, 0x43,             //        ldh (SCX),a
+		0x21, 0x00, 0xc0,       //        ld hl,$c000
+		0x0e, 0x00,             //        ld c,0
+		0x7e,                   // work:  ld a,(hl)
+		0x81,                   //        add a,c
+		0xa9,                   //        xor c
+		0x77,                   //        ld (hl),a
+		0x23,                   //        inc hl
+		0xcb, 0x3f,             //        srl a
+		0x0d,                   //        dec c
+		0x20, 0xf6,             //        jr nz,work
+		0x18, 0xe9,             //        jr main
+	};
+
+	std::vector<uint8_t> image(32 * 1024, 0);
+	image[0x40] = 0xd9;                                 // VBlank: reti
+	const uint8_t entry[] = { 0x00, 0xc3, 0x50, 0x01 }; // nop, jp $0150
+	memcpy(&image[0x100], entry, sizeof(entry));
+	memcpy(&image[0x134], "MFEMUBENCH", 10);
+	memcpy(&image[0x150], code, sizeof(code));
+
+	uint8_t checksum = 0;
+	for (size_t i = 0x134; i < 0x14d; ++i) {
+		checksum = checksum - image[i] - 1;
+	}
+	image[0x14d] = checksum;
+	return image;
+}
+
+/*! \brief Time a benchmark
+ *
+ *  \param body Runs the given number of operations
+ */
+template <typename Body>
+static BenchResult measure(const std::string& name, const std::string& unit, const BenchOptions& options,
+	const uint64_t baseIterations, Body body) {
+	const uint64_t iterations = std::max<uint64_t>(1, (uint64_t)(baseIterations * options.scale));
+
+	// Warm up caches and branch predictors
+	body(iterations);
+
+	std::vector<double> times(options.samples);
+	for (double& time : times) {
+		const auto start = std::chrono::steady_clock::now();
+		body(iterations);
+		time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+	}
+	std::sort(times.begin(), times.end());
+
+	BenchResult result;
+	result.name = name;
+	result.unit = unit;
+	result.iterations = iterations;
+	result.samples = times.size();
+	result.min = times.front();
+	result.median = times[times.size() / 2];
+	result.p99 = times[std::min(times.size() - 1, (size_t)(times.size() * 0.99))];
+	return result;
+}
+
+static bool selected(const BenchOptions& options, const std::string& name) {
+	return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+//! Opcode dispatch, by class of instruction
+static void benchOpcodes(const std::vector<uint8_t>& image, const BenchOptions& options, std::vector<BenchResult>& results) {
+	struct OpcodeClass {
+		const char* name;
+		std::vector<uint8_t> opcodes;
+	};
+	std::vector<OpcodeClass> classes = {
+		{ "nop",       { 0x00 } },
+		{ "alu_d8",    { 0xc6, 0xce, 0xd6, 0xde, 0xe6, 0xee, 0xf6, 0xfe } },
+		{ "inc_dec",   { 0x04, 0x05, 0x0c, 0x0d, 0x14, 0x15, 0x1c, 0x1d, 0x24, 0x25, 0x2c, 0x2d, 0x3c, 0x3d,
+		                 0x03, 0x0b, 0x13, 0x1b, 0x23, 0x2b, 0x33, 0x3b } },
+		{ "jump_call", { 0x18, 0x20, 0x28, 0x30, 0x38, 0xc3, 0xc2, 0xca, 0xd2, 0xda, 0xcd, 0xc9 } },
+		{ "push_pop",  { 0xc5, 0xd5, 0xe5, 0xf5, 0xc1, 0xd1, 0xe1, 0xf1 } },
+		{ "ld_r_r",    {} },
+		{ "ld_mem",    {} },
+		{ "alu_r",     {} },
+	};
+	for (int opcode = 0x40; opcode < 0xc0; ++opcode) {
+		const bool memory = (opcode & 0x07) == 0x06 || (opcode >= 0x70 && opcode < 0x78);
+		if (opcode == 0x76) {
+			continue; // HALT
+		}
+		if (opcode < 0x80) {
+			classes[memory ? 6 : 5].opcodes.push_back((uint8_t)opcode);
+		} else if (!memory) {
+			classes[7].opcodes.push_back((uint8_t)opcode);
+		}
+	}
+
+	Machine machine(image);
+	CPU& cpu = machine.cpu;
+
+	// Operands: c100-c1ff holds 00-ff (CB opcodes, immediates), stack at dff0
+	for (int i = 0; i < 0x100; ++i) {
+		machine.mmu.Write(0xc100 + i, (uint8_t)i);
+	}
+
+	for (const OpcodeClass& opcodeClass : classes) {
+		const std::string name = std::string("cpu/") + opcodeClass.name;
+		if (!selected(options, name)) {
+			continue;
+		}
+		const std::vector<uint8_t>& opcodes = opcodeClass.opcodes;
+		results.push_back(measure(name, "ns/op", options, 1000000, [&](const uint64_t iterations) {
+			uint64_t total = 0;
+			for (uint64_t i = 0; i < iterations; ++i) {
+				cpu.PC = 0xc100 + (i & 0xff);
+				cpu.SP = 0xdff0;
+				cpu.HL.Pair = 0xc800;
+				total += cpu.Execute(opcodes[i % opcodes.size()]).cpu;
+			}
+			sink = (uint32_t)total;
+		}));
+	}
+
+	if (selected(options, "cpu/cb")) {
+		results.push_back(measure("cpu/cb", "ns/op", options, 1000000, [&](const uint64_t iterations) {
+			uint64_t total = 0;
+			for (uint64_t i = 0; i < iterations; ++i) {
+				cpu.PC = 0xc100 + (i & 0xff);
+				cpu.HL.Pair = 0xc800;
+				total += cpu.Execute(0xcb).cpu;
+			}
+			sink = (uint32_t)total;
+		}));
+	}
+}
+
+//! Memory accesses, by region
+static void benchMemory(const std::vector<uint8_t>& image, const BenchOptions& options, std::vector<BenchResult>& results) {
+	struct Region {
+		const char* name;
+		uint16_t base;
+		bool writable;
+	};
+	static const Region regions[] = {
+		{ "rom0", 0x0150, false },
+		{ "romx", 0x4150, false },
+		{ "vram", 0x8000, true  },
+		{ "wram", 0xc000, true  },
+		{ "echo", 0xe000, true  },
+		{ "oam",  0xfe00, true  },
+		{ "io",   0xff40, true  },
+		{ "hram", 0xff80, true  },
+	};
+
+	Machine machine(image);
+	MMU& mmu = machine.mmu;
+
+	for (const Region& region : regions) {
+		// Stay inside small regions (OAM, IO, HRAM)
+		const uint16_t mask = region.base >= 0xfe00 ? 0x0f : 0xff;
+
+		const std::string readName = std::string("mmu/read/") + region.name;
+		if (selected(options, readName)) {
+			results.push_back(measure(readName, "ns/op", options, 2000000, [&](const uint64_t iterations) {
+				uint32_t total = 0;
+				for (uint64_t i = 0; i < iterations; ++i) {
+					total += mmu.Read(region.base + (i & mask));
+				}
+				sink = total;
+			}));
+		}
+
+		const std::string writeName = std::string("mmu/write/") + region.name;
+		if (region.writable && selected(options, writeName)) {
+			results.push_back(measure(writeName, "ns/op", options, 2000000, [&](const uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; ++i) {
+					// IO: scroll registers, harmless to rewrite
+					const uint16_t location = region.base == 0xff40 ? 0xff42 + (i & 1) : region.base + (i & mask);
+					mmu.Write(location, (uint8_t)i);
+				}
+			}));
+		}
+	}
+
+	if (selected(options, "mmu/timers")) {
+		mmu.timerControl.raw = 0x05; // Enabled, one tick every 16 clocks
+		results.push_back(measure("mmu/timers", "ns/op", options, 2000000, [&](const uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; ++i) {
+				mmu.UpdateTimers(CycleCount(1, 4));
+			}
+			sink = mmu.timerCounter;
+		}));
+	}
+}
+
+//! Line rendering, by enabled layers and renderer (one frame of GPU work per operation)
+static void benchGPU(const std::vector<uint8_t>& image, const BenchOptions& options, std::vector<BenchResult>& results) {
+	struct Layers {
+		const char* name;
+		uint8_t lcdControl;
+	};
+	static const Layers layers[] = {
+		{ "bg",            0x91 },
+		{ "bg_window",     0xf1 },
+		{ "bg_sprites",    0x93 },
+		{ "bg_window_sprites", 0xf3 },
+	};
+	static const struct {
+		const char* name;
+		RenderMode mode;
+	} renderers[] = { { "scanline", Render_Scanline }, { "fifo", Render_FIFO } };
+
+	Machine machine(image);
+	GPU& gpu = machine.gpu;
+
+	// Same picture as the homebrew ROM: patterned tiles and maps, 40 sprites, window at 80,80
+	for (size_t i = 0; i < 0x1800; ++i) {
+		gpu.VRAM[0].bytes[i] = (uint8_t)(i ^ ((0x8000 + i) >> 8));
+	}
+	for (size_t i = 0x1800; i < 0x2000; ++i) {
+		gpu.VRAM[0].bytes[i] = (uint8_t)i;
+	}
+	for (uint8_t i = 0; i < SPRITE_COUNT; ++i) {
+		gpu.sprites[i].y = 16 + i * 3;
+		gpu.sprites[i].x = 8 + i * 4;
+		gpu.sprites[i].pattern = i;
+		gpu.sprites[i].flags.raw = 0;
+	}
+	gpu.bgPalette.raw = gpu.spritePalette1.raw = 0xe4;
+	gpu.winScrollY = 80;
+	gpu.winScrollX = 87;
+
+	for (const auto& renderer : renderers) {
+		for (const Layers& layer : layers) {
+			const std::string name = std::string("gpu/") + renderer.name + "/" + layer.name;
+			if (!selected(options, name)) {
+				continue;
+			}
+			gpu.renderMode = renderer.mode;
+			gpu.lcdControl.raw = layer.lcdControl;
+			results.push_back(measure(name, "ns/frame", options, 20, [&](const uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; ++i) {
+					for (int cycle = 0; cycle < 70224; cycle += 4) {
+						gpu.Step(4);
+					}
+				}
+				sink = gpu.screen[0];
+			}));
+		}
+	}
+}
+
+//! Whole machine, frame by frame
+static void benchFrames(const std::vector<uint8_t>& image, const BenchOptions& options, std::vector<BenchResult>& results) {
+	static const struct {
+		const char* name;
+		bool fifo;
+	} renderers[] = { { "scanline", false }, { "fifo", true } };
+
+	for (const auto& renderer : renderers) {
+		const std::string name = std::string("frame/") + renderer.name;
+		if (!selected(options, name)) {
+			continue;
+		}
+
+		EmulatorFlags flags;
+		flags.headless = true;
+		flags.audio = false;
+		flags.rewindEvery = 0;
+		flags.useBootrom = !options.romFile.empty();
+		flags.forceFifo = renderer.fifo;
+		std::unique_ptr<Emulator> emulator;
+		if (options.romFile.empty()) {
+			emulator.reset(new Emulator(ROM(image), "mfemu-bench.gb", flags));
+		} else {
+			emulator.reset(new Emulator(options.romFile, flags));
+		}
+		if (!emulator->Start()) {
+			continue;
+		}
+
+		results.push_back(measure(name, "ns/frame", options, 20, [&](const uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations && emulator->running; ++i) {
+				emulator->RunFrame();
+			}
+		}));
+	}
+}
+
+static void writeJSON(std::ostream& out, const std::vector<BenchResult>& results) {
+	out << "{\n  \"version\": \"" << VERSION << "\",\n  \"commit\": \"" << COMMIT << "\",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchResult& result = results[i];
+		out << "    { \"name\": \"" << result.name << "\", \"unit\": \"" << result.unit
+			<< "\", \"iterations\": " << result.iterations << ", \"samples\": " << result.samples
+			<< ", \"min\": " << result.min << ", \"median\": " << result.median << ", \"p99\": " << result.p99
+			<< " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+static void writeCSV(std::ostream& out, const std::vector<BenchResult>& results) {
+	out << "name,unit,iterations,samples,min,median,p99\n";
+	for (const BenchResult& result : results) {
+		out << result.name << "," << result.unit << "," << result.iterations << "," << result.samples << ","
+			<< result.min << "," << result.median << "," << result.p99 << "\n";
+	}
+}
+
+int main(int argc, char **argv) {
+	BenchOptions options;
+	std::string format = "json";
+	std::string outFile;
+
+	for (int i = 1; i < argc; i += 1) {
+		if (argv[i][0] == '-') {
+			switch (argv[i][1]) {
+			case 's': {
+				const int samples = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+				if (samples < 1) {
+					std::cerr << "Invalid sample count provided (not an integer or less than 1)" << std::endl;
+					return 1;
+				}
+				options.samples = samples;
+				i += 1;
+				break;
+			}
+			case 'x':
+				options.scale = i + 1 < argc ? atof(argv[i + 1]) : 0;
+				if (options.scale <= 0) {
+					std::cerr << "Invalid scale provided (not a number or not positive)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 'n':
+				if (i + 1 >= argc) {
+					std::cerr << "No filter provided" << std::endl;
+					return 1;
+				}
+				options.filter = argv[i + 1];
+				i += 1;
+				break;
+			case 'f':
+				format = i + 1 < argc ? argv[i + 1] : "";
+				if (format != "json" && format != "csv") {
+					std::cerr << "Invalid format provided (use json or csv)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 'o':
+				if (i + 1 >= argc) {
+					std::cerr << "No output file provided" << std::endl;
+					return 1;
+				}
+				outFile = argv[i + 1];
+				i += 1;
+				break;
+			case 'r':
+				if (i + 1 >= argc) {
+					std::cerr << "No ROM provided" << std::endl;
+					return 1;
+				}
+				options.romFile = argv[i + 1];
+				i += 1;
+				break;
+			default:
+				std::cerr << "Usage: " << argv[0] << " [flags]\r\n"
+					<< "\r\nTimes the CPU, MMU and GPU hot paths and whole frames, reports min/median/p99.\r\n"
+					<< "\r\nOptions are listed below:\r\n"
+					<< "\t-h   : get this help\r\n"
+					<< "\t-s X : take X samples per benchmark (default: 51)\r\n"
+					<< "\t-x X : multiply the operations per sample by X (default: 1)\r\n"
+					<< "\t-n X : only run benchmarks whose name contains X (ie. cpu/, mmu/read, gpu/fifo)\r\n"
+					<< "\t-f X : output format, json or csv (default: json)\r\n"
+					<< "\t-o X : write results to file X (default: standard output)\r\n"
+					<< "\t-r X : run the frame benchmarks on ROM X, with the boot rom (default: built-in homebrew)\r\n" << std::endl;
+				return 0;
+			}
+		}
+	}
+
+	// Progress and ROM messages go to stderr, results to stdout
+	std::streambuf* console = std::cout.rdbuf(std::cerr.rdbuf());
+
+	const std::vector<uint8_t> image = homebrewROM();
+	std::vector<BenchResult> results;
+	benchOpcodes(image, options, results);
+	benchMemory(image, options, results);
+	benchGPU(image, options, results);
+
+	benchFrames(image, options, results);
+
+	std::cout.rdbuf(console);
+
+	std::ofstream file;
+	if (!outFile.empty()) {
+		file.open(outFile);
+		if (!file.is_open()) {
+			std::cerr << "[WARNING] Could not write " << outFile << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& out = outFile.empty() ? std::cout : file;
+	out << std::fixed << std::setprecision(2);
+	if (format == "csv") {
+		writeCSV(out, results);
+	} else {
+		writeJSON(out, results);
+	}
+	return 0;
+}
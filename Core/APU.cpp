@@ -0,0 +1,487 @@
+#include "APU.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Longest stretch emulated before ending a blip frame (~15 ms)
+static const uint64_t MAX_FRAME_CLOCKS = 65536;
+
+// Amplitude of a single channel step, max output is 4 channels * 15 * 8 (master volume)
+static const int32_t VOLUME_SCALE = 64;
+
+// Bits that always read as 1 (ff10-ff2f)
+static const uint8_t readMasks[0x20] = {
+	0x80, 0x3f, 0x00, 0xff, 0xbf, // ff10-ff14 Square #1
+	0xff, 0x3f, 0x00, 0xff, 0xbf, // ff15-ff19 Square #2
+	0x7f, 0xff, 0x9f, 0xff, 0xbf, // ff1a-ff1e Wave
+	0xff, 0xff, 0x00, 0x00, 0xbf, // ff1f-ff23 Noise
+	0x00, 0x00, 0x70,             // ff24-ff26 Control
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff // ff27-ff2f <empty>
+};
+
+// Square waveforms (12.5%, 25%, 50%, 75%)
+static const uint8_t dutyCycles[4][8] = {
+	{ 0, 0, 0, 0, 0, 0, 0, 1 },
+	{ 1, 0, 0, 0, 0, 0, 0, 1 },
+	{ 1, 0, 0, 0, 0, 1, 1, 1 },
+	{ 0, 1, 1, 1, 1, 1, 1, 0 }
+};
+
+// Noise divisors (in clocks) by divisor code
+static const uint32_t noiseDivisors[8] = { 8, 16, 32, 48, 64, 80, 96, 112 };
+
+void Envelope::Trigger() {
+	volume = initial;
+	timer = period;
+}
+
+void Envelope::Clock() {
+	if (period == 0 || timer == 0) {
+		return;
+	}
+	if (--timer == 0) {
+		timer = period;
+		if (increase && volume < 15) {
+			volume += 1;
+		} else if (!increase && volume > 0) {
+			volume -= 1;
+		}
+	}
+}
+
+APU::APU(const int _sampleRate)
+	: sampleRate(_sampleRate),
+	left(CLOCK_RATE, _sampleRate, _sampleRate / 4),
+	right(CLOCK_RATE, _sampleRate, _sampleRate / 4) {
+	memset(static_cast<APUState*>(this), 0, sizeof(APUState));
+	noise.lfsr = 0x7fff;
+	nextSequencer = SEQUENCER_PERIOD;
+	power = false;
+}
+
+uint8_t APU::Read(const uint16_t location) {
+	catchUp();
+
+	const uint8_t index = location - 0xff10;
+
+	// Wave pattern RAM
+	if (location >= 0xff30) {
+		return regs[index];
+	}
+
+	// Sound on/off, with the status of each channel
+	if (location == 0xff26) {
+		return readMasks[index] | (power ? 0x80 : 0)
+			| (square[0].enabled ? 1 : 0) | (square[1].enabled ? 2 : 0)
+			| (wave.enabled ? 4 : 0) | (noise.enabled ? 8 : 0);
+	}
+
+	return regs[index] | readMasks[index];
+}
+
+void APU::Write(const uint16_t location, const uint8_t value) {
+	catchUp();
+
+	const uint8_t index = location - 0xff10;
+
+	// Wave pattern RAM is always writable
+	if (location >= 0xff30) {
+		regs[index] = value;
+		return;
+	}
+
+	if (location == 0xff26) {
+		const bool on = (value & 0x80) != 0;
+		if (power && !on) {
+			powerOff();
+		} else if (!power && on) {
+			sequencerStep = 0;
+		}
+		power = on;
+		updateOutputs(time);
+		return;
+	}
+
+	// Registers are read-only while sound is off
+	if (!power) {
+		return;
+	}
+
+	regs[index] = value;
+
+	switch (location) {
+	case 0xff10: // Sweep (Sound mode #1)
+		square[0].sweepPeriod = (value >> 4) & 7;
+		square[0].sweepNegate = (value & 0x08) != 0;
+		square[0].sweepShift = value & 7;
+		break;
+	case 0xff11: // Sound length / Pattern duty (Sound mode #1)
+	case 0xff16: // Sound length / Pattern duty (Sound mode #2)
+		square[location == 0xff16].duty = value >> 6;
+		square[location == 0xff16].length = 64 - (value & 0x3f);
+		break;
+	case 0xff12: // Control (Sound mode #1)
+	case 0xff17: { // Control (Sound mode #2)
+		SquareChannel& ch = square[location == 0xff17];
+		ch.envelope.initial = value >> 4;
+		ch.envelope.increase = (value & 0x08) != 0;
+		ch.envelope.period = value & 7;
+		ch.dac = (value & 0xf8) != 0;
+		if (!ch.dac) {
+			ch.enabled = false;
+		}
+		break;
+	}
+	case 0xff13: // Frequency low (Sound mode #1)
+	case 0xff18: { // Frequency low (Sound mode #2)
+		SquareChannel& ch = square[location == 0xff18];
+		ch.frequency = (ch.frequency & 0x700) | value;
+		break;
+	}
+	case 0xff14: // Frequency high (Sound mode #1)
+	case 0xff19: { // Frequency high (Sound mode #2)
+		const int channel = location == 0xff19;
+		SquareChannel& ch = square[channel];
+		ch.frequency = (ch.frequency & 0xff) | ((value & 7) << 8);
+		ch.lengthEnabled = (value & 0x40) != 0;
+		if (value & 0x80) {
+			triggerSquare(channel);
+		}
+		break;
+	}
+	case 0xff1a: // Control (Sound mode #3)
+		wave.dac = (value & 0x80) != 0;
+		if (!wave.dac) {
+			wave.enabled = false;
+		}
+		break;
+	case 0xff1b: // Sound length (Sound mode #3)
+		wave.length = 256 - value;
+		break;
+	case 0xff1c: // Output level (Sound mode #3)
+		wave.volumeCode = (value >> 5) & 3;
+		break;
+	case 0xff1d: // Frequency low (Sound mode #3)
+		wave.frequency = (wave.frequency & 0x700) | value;
+		break;
+	case 0xff1e: // Frequency high (Sound mode #3)
+		wave.frequency = (wave.frequency & 0xff) | ((value & 7) << 8);
+		wave.lengthEnabled = (value & 0x40) != 0;
+		if (value & 0x80) {
+			triggerWave();
+		}
+		break;
+	case 0xff20: // Sound length (Sound mode #4)
+		noise.length = 64 - (value & 0x3f);
+		break;
+	case 0xff21: // Control (Sound mode #4)
+		noise.envelope.initial = value >> 4;
+		noise.envelope.increase = (value & 0x08) != 0;
+		noise.envelope.period = value & 7;
+		noise.dac = (value & 0xf8) != 0;
+		if (!noise.dac) {
+			noise.enabled = false;
+		}
+		break;
+	case 0xff22: // Polynomial counter (Sound mode #4)
+		noise.shift = value >> 4;
+		noise.narrow = (value & 0x08) != 0;
+		noise.divisor = value & 7;
+		break;
+	case 0xff23: // Counter/consecutive, initial (Sound mode #4)
+		noise.lengthEnabled = (value & 0x40) != 0;
+		if (value & 0x80) {
+			triggerNoise();
+		}
+		break;
+	}
+
+	// Volume, panning or a channel could have changed
+	updateOutputs(time);
+}
+
+void APU::Flush() {
+	catchUp();
+	endFrame();
+}
+
+size_t APU::Available() const {
+	return left.Available();
+}
+
+size_t APU::ReadSamples(int16_t* out, const size_t frames) {
+	const size_t read = left.ReadSamples(out, frames, 2);
+	right.ReadSamples(out + 1, read, 2);
+	return read;
+}
+
+void APU::catchUp() {
+	while (pending > 0) {
+		const uint64_t chunk = std::min(pending, MAX_FRAME_CLOCKS - time);
+		run(time + chunk);
+		pending -= chunk;
+		if (time >= MAX_FRAME_CLOCKS) {
+			endFrame();
+		}
+	}
+}
+
+void APU::run(const uint64_t until) {
+	while (time < until) {
+		const uint64_t end = std::min(until, nextSequencer);
+
+		if (power) {
+			runSquare(0, end);
+			runSquare(1, end);
+			runWave(end);
+			runNoise(end);
+		}
+		time = end;
+
+		if (time == nextSequencer) {
+			nextSequencer += SEQUENCER_PERIOD;
+			if (power) {
+				clockSequencer();
+				updateOutputs(time);
+			}
+		}
+	}
+}
+
+void APU::endFrame() {
+	left.EndFrame(time);
+	right.EndFrame(time);
+	nextSequencer -= time;
+	time = 0;
+
+	// Rate changes are only safe between frames
+	left.SetRates(CLOCK_RATE, sampleRate * rateAdjust);
+	right.SetRates(CLOCK_RATE, sampleRate * rateAdjust);
+
+	// Nobody is reading, drop the oldest samples to make room for the next frame
+	const size_t frameSamples = (size_t)((uint64_t)MAX_FRAME_CLOCKS * sampleRate / CLOCK_RATE) + 1;
+	const size_t room = left.Capacity() - frameSamples - BlipBuffer::KERNEL_WIDTH;
+	if (left.Available() > room) {
+		const size_t drop = left.Available() - room;
+		left.ReadSamples(nullptr, drop);
+		right.ReadSamples(nullptr, drop);
+	}
+}
+
+void APU::runSquare(const int index, const uint64_t end) {
+	SquareChannel& ch = square[index];
+	if (!ch.enabled) {
+		return;
+	}
+
+	const uint32_t period = (2048 - ch.frequency) * 4;
+	uint64_t t = time;
+	while (t + ch.timer <= end) {
+		t += ch.timer;
+		ch.timer = period;
+		ch.dutyPos = (ch.dutyPos + 1) & 7;
+		updateOutput(index, t);
+	}
+	ch.timer -= (uint32_t)(end - t);
+}
+
+void APU::runWave(const uint64_t end) {
+	if (!wave.enabled) {
+		return;
+	}
+
+	const uint32_t period = (2048 - wave.frequency) * 2;
+	uint64_t t = time;
+	while (t + wave.timer <= end) {
+		t += wave.timer;
+		wave.timer = period;
+		wave.position = (wave.position + 1) & 31;
+		updateOutput(2, t);
+	}
+	wave.timer -= (uint32_t)(end - t);
+}
+
+void APU::runNoise(const uint64_t end) {
+	// Shifts 14 and 15 stop the LFSR
+	if (!noise.enabled || noise.shift >= 14) {
+		return;
+	}
+
+	const uint32_t period = noiseDivisors[noise.divisor] << noise.shift;
+	uint64_t t = time;
+	while (t + noise.timer <= end) {
+		t += noise.timer;
+		noise.timer = period;
+
+		const uint16_t bit = (noise.lfsr ^ (noise.lfsr >> 1)) & 1;
+		noise.lfsr = (noise.lfsr >> 1) | (bit << 14);
+		if (noise.narrow) {
+			noise.lfsr = (noise.lfsr & ~0x40) | (bit << 6);
+		}
+		updateOutput(3, t);
+	}
+	noise.timer -= (uint32_t)(end - t);
+}
+
+void APU::clockSequencer() {
+	switch (sequencerStep) {
+	case 2:
+	case 6:
+		clockSweep();
+		// fallthrough
+	case 0:
+	case 4:
+		clockLength();
+		break;
+	case 7:
+		square[0].envelope.Clock();
+		square[1].envelope.Clock();
+		noise.envelope.Clock();
+		break;
+	}
+	sequencerStep = (sequencerStep + 1) & 7;
+}
+
+void APU::clockLength() {
+	for (SquareChannel& ch : square) {
+		if (ch.lengthEnabled && ch.length > 0 && --ch.length == 0) {
+			ch.enabled = false;
+		}
+	}
+	if (wave.lengthEnabled && wave.length > 0 && --wave.length == 0) {
+		wave.enabled = false;
+	}
+	if (noise.lengthEnabled && noise.length > 0 && --noise.length == 0) {
+		noise.enabled = false;
+	}
+}
+
+void APU::clockSweep() {
+	SquareChannel& ch = square[0];
+	if (ch.sweepTimer == 0 || --ch.sweepTimer > 0) {
+		return;
+	}
+
+	ch.sweepTimer = ch.sweepPeriod > 0 ? ch.sweepPeriod : 8;
+	if (!ch.sweepEnabled || ch.sweepPeriod == 0) {
+		return;
+	}
+
+	const uint16_t frequency = sweepFrequency();
+	if (frequency <= 2047 && ch.sweepShift > 0) {
+		ch.frequency = ch.shadow = frequency;
+		regs[0xff13 - 0xff10] = frequency & 0xff;
+		regs[0xff14 - 0xff10] = (regs[0xff14 - 0xff10] & ~7) | (frequency >> 8);
+		// Overflow check on the new frequency
+		sweepFrequency();
+	}
+}
+
+uint16_t APU::sweepFrequency() {
+	SquareChannel& ch = square[0];
+	const uint16_t change = ch.shadow >> ch.sweepShift;
+	const uint16_t frequency = ch.sweepNegate ? ch.shadow - change : ch.shadow + change;
+	if (frequency > 2047) {
+		ch.enabled = false;
+	}
+	return frequency;
+}
+
+void APU::triggerSquare(const int index) {
+	SquareChannel& ch = square[index];
+	ch.enabled = ch.dac;
+	if (ch.length == 0) {
+		ch.length = 64;
+	}
+	ch.timer = (2048 - ch.frequency) * 4;
+	ch.envelope.Trigger();
+
+	if (index == 0) {
+		ch.shadow = ch.frequency;
+		ch.sweepTimer = ch.sweepPeriod > 0 ? ch.sweepPeriod : 8;
+		ch.sweepEnabled = ch.sweepPeriod > 0 || ch.sweepShift > 0;
+		if (ch.sweepShift > 0) {
+			sweepFrequency();
+		}
+	}
+}
+
+void APU::triggerWave() {
+	wave.enabled = wave.dac;
+	if (wave.length == 0) {
+		wave.length = 256;
+	}
+	wave.timer = (2048 - wave.frequency) * 2;
+	wave.position = 0;
+}
+
+void APU::triggerNoise() {
+	noise.enabled = noise.dac;
+	if (noise.length == 0) {
+		noise.length = 64;
+	}
+	noise.timer = noiseDivisors[noise.divisor] << noise.shift;
+	noise.lfsr = 0x7fff;
+	noise.envelope.Trigger();
+}
+
+void APU::powerOff() {
+	// Every register but the wave RAM is cleared
+	memset(regs, 0, 0xff26 - 0xff10);
+	square[0] = SquareChannel();
+	square[1] = SquareChannel();
+	wave = WaveChannel();
+	noise = NoiseChannel();
+}
+
+uint8_t APU::channelOutput(const int index) const {
+	switch (index) {
+	case 0:
+	case 1: {
+		const SquareChannel& ch = square[index];
+		if (!ch.enabled) {
+			return 0;
+		}
+		return dutyCycles[ch.duty][ch.dutyPos] ? ch.envelope.volume : 0;
+	}
+	case 2: {
+		if (!wave.enabled || wave.volumeCode == 0) {
+			return 0;
+		}
+		const uint8_t packed = regs[0x20 + wave.position / 2];
+		const uint8_t sample = wave.position & 1 ? packed & 0x0f : packed >> 4;
+		return sample >> (wave.volumeCode - 1);
+	}
+	case 3:
+		if (!noise.enabled) {
+			return 0;
+		}
+		return noise.lfsr & 1 ? 0 : noise.envelope.volume;
+	}
+	return 0;
+}
+
+void APU::updateOutput(const int index, const uint64_t at) {
+	const int32_t amplitude = channelOutput(index);
+	const uint8_t volumes = regs[0xff24 - 0xff10];
+	const uint8_t panning = regs[0xff25 - 0xff10];
+
+	// ff25: bits 4-7 send channels to the left output, bits 0-3 to the right
+	const int32_t leftLevel = (panning >> (4 + index)) & 1 ? amplitude * (((volumes >> 4) & 7) + 1) : 0;
+	const int32_t rightLevel = (panning >> index) & 1 ? amplitude * ((volumes & 7) + 1) : 0;
+
+	if (leftLevel != lastLeft[index]) {
+		left.AddDelta(at, (leftLevel - lastLeft[index]) * VOLUME_SCALE);
+		lastLeft[index] = leftLevel;
+	}
+	if (rightLevel != lastRight[index]) {
+		right.AddDelta(at, (rightLevel - lastRight[index]) * VOLUME_SCALE);
+		lastRight[index] = rightLevel;
+	}
+}
+
+void APU::updateOutputs(const uint64_t at) {
+	for (int i = 0; i < AUDIO_CHANNELS; ++i) {
+		updateOutput(i, at);
+	}
+}
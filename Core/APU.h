@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include "BlipBuffer.h"
+
+const int
+	CLOCK_RATE = 4194304,          //!< Gameboy CPU clock (Hz)
+	SEQUENCER_PERIOD = 8192,       //!< Clocks between frame sequencer steps (512 Hz)
+	AUDIO_CHANNELS = 4;            //!< Sound channels (2 square, wave, noise)
+
+//! Volume envelope (square and noise channels)
+struct Envelope {
+	uint8_t initial;               //!< Volume set on trigger
+	uint8_t period;                //!< Sequencer steps between volume changes (0: off)
+	uint8_t timer;                 //!< Sequencer steps until the next change
+	uint8_t volume;                //!< Current volume (0-15)
+	bool    increase;              //!< Increase volume instead of decreasing it
+
+	void Trigger();
+	void Clock();
+};
+
+//! Square channel (#1 with sweep, #2 without)
+struct SquareChannel {
+	bool     enabled;               //!< Channel is playing
+	bool     dac;                   //!< DAC is on (envelope bits non zero)
+	bool     lengthEnabled;         //!< Stop when length reaches 0
+	uint16_t length;                //!< Length counter
+	uint16_t frequency;             //!< 11 bit frequency
+	uint32_t timer;                 //!< Clocks until the next duty step
+	uint8_t  duty;                  //!< Duty cycle (12.5%, 25%, 50%, 75%)
+	uint8_t  dutyPos;               //!< Position in the duty cycle (0-7)
+	Envelope envelope;
+
+	uint8_t  sweepPeriod;           //!< Sequencer steps between sweeps (#1 only)
+	uint8_t  sweepShift;            //!< Frequency change shift (#1 only)
+	bool     sweepNegate;           //!< Sweep decreases frequency (#1 only)
+	bool     sweepEnabled;          //!< Sweep is running (#1 only)
+	uint8_t  sweepTimer;            //!< Sequencer steps until the next sweep (#1 only)
+	uint16_t shadow;                //!< Shadow frequency used by the sweep (#1 only)
+};
+
+//! Wave channel, plays the 32 4-bit samples in ff30-ff3f
+struct WaveChannel {
+	bool     enabled;               //!< Channel is playing
+	bool     dac;                   //!< DAC is on (ff1a bit 7)
+	bool     lengthEnabled;         //!< Stop when length reaches 0
+	uint16_t length;                //!< Length counter
+	uint16_t frequency;             //!< 11 bit frequency
+	uint32_t timer;                 //!< Clocks until the next sample
+	uint8_t  position;              //!< Current sample (0-31)
+	uint8_t  volumeCode;            //!< Output level (mute, 100%, 50%, 25%)
+};
+
+//! Noise channel, outputs the low bit of a LFSR
+struct NoiseChannel {
+	bool     enabled;               //!< Channel is playing
+	bool     dac;                   //!< DAC is on (envelope bits non zero)
+	bool     lengthEnabled;         //!< Stop when length reaches 0
+	uint16_t length;                //!< Length counter
+	uint32_t timer;                 //!< Clocks until the next LFSR shift
+	uint8_t  divisor;               //!< Divisor code (0-7)
+	uint8_t  shift;                 //!< Clock shift
+	bool     narrow;                //!< 7 bit LFSR instead of 15 bit
+	uint16_t lfsr;                  //!< Linear feedback shift register
+	Envelope envelope;
+};
+
+/*! \brief APU state
+ *
+ *  Sound registers, channels and synthesis progress, kept in a plain struct
+ *  so they can be saved and restored with a single copy (see SaveState).
+ */
+struct APUState {
+	uint8_t regs[0x30];            //!< Raw register values (ff10-ff3f)
+	bool power;                    //!< Sound is on (ff26 bit 7)
+
+	SquareChannel square[2];
+	WaveChannel wave;
+	NoiseChannel noise;
+
+	uint8_t sequencerStep;         //!< Frame sequencer step (0-7)
+	uint64_t nextSequencer;        //!< Time of the next frame sequencer step
+
+	uint64_t time;                 //!< Emulated clocks since the start of the frame
+	uint64_t pending;              //!< Clocks to emulate on the next catch up
+
+	int32_t lastLeft[AUDIO_CHANNELS], lastRight[AUDIO_CHANNELS]; //!< Last channel levels
+};
+
+/*! \brief Audio processing unit
+ *
+ *  Emulates the four sound channels, the frame sequencer (length, sweep
+ *  and envelope clocks) and the stereo mixer, and synthesizes the output
+ *  through band-limited step buffers.
+ *
+ *  The APU is run lazily: Step() only accumulates cycles, which are
+ *  emulated when a sound register is accessed or samples are requested.
+ *  Channels are run from one waveform step to the next instead of clock
+ *  by clock.
+ */
+class APU : public APUState {
+private:
+	int sampleRate;
+	double rateAdjust = 1.0;       //!< Output rate multiplier, applied at the next frame
+	BlipBuffer left, right;
+
+	void catchUp();
+	void run(const uint64_t until);
+	void endFrame();
+
+	void runSquare(const int index, const uint64_t end);
+	void runWave(const uint64_t end);
+	void runNoise(const uint64_t end);
+
+	void clockSequencer();
+	void clockLength();
+	void clockSweep();
+	uint16_t sweepFrequency();
+
+	void triggerSquare(const int index);
+	void triggerWave();
+	void triggerNoise();
+	void powerOff();
+
+	uint8_t channelOutput(const int index) const;
+	void updateOutput(const int index, const uint64_t at);
+	void updateOutputs(const uint64_t at);
+
+public:
+	/*! \brief Create the APU
+	 *
+	 *  \param sampleRate Output sample rate (Hz)
+	 */
+	explicit APU(const int sampleRate = 48000);
+
+	/*! \brief Advance the APU clock
+	 *
+	 *  Cycles are only accumulated, they're emulated when needed.
+	 *
+	 *  \param cycles CPU cycles since the last call
+	 */
+	void Step(const uint64_t cycles) { pending += cycles; }
+
+	/*! \brief Read a sound register
+	 *
+	 *  \param location Register address (ff10-ff3f)
+	 *  \return Register value (unused bits read as 1)
+	 */
+	uint8_t Read(const uint16_t location);
+
+	/*! \brief Write a sound register
+	 *
+	 *  \param location Register address (ff10-ff3f)
+	 *  \param value Value to write
+	 */
+	void Write(const uint16_t location, const uint8_t value);
+
+	/*! \brief Emulate all pending cycles
+	 *
+	 *  Catches up and makes all the synthesized samples available.
+	 */
+	void Flush();
+
+	//! Stereo samples ready to be read (after Flush)
+	size_t Available() const;
+
+	/*! \brief Read out synthesized samples
+	 *
+	 *  \param out Interleaved stereo output (left, right, ...)
+	 *  \param frames Max stereo samples to read
+	 *  \return Stereo samples read
+	 */
+	size_t ReadSamples(int16_t* out, const size_t frames);
+
+	//! Output sample rate (Hz)
+	int SampleRate() const { return sampleRate; }
+
+	/*! \brief Stretch the output rate
+	 *
+	 *  Produces sampleRate * ratio samples per emulated second, to match
+	 *  the audio device when the emulation isn't paced by it.
+	 *  The change applies from the next flushed frame.
+	 *
+	 *  \param ratio Rate multiplier (ie. 0.995 - 1.005)
+	 */
+	void SetRateAdjust(const double ratio) { rateAdjust = ratio; }
+};
@@ -0,0 +1,71 @@
+#include "AudioRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+AudioRing::AudioRing(const size_t capacity)
+	: writePos(0), readPos(0), underruns(0), overruns(0) {
+	size_t size = 2;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	buffer.resize(size, 0);
+	mask = size - 1;
+}
+
+size_t AudioRing::Push(const int16_t* samples, const size_t count) {
+	const size_t write = writePos.load(std::memory_order_relaxed);
+	const size_t read = readPos.load(std::memory_order_acquire);
+	const size_t space = buffer.size() - (write - read);
+
+	size_t n = count;
+	if (n > space) {
+		// Keep whole frames
+		n = space & ~(size_t)1;
+		overruns.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Copy in up to two pieces (before and after wrapping)
+	const size_t start = write & mask;
+	const size_t first = std::min(n, buffer.size() - start);
+	memcpy(&buffer[start], samples, first * sizeof(int16_t));
+	memcpy(&buffer[0], samples + first, (n - first) * sizeof(int16_t));
+
+	writePos.store(write + n, std::memory_order_release);
+	return n;
+}
+
+size_t AudioRing::Pop(int16_t* out, const size_t count) {
+	const size_t read = readPos.load(std::memory_order_relaxed);
+	const size_t write = writePos.load(std::memory_order_acquire);
+	const size_t n = std::min(count, write - read) & ~(size_t)1;
+
+	const size_t start = read & mask;
+	const size_t first = std::min(n, buffer.size() - start);
+	memcpy(out, &buffer[start], first * sizeof(int16_t));
+	memcpy(out + first, &buffer[0], (n - first) * sizeof(int16_t));
+
+	readPos.store(read + n, std::memory_order_release);
+
+	if (n >= 2) {
+		lastSample[0] = out[n - 2];
+		lastSample[1] = out[n - 1];
+	}
+
+	if (n < count) {
+		// Hold the last frame instead of clicking to silence
+		for (size_t i = n; i + 1 < count; i += 2) {
+			out[i] = lastSample[0];
+			out[i + 1] = lastSample[1];
+		}
+		underruns.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return n;
+}
+
+size_t AudioRing::Size() const {
+	// Read position first, so it can never be past the write position
+	const size_t read = readPos.load(std::memory_order_acquire);
+	return writePos.load(std::memory_order_acquire) - read;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! \brief Lock-free audio sample ring
+ *
+ *  Single producer (emulation thread) / single consumer (audio callback)
+ *  ring of interleaved samples. Neither side ever blocks: the producer drops
+ *  what doesn't fit (overrun), the consumer pads what's missing with the last
+ *  played sample (underrun). Both cases are counted for the frontend.
+ */
+class AudioRing final {
+private:
+	static const size_t CACHE_LINE = 64;
+
+	std::vector<int16_t> buffer;
+	size_t mask;
+
+	// Each position is only written by one side, keep them on separate cache lines
+	std::atomic<size_t> writePos;
+	char padWrite[CACHE_LINE - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> readPos;
+	char padRead[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+	std::atomic<uint64_t> underruns, overruns;
+	int16_t lastSample[2] = { 0, 0 };  //!< Last played frame (consumer only)
+
+public:
+	/*! \brief Create a ring
+	 *
+	 *  \param capacity Min samples held (rounded up to a power of two)
+	 */
+	explicit AudioRing(const size_t capacity);
+
+	AudioRing(const AudioRing&) = delete;
+	AudioRing& operator=(const AudioRing&) = delete;
+
+	/*! \brief Add samples (producer side)
+	 *
+	 *  \param samples Interleaved stereo samples
+	 *  \param count Samples to add (multiple of 2)
+	 *  \return Samples added, the rest has been dropped
+	 */
+	size_t Push(const int16_t* samples, const size_t count);
+
+	/*! \brief Take samples (consumer side)
+	 *
+	 *  Always fills the whole output, padding it if not enough
+	 *  samples are available.
+	 *
+	 *  \param out Interleaved stereo output
+	 *  \param count Samples to take (multiple of 2)
+	 *  \return Samples actually taken from the ring
+	 */
+	size_t Pop(int16_t* out, const size_t count);
+
+	//! Samples currently queued
+	size_t Size() const;
+
+	//! Max samples that can be queued
+	size_t Capacity() const { return buffer.size(); }
+
+	//! Times the consumer ran out of samples
+	uint64_t Underruns() const { return underruns.load(std::memory_order_relaxed); }
+
+	//! Times the producer had to drop samples
+	uint64_t Overruns() const { return overruns.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,102 @@
+#include "BlipBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Band-limited impulses, one for each sub-sample phase (15 bit fixed point)
+struct BlipKernel {
+	int16_t taps[BlipBuffer::PHASES][BlipBuffer::KERNEL_WIDTH];
+
+	BlipKernel() {
+		const double pi = 3.14159265358979323846;
+		const double cutoff = 0.9; // Fraction of Nyquist kept
+		for (int phase = 0; phase < BlipBuffer::PHASES; ++phase) {
+			const double center = BlipBuffer::KERNEL_WIDTH / 2 + (double)phase / BlipBuffer::PHASES;
+			double values[BlipBuffer::KERNEL_WIDTH];
+			double sum = 0;
+			for (int k = 0; k < BlipBuffer::KERNEL_WIDTH; ++k) {
+				const double x = k - center;
+				const double sinc = x == 0 ? cutoff : std::sin(pi * cutoff * x) / (pi * x);
+				// Blackman window over the kernel width
+				const double w = (x + BlipBuffer::KERNEL_WIDTH / 2) / BlipBuffer::KERNEL_WIDTH;
+				const double window = w <= 0 || w >= 1 ? 0 : 0.42 - 0.5 * std::cos(2 * pi * w) + 0.08 * std::cos(4 * pi * w);
+				values[k] = sinc * window;
+				sum += values[k];
+			}
+
+			// Normalize so every impulse adds up to exactly 1 << 15
+			int total = 0;
+			for (int k = 0; k < BlipBuffer::KERNEL_WIDTH; ++k) {
+				taps[phase][k] = (int16_t)std::lround(values[k] / sum * 32768);
+				total += taps[phase][k];
+			}
+			taps[phase][BlipBuffer::KERNEL_WIDTH / 2] += (int16_t)(32768 - total);
+		}
+	}
+};
+
+static const BlipKernel kernel;
+
+BlipBuffer::BlipBuffer(const double clockRate, const double sampleRate, const size_t _capacity)
+	: deltas(_capacity + KERNEL_WIDTH + 1, 0), capacity(_capacity) {
+	SetRates(clockRate, sampleRate);
+}
+
+void BlipBuffer::SetRates(const double clockRate, const double sampleRate) {
+	factor = (uint64_t)std::llround(sampleRate / clockRate * 4294967296.0);
+}
+
+void BlipBuffer::AddDelta(const uint64_t time, const int32_t delta) {
+	const uint64_t position = offset + time * factor;
+	const size_t index = (size_t)(position >> FRAC_BITS);
+	if (index >= capacity) {
+		// Frame too long for the buffer, drop the step
+		return;
+	}
+
+	const int phase = (int)(position >> (FRAC_BITS - PHASE_BITS)) & (PHASES - 1);
+	const int16_t* taps = kernel.taps[phase];
+	int32_t* out = &deltas[index];
+	for (int k = 0; k < KERNEL_WIDTH; ++k) {
+		out[k] += taps[k] * delta;
+	}
+}
+
+void BlipBuffer::EndFrame(const uint64_t time) {
+	offset += time * factor;
+}
+
+uint64_t BlipBuffer::ClocksNeeded(const size_t samples) const {
+	const uint64_t target = (uint64_t)samples << FRAC_BITS;
+	if (target <= offset) {
+		return 0;
+	}
+	return (target - offset + factor - 1) / factor;
+}
+
+size_t BlipBuffer::Available() const {
+	return std::min((size_t)(offset >> FRAC_BITS), capacity);
+}
+
+size_t BlipBuffer::ReadSamples(int16_t* out, const size_t count, const int step) {
+	const size_t available = Available();
+	const size_t n = std::min(count, available);
+
+	for (size_t i = 0; i < n; ++i) {
+		integrator += deltas[i];
+		int32_t sample = integrator >> 15;
+		// Remove DC slowly (high-pass around 15 Hz at 48 kHz)
+		integrator -= sample << 6;
+		if (out != nullptr) {
+			out[i * step] = (int16_t)std::max(-32768, std::min(32767, sample));
+		}
+	}
+
+	// Move the remaining deltas (including the impulse tails) to the front
+	const size_t remaining = available - n + KERNEL_WIDTH;
+	memmove(deltas.data(), deltas.data() + n, remaining * sizeof(int32_t));
+	std::fill(deltas.begin() + remaining, deltas.end(), 0);
+	offset -= (uint64_t)n << FRAC_BITS;
+	return n;
+}
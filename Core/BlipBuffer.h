@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! \brief Band-limited step buffer
+ *
+ *  Turns amplitude changes (steps) happening at clock precision into
+ *  output samples without aliasing. Each step adds a band-limited impulse
+ *  (windowed sinc, picked among sub-sample phases) to a delta buffer, which
+ *  is integrated when samples are read out.
+ *
+ *  Time is counted in source clocks since the start of the current frame,
+ *  EndFrame() moves the frame forward and makes its samples readable.
+ */
+class BlipBuffer final {
+public:
+	static const int
+		KERNEL_WIDTH = 16,  //!< Taps of the band-limited impulse
+		PHASE_BITS   = 5,   //!< Sub-sample resolution of steps (bits)
+		PHASES       = 1 << PHASE_BITS;
+
+private:
+	static const int FRAC_BITS = 32;  //!< Fractional bits of sample positions
+
+	uint64_t factor;              //!< Samples per clock (fixed point)
+	uint64_t offset = 0;          //!< Start of the current frame (fixed point samples)
+	int32_t integrator = 0;       //!< Running sum of the read deltas
+	std::vector<int32_t> deltas;  //!< Pending deltas (available + KERNEL_WIDTH)
+	size_t capacity;              //!< Max samples that can be buffered
+
+public:
+	/*! \brief Create a buffer
+	 *
+	 *  \param clockRate Source clock rate (Hz)
+	 *  \param sampleRate Output sample rate (Hz)
+	 *  \param capacity Max samples buffered before reading
+	 */
+	BlipBuffer(const double clockRate, const double sampleRate, const size_t capacity);
+
+	/*! \brief Change the clock/sample ratio
+	 *
+	 *  Takes effect from the next step, used for dynamic rate control.
+	 */
+	void SetRates(const double clockRate, const double sampleRate);
+
+	/*! \brief Add an amplitude change
+	 *
+	 *  \param time Clocks since the start of the frame
+	 *  \param delta Amplitude change
+	 */
+	void AddDelta(const uint64_t time, const int32_t delta);
+
+	/*! \brief Ends the current frame
+	 *
+	 *  Makes the samples up to the given time available for reading.
+	 *
+	 *  \param time Length of the frame (clocks)
+	 */
+	void EndFrame(const uint64_t time);
+
+	//! Clocks needed to produce the given amount of samples
+	uint64_t ClocksNeeded(const size_t samples) const;
+
+	//! Samples ready to be read
+	size_t Available() const;
+
+	//! Max samples buffered before reading
+	size_t Capacity() const { return capacity; }
+
+	/*! \brief Read out samples
+	 *
+	 *  \param out Output samples (written every step samples, can be null to discard)
+	 *  \param count Max samples to read
+	 *  \param step Distance between written samples (for interleaving)
+	 *  \return Samples read
+	 */
+	size_t ReadSamples(int16_t* out, const size_t count, const int step = 1);
+};
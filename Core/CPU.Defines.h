@@ -3,8 +3,6 @@
 #include "CPU.h"
 #include <functional>
 
-using CPUHandler = std::function<CycleCount(CPU* cpu, MMU* mmu)>;
-
 enum RID {
 	A, B, C, D, E, H, L
 };
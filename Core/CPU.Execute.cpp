@@ -1,5 +1,6 @@
 #include "CPU.h"
 #include "CPU.Defines.h"
+#include "Trace.h"
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -1527,11 +1528,63 @@ const static CPUHandler handlers[] = {
 	Restart(0x38)        // ff RST 38h
 };
 
+// Report taken calls (the return address was pushed)
+static CPUHandler TraceCall(const CPUHandler handler) {
+	return [handler](CPU* cpu, MMU* mmu) {
+		const uint16_t sp = cpu->SP;
+		const CycleCount c = handler(cpu, mmu);
+		if (cpu->SP != sp) {
+			cpu->callGraph->Enter(cpu->PC, cpu->SP, cpu->cycles.cpu + c.cpu);
+		}
+		return c;
+	};
+}
+
+// Report taken returns (the return address was popped)
+static CPUHandler TraceReturn(const CPUHandler handler) {
+	return [handler](CPU* cpu, MMU* mmu) {
+		const uint16_t sp = cpu->SP;
+		const CycleCount c = handler(cpu, mmu);
+		if (cpu->SP != sp) {
+			cpu->callGraph->Leave(sp, cpu->cycles.cpu + c.cpu);
+		}
+		return c;
+	};
+}
+
+// Same as handlers, calls and returns reporting to the call graph
+static std::vector<CPUHandler> tracingHandlers() {
+	std::vector<CPUHandler> traced(handlers, handlers + 256);
+	const uint8_t calls[] = { 0xc4, 0xcc, 0xcd, 0xd4, 0xdc, 0xc7, 0xcf, 0xd7, 0xdf, 0xe7, 0xef, 0xf7, 0xff };
+	const uint8_t returns[] = { 0xc0, 0xc8, 0xc9, 0xd0, 0xd8, 0xd9 };
+	for (const uint8_t opcode : calls) {
+		traced[opcode] = TraceCall(handlers[opcode]);
+	}
+	for (const uint8_t opcode : returns) {
+		traced[opcode] = TraceReturn(handlers[opcode]);
+	}
+	return traced;
+}
+
 CycleCount CPU::Execute(const uint8_t opcode) {
-	return handlers[opcode](this, mmu);
+	MFEMU_ZONE_FINE("CPU::Execute");
+	return handlerTable[opcode](this, mmu);
+}
+
+void CPU::TraceCalls(CallGraph* graph) {
+	callGraph = graph;
+	if (graph == nullptr) {
+		handlerTable = handlers;
+		return;
+	}
+	static const std::vector<CPUHandler> traced = tracingHandlers();
+	handlerTable = traced.data();
 }
 
 void CPU::handleInterrupt(const uint8_t location) {
 	Push(this, mmu, PC);
 	PC = location;
+	if (callGraph != nullptr) {
+		callGraph->Enter(PC, SP, cycles.cpu);
+	}
 }
@@ -1,11 +1,17 @@
 #include "CPU.h"
 
+#include <cstring>
+
 CycleCount CPU::Step() {
 	uint8_t opcode = mmu->Read(PC);
 	CycleCount c = { 1,4 };
 	if (running) {
+		const uint8_t prefixed = histogram != nullptr && opcode == 0xcb ? mmu->Peek(PC + 1) : 0;
 		PC += 1;
 		c = Execute(opcode);
+		if (histogram != nullptr) {
+			histogram->Count(opcode, prefixed, c.cpu);
+		}
 	}
 	
 	cycles.add(c);
@@ -14,8 +20,14 @@ CycleCount CPU::Step() {
 
 CPU::CPU(MMU* _mmu)
 	: cycles({ 0,0 }) {
+	// Clear all registers (and padding, so saved states are reproducible)
+	memset(static_cast<CPUState*>(this), 0, sizeof(CPUState));
+
 	// Setup variables
 	mmu = _mmu;
+	callGraph = nullptr;
+	histogram = nullptr;
+	TraceCalls(nullptr);
 	running = true;
 	paused = false;
 	PC = 0;
@@ -1,8 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include "SDL.h"
 #include "MMU.h"
+#include "CallGraph.h"
+#include "Histogram.h"
+
+class CPU;
+
+using CPUHandler = std::function<CycleCount(CPU* cpu, MMU* mmu)>;
 
 struct FlagStruct {
 	unsigned int _undef : 4;
@@ -12,14 +19,12 @@ struct FlagStruct {
 	unsigned int Zero : 1;
 };
 
-class CPU {
-private:
-	MMU* mmu;
-
-	void handleInterrupt(const uint8_t location);
-
-public:
-	// Registers
+/*! \brief CPU state
+ *
+ *  Registers of the CPU, kept in a plain struct so they can be saved
+ *  and restored with a single copy (see SaveState).
+ */
+struct CPUState {
 	union {
 		uint16_t Pair;
 		struct {
@@ -66,17 +71,29 @@ public:
 #endif
 	} HL;
 
-	uint16_t SP;    //! Stack Pointer
-	uint16_t PC;    //! Program Counter
+	uint16_t SP;    //!< Stack Pointer
+	uint16_t PC;    //!< Program Counter
+
+	//! Is running? (Not halted)
+	bool running;
+};
+
+class CPU : public CPUState {
+private:
+	MMU* mmu;
+	const CPUHandler* handlerTable; //!< Opcode handlers (plain, or reporting calls)
+
+	void handleInterrupt(const uint8_t location);
+
+public:
+	CallGraph* callGraph;           //!< Receives calls and returns (null if not tracing, see TraceCalls)
+	OpcodeHistogram* histogram;     //!< Counts executed opcodes (null if not counting)
 
 	CycleCount cycles;
 	FlagStruct& Flags() { return AF.Single.Flags.Values; }
 
 	CycleCount Execute(const uint8_t opcode);
 
-	//! Is running? (Not halted)
-	bool running;
-
 	//! Is paused? (Debug)
 	bool paused;
 
@@ -89,5 +106,15 @@ public:
 	//! Handle next incoming interrupt
 	void HandleInterrupts();
 
+	/*! \brief Report calls and returns to a call graph
+	 *
+	 *  Swaps in opcode handlers that tell the graph about CALL, RST, RET and
+	 *  RETI (interrupt entries are reported too). With null, the plain
+	 *  handlers are back and tracing costs nothing.
+	 *
+	 *  \param graph Call graph to feed (null to stop)
+	 */
+	void TraceCalls(CallGraph* graph);
+
 	~CPU();
 };
@@ -0,0 +1,163 @@
+#include "CallGraph.h"
+#include "MBC.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+const uint32_t CallGraph::ROOT;
+
+CallGraph::CallGraph(const MBCState* banking, const uint64_t now) : banking(banking) {
+	Node root;
+	root.function = ROOT;
+	root.parent = -1;
+	root.calls = 1;
+	root.inclusive = root.exclusive = 0;
+	nodes.push_back(root);
+
+	const Frame frame = { 0, 0x10000, now, 0 };
+	stack.push_back(frame);
+}
+
+void CallGraph::pop(std::vector<Node>& nodes, std::vector<Frame>& stack, const uint64_t now) {
+	const Frame frame = stack.back();
+	stack.pop_back();
+
+	const uint64_t elapsed = now - frame.start;
+	Node& node = nodes[frame.node];
+	node.inclusive += elapsed;
+	node.exclusive += elapsed - frame.callees;
+	if (!stack.empty()) {
+		stack.back().callees += elapsed;
+	}
+}
+
+void CallGraph::unwind(const uint16_t sp, const uint64_t now) {
+	while (stack.size() > 1 && stack.back().sp <= sp) {
+		pop(nodes, stack, now);
+	}
+}
+
+void CallGraph::Enter(const uint16_t target, const uint16_t sp, const uint64_t now) {
+	// Frames whose return address was just overwritten are gone
+	unwind(sp, now);
+
+	const uint8_t bank = target >= 0x4000 && target < 0x8000 ? banking->romBankId : 0;
+	const uint32_t function = (bank << 16) | target;
+
+	const int parent = stack.back().node;
+	int child;
+	const auto found = nodes[parent].children.find(function);
+	if (found != nodes[parent].children.end()) {
+		child = found->second;
+	} else {
+		child = (int)nodes.size();
+		Node node;
+		node.function = function;
+		node.parent = parent;
+		node.calls = node.inclusive = node.exclusive = 0;
+		nodes.push_back(node);
+		nodes[parent].children[function] = child;
+	}
+	nodes[child].calls++;
+
+	const Frame frame = { child, sp, now, 0 };
+	stack.push_back(frame);
+}
+
+void CallGraph::Leave(const uint16_t sp, const uint64_t now) {
+	unwind(sp, now);
+}
+
+std::vector<CallGraph::Node> CallGraph::snapshot(const uint64_t now) const {
+	std::vector<Node> closed(nodes);
+	std::vector<Frame> open(stack);
+	while (!open.empty()) {
+		pop(closed, open, now);
+	}
+	return closed;
+}
+
+void CallGraph::writeName(std::ostream& out, const uint32_t function) {
+	if (function == ROOT) {
+		out << "root";
+		return;
+	}
+	const std::ios::fmtflags fmt(out.flags());
+	out << std::hex << std::setfill('0') << std::setw(2) << (function >> 16) << ":" << std::setw(4) << (function & 0xffff);
+	out.flags(fmt);
+}
+
+std::vector<CallGraph::Function> CallGraph::Functions(const uint64_t now) const {
+	const std::vector<Node> closed = snapshot(now);
+
+	std::unordered_map<uint32_t, Function> functions;
+	for (const Node& node : closed) {
+		const auto inserted = functions.insert(std::make_pair(node.function, Function()));
+		Function& function = inserted.first->second;
+		if (inserted.second) {
+			function.bank = (uint8_t)(node.function >> 16);
+			function.address = (uint16_t)node.function;
+			function.calls = function.inclusive = function.exclusive = 0;
+			function.root = node.function == ROOT;
+		}
+		function.calls += node.calls;
+		function.exclusive += node.exclusive;
+
+		// Recursive calls are already part of the outer call's inclusive cycles
+		bool recursive = false;
+		for (int parent = node.parent; parent >= 0 && !recursive; parent = closed[parent].parent) {
+			recursive = closed[parent].function == node.function;
+		}
+		if (!recursive) {
+			function.inclusive += node.inclusive;
+		}
+	}
+
+	std::vector<Function> sorted;
+	sorted.reserve(functions.size());
+	for (const auto& pair : functions) {
+		sorted.push_back(pair.second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Function& a, const Function& b) {
+		return a.inclusive != b.inclusive ? a.inclusive > b.inclusive : a.exclusive > b.exclusive;
+	});
+	return sorted;
+}
+
+void CallGraph::WriteFolded(std::ostream& out, const uint64_t now) const {
+	const std::vector<Node> closed = snapshot(now);
+
+	// Paths are built parent first: nodes are always created after their parent
+	std::vector<std::string> paths(closed.size());
+	for (size_t i = 0; i < closed.size(); ++i) {
+		std::ostringstream name;
+		writeName(name, closed[i].function);
+		paths[i] = closed[i].parent >= 0 ? paths[closed[i].parent] + ";" + name.str() : name.str();
+		if (closed[i].exclusive > 0) {
+			out << paths[i] << " " << closed[i].exclusive << "\n";
+		}
+	}
+}
+
+void CallGraph::Report(std::ostream& out, const size_t count, const uint64_t now) const {
+	const std::vector<Function> functions = Functions(now);
+	const uint64_t total = functions.empty() ? 0 : snapshot(now)[0].inclusive;
+
+	const std::ios::fmtflags fmt(out.flags());
+	out << std::fixed << std::setprecision(2);
+	out << "Call graph: " << total << " cycles, depth " << Depth() << std::endl;
+	out << "Function         Calls       Inclusive       %       Exclusive       %" << std::endl;
+	for (size_t i = 0; i < functions.size() && i < count; ++i) {
+		const Function& function = functions[i];
+		std::ostringstream name;
+		writeName(name, function.root ? ROOT : ((uint32_t)function.bank << 16) | function.address);
+		out << std::left << std::setw(9) << name.str() << std::right
+			<< std::setw(12) << function.calls
+			<< std::setw(16) << function.inclusive << std::setw(8) << (total > 0 ? 100.0 * function.inclusive / total : 0.0)
+			<< std::setw(16) << function.exclusive << std::setw(8) << (total > 0 ? 100.0 * function.exclusive / total : 0.0)
+			<< std::endl;
+	}
+	out.flags(fmt);
+}
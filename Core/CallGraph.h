@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+struct MBCState;
+
+/*! \brief Guest call graph
+ *
+ *  Keeps a shadow of the guest call stack (CALL, RST and interrupt entries
+ *  push a frame, RET and RETI pop it) and charges CPU cycles to every call
+ *  path, to see which guest functions the time goes to, callees included.
+ *
+ *  Games don't always return where they were called from (stack resets,
+ *  return addresses popped or pushed by hand), so frames are matched on the
+ *  stack pointer: a frame is gone once the stack slot of its return address
+ *  is popped or overwritten.
+ *
+ *  Functions are named after their entry point, bank:address (the bank is
+ *  only kept for 4000-7fff), the code running outside of any call is "root".
+ */
+class CallGraph final {
+public:
+	//! Totals for a guest function, over every path it was called from
+	struct Function {
+		uint8_t bank;       //!< ROM bank (0 outside 4000-7fff)
+		uint16_t address;   //!< Entry point
+		uint64_t calls;     //!< Times entered
+		uint64_t inclusive; //!< Cycles in the function and its callees
+		uint64_t exclusive; //!< Cycles in the function itself
+		bool root;          //!< Code running outside of any call (no address)
+	};
+
+private:
+	static const uint32_t ROOT = 0xffffffff; //!< Function id of the code outside any call
+
+	//! Call path (one per distinct stack of functions)
+	struct Node {
+		uint32_t function; //!< bank << 16 | address
+		int parent;
+		uint64_t calls, inclusive, exclusive;
+		std::unordered_map<uint32_t, int> children;
+	};
+
+	//! Shadow stack entry
+	struct Frame {
+		int node;
+		uint32_t sp;       //!< Where the return address is (above the stack for the root)
+		uint64_t start;    //!< Cycle count when entered
+		uint64_t callees;  //!< Cycles spent in the frames it called
+	};
+
+	const MBCState* banking;
+	std::vector<Node> nodes;
+	std::vector<Frame> stack;
+
+	//! Pop the top frame, charging its cycles
+	static void pop(std::vector<Node>& nodes, std::vector<Frame>& stack, const uint64_t now);
+
+	//! Pop the frames whose return address is at or below a stack address
+	void unwind(const uint16_t sp, const uint64_t now);
+
+	//! Call paths with the open frames closed at a cycle count
+	std::vector<Node> snapshot(const uint64_t now) const;
+
+	//! Function name (bank:address)
+	static void writeName(std::ostream& out, const uint32_t function);
+
+public:
+	/*! \brief Create an empty call graph
+	 *
+	 *  \param banking Bank registers of the cartridge (to name banked functions)
+	 *  \param now CPU cycle count to start from
+	 */
+	CallGraph(const MBCState* banking, const uint64_t now);
+
+	/*! \brief A call was made
+	 *
+	 *  \param target Called address
+	 *  \param sp Stack pointer after pushing the return address
+	 *  \param now CPU cycle count after the call
+	 */
+	void Enter(const uint16_t target, const uint16_t sp, const uint64_t now);
+
+	/*! \brief A return was made
+	 *
+	 *  \param sp Stack pointer before popping the return address
+	 *  \param now CPU cycle count after the return
+	 */
+	void Leave(const uint16_t sp, const uint64_t now);
+
+	//! Current call depth
+	size_t Depth() const { return stack.size() - 1; }
+
+	//! Every function called so far, most inclusive cycles first
+	std::vector<Function> Functions(const uint64_t now) const;
+
+	/*! \brief Write folded stacks
+	 *
+	 *  One line per call path, "root;caller;callee cycles" with the cycles
+	 *  spent in the last function, as read by flamegraph.pl and speedscope.
+	 *
+	 *  \param out Stream to write to
+	 *  \param now Current CPU cycle count
+	 */
+	void WriteFolded(std::ostream& out, const uint64_t now) const;
+
+	/*! \brief Print the most expensive functions
+	 *
+	 *  \param out Stream to print to
+	 *  \param count Functions to list
+	 *  \param now Current CPU cycle count
+	 */
+	void Report(std::ostream& out, const size_t count, const uint64_t now) const;
+};
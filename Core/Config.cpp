@@ -4,7 +4,7 @@
 #include <cstring>
 #include <iostream>
 
-static std::unordered_map<std::string, Button> nameToButton = {
+static const std::unordered_map<std::string, Button> nameToButton = {
 	{ "A",      ButtonA      },
 	{ "B",      ButtonB      },
 	{ "Up",     ButtonUp     },
@@ -15,19 +15,27 @@ static std::unordered_map<std::string, Button> nameToButton = {
 	{ "Select", ButtonSelect }
 };
 
+static const std::unordered_map<std::string, RenderMode> nameToRenderMode = {
+	{ "scanline", Render_Scanline },
+	{ "fifo",     Render_FIFO     },
+	{ "auto",     Render_Auto     }
+};
+
 const std::string Config::DEFAULT_FILE = "mfemu.conf";
 
-std::unordered_map<Button, SDL_Scancode> Config::keybindings = {
-	// Default configuration
-	{ ButtonB,      SDL_SCANCODE_Z         },
-	{ ButtonA,      SDL_SCANCODE_X         },
-	{ ButtonStart,  SDL_SCANCODE_RETURN    },
-	{ ButtonSelect, SDL_SCANCODE_BACKSPACE },
-	{ ButtonUp,     SDL_SCANCODE_UP        },
-	{ ButtonDown,   SDL_SCANCODE_DOWN      },
-	{ ButtonLeft,   SDL_SCANCODE_LEFT      },
-	{ ButtonRight,  SDL_SCANCODE_RIGHT     }
-};
+Config::Config()
+	: keybindings({
+		// Default configuration
+		{ ButtonB,      SDL_SCANCODE_Z         },
+		{ ButtonA,      SDL_SCANCODE_X         },
+		{ ButtonStart,  SDL_SCANCODE_RETURN    },
+		{ ButtonSelect, SDL_SCANCODE_BACKSPACE },
+		{ ButtonUp,     SDL_SCANCODE_UP        },
+		{ ButtonDown,   SDL_SCANCODE_DOWN      },
+		{ ButtonLeft,   SDL_SCANCODE_LEFT      },
+		{ ButtonRight,  SDL_SCANCODE_RIGHT     }
+	})
+	, renderMode(Render_Scanline) {}
 
 bool Config::LoadFromFile(const std::string& fname) {
 	std::ifstream confFile(fname);
@@ -49,7 +57,7 @@ bool Config::LoadFromFile(const std::string& fname) {
 	return true;	
 }
 
-SDL_Scancode Config::Binding(const Button b) {
+SDL_Scancode Config::Binding(const Button b) const {
 	auto code = keybindings.find(b);
 	if (code != keybindings.end())
 		return code->second;
@@ -57,6 +65,13 @@ SDL_Scancode Config::Binding(const Button b) {
 	return SDL_SCANCODE_UNKNOWN;
 }
 
+RenderMode Config::Renderer(const uint16_t checksum) const {
+	if (fifoROMs.find(checksum) != fifoROMs.end())
+		return Render_FIFO;
+
+	return renderMode;
+}
+
 void Config::parseLine(const uint32_t lineno, const std::string& line) {
 	std::istringstream ss(line);
 	std::string cmd;
@@ -82,5 +97,24 @@ void Config::parseLine(const uint32_t lineno, const std::string& line) {
 			std::clog << "[INFO] Bound " << it->first << " to "
 				<< SDL_GetScancodeName(keybindings[it->second]) << "\r\n";
 		}	
+	} else if (cmd == "ppu.mode") {
+		std::string name;
+		ss >> name; // eat '='
+		ss >> name;
+		auto it = nameToRenderMode.find(name);
+		if (it == nameToRenderMode.end()) {
+			std::cerr << errPrelude.str() << "Unknown PPU mode: " << name << std::endl;
+		} else {
+			renderMode = it->second;
+		}
+	} else if (cmd == "ppu.fifo") {
+		std::string value;
+		ss >> value; // eat '='
+		uint16_t checksum;
+		if (ss >> std::hex >> checksum) {
+			fifoROMs.insert(checksum);
+		} else {
+			std::cerr << errPrelude.str() << "Invalid ROM checksum" << std::endl;
+		}
 	}
 }
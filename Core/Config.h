@@ -2,23 +2,30 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <cstdint>
 #include "SDL.h"
 #include "Input.h"
+#include "GPU.h"
 
 /*! \class Configuration for mfemu.
  *
  * On startup, mfemu can optionally load a conf file containing options like
  * keybindings etc. By default, this is mfemu.conf.
+ *
+ * Each emulator gets its own copy of the configuration, so instances with
+ * different settings can run side by side.
  */
 class Config final {
 private:
-	static std::unordered_map<Button, SDL_Scancode> keybindings; 
-	static void parseLine(const uint32_t lineno, const std::string& line);
+	std::unordered_map<Button, SDL_Scancode> keybindings; 
+	RenderMode renderMode;
+	std::unordered_set<uint16_t> fifoROMs;
+	void parseLine(const uint32_t lineno, const std::string& line);
 
 public:
-	Config() = delete;
-	Config(const Config&) = delete;
+	//! Default configuration
+	Config();
 	
 	const static std::string DEFAULT_FILE;
 
@@ -27,7 +34,14 @@ public:
 	 * Tries to load Config from fname. Returns false if the config wasn't
 	 * properly loaded.
 	 */
-	static bool LoadFromFile(const std::string& fname);
+	bool LoadFromFile(const std::string& fname);
+
+	SDL_Scancode Binding(const Button b) const;
 
-	static SDL_Scancode Binding(const Button b);
+	/*! \brief Gets the scanline renderer to use for a ROM
+	 *
+	 * ROMs listed with ppu.fifo (by global checksum) always use the pixel FIFO,
+	 * every other ROM uses the renderer set with ppu.mode.
+	 */
+	RenderMode Renderer(const uint16_t checksum) const;
 };
@@ -0,0 +1,270 @@
+#include "ControlServer.h"
+#include "Emulator.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+const uint32_t ControlServer::MAX_PAYLOAD;
+
+//! Queued reply bytes over which a client's next commands wait
+static const size_t OUTPUT_LIMIT = 1024 * 1024;
+
+// Queue a reply
+static void reply(std::vector<uint8_t>& output, const ControlStatus status, const void* data, const size_t size) {
+	ControlHeader header;
+	memset(&header, 0, sizeof(header));
+	header.code = status;
+	header.size = (uint32_t)size;
+
+	const size_t offset = output.size();
+	output.resize(offset + sizeof(header) + size);
+	memcpy(output.data() + offset, &header, sizeof(header));
+	if (size > 0) {
+		memcpy(output.data() + offset + sizeof(header), data, size);
+	}
+}
+
+static void replyError(std::vector<uint8_t>& output, const std::string& message) {
+	reply(output, Control_Error, message.data(), message.size());
+}
+
+void ControlServer::execute(Emulator& emulator, const ControlHeader& header, const uint8_t* payload, std::vector<uint8_t>& output) {
+	switch (header.code) {
+	case Control_LoadState:
+		try {
+			SaveState::Load(emulator, payload, header.size);
+			reply(output, Control_Ok, nullptr, 0);
+		} catch (const std::exception& error) {
+			replyError(output, error.what());
+		}
+		break;
+	case Control_SaveState: {
+		std::vector<uint8_t> state;
+		SaveState::Save(emulator, state);
+		reply(output, Control_Ok, state.data(), state.size());
+		break;
+	}
+	case Control_SetInput:
+		if (header.size != 1) {
+			replyError(output, "SetInput expects 1 byte");
+			break;
+		}
+		emulator.input.QueueButtons(payload[0]);
+		reply(output, Control_Ok, nullptr, 0);
+		break;
+	case Control_Run: {
+		uint32_t frames;
+		if (header.size != sizeof(frames)) {
+			replyError(output, "Run expects a 32 bit frame count");
+			break;
+		}
+		memcpy(&frames, payload, sizeof(frames));
+		for (uint32_t i = 0; i < frames && emulator.running; ++i) {
+			emulator.RunFrame();
+		}
+		const uint64_t frame = emulator.FrameCount();
+		reply(output, Control_Ok, &frame, sizeof(frame));
+		break;
+	}
+	case Control_Read: {
+		uint16_t range[2];
+		if (header.size != sizeof(range)) {
+			replyError(output, "Read expects a 16 bit address and size");
+			break;
+		}
+		memcpy(range, payload, sizeof(range));
+		std::vector<uint8_t> bytes(range[1]);
+		for (size_t i = 0; i < bytes.size(); ++i) {
+			bytes[i] = emulator.mmu.Peek((uint16_t)(range[0] + i));
+		}
+		reply(output, Control_Ok, bytes.data(), bytes.size());
+		break;
+	}
+	case Control_Hash: {
+		const uint64_t hash = HashBytes(emulator.gpu.screen, sizeof(emulator.gpu.screen));
+		reply(output, Control_Ok, &hash, sizeof(hash));
+		break;
+	}
+	case Control_StateHash: {
+		std::vector<ChunkHash> chunks;
+		const uint64_t hash = SaveState::Hash(emulator, chunks);
+		reply(output, Control_Ok, &hash, sizeof(hash));
+		break;
+	}
+	case Control_Quit:
+		stopping = true;
+		reply(output, Control_Ok, nullptr, 0);
+		break;
+	default:
+		replyError(output, "Unknown command");
+		break;
+	}
+}
+
+int ControlServer::handle(Emulator& emulator, Client& client) {
+	int handled = 0;
+	size_t offset = 0;
+	while (client.input.size() - offset >= sizeof(ControlHeader) && client.output.size() < OUTPUT_LIMIT && !stopping) {
+		ControlHeader header;
+		memcpy(&header, client.input.data() + offset, sizeof(header));
+		if (header.size > MAX_PAYLOAD) {
+			return -1;
+		}
+		if (client.input.size() - offset - sizeof(header) < header.size) {
+			break;
+		}
+
+		// Bad addresses, cartridge errors...: fail the command, not the emulator
+		const size_t replied = client.output.size();
+		try {
+			execute(emulator, header, client.input.data() + offset + sizeof(header), client.output);
+		} catch (const std::exception& error) {
+			client.output.resize(replied);
+			replyError(client.output, error.what());
+		}
+		offset += sizeof(header) + header.size;
+		handled++;
+	}
+	client.input.erase(client.input.begin(), client.input.begin() + offset);
+	return handled;
+}
+
+#ifdef _WIN32
+
+ControlServer::ControlServer(const std::string& path) : path(path), listener(-1) {
+	throw std::runtime_error("The control socket is only available on POSIX systems");
+}
+
+ControlServer::~ControlServer() {}
+
+bool ControlServer::flush(Client&) { return false; }
+
+void ControlServer::Serve(Emulator&) {}
+
+#else
+
+ControlServer::ControlServer(const std::string& path) : path(path) {
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("Control socket path too long: " + path);
+	}
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		throw std::runtime_error("Could not create control socket");
+	}
+	unlink(path.c_str());
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+		close(listener);
+		throw std::runtime_error("Could not listen on control socket: " + path);
+	}
+}
+
+ControlServer::~ControlServer() {
+	for (const Client& client : clients) {
+		close(client.socket);
+	}
+	close(listener);
+	unlink(path.c_str());
+}
+
+bool ControlServer::flush(Client& client) {
+	size_t sent = 0;
+	while (sent < client.output.size()) {
+		const ssize_t written = send(client.socket, client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL);
+		if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (written <= 0) {
+			return false;
+		}
+		sent += written;
+	}
+	client.output.erase(client.output.begin(), client.output.begin() + sent);
+	return true;
+}
+
+void ControlServer::Serve(Emulator& emulator) {
+	std::vector<pollfd> polled;
+	uint8_t buffer[64 * 1024];
+
+	while (!stopping) {
+		// Clients with replies still queued are only waited on to take them
+		polled.clear();
+		polled.push_back({ listener, POLLIN, 0 });
+		for (const Client& client : clients) {
+			polled.push_back({ client.socket, (short)(client.output.empty() ? POLLIN : POLLOUT), 0 });
+		}
+		if (poll(polled.data(), polled.size(), -1) < 0) {
+			continue;
+		}
+
+		if (polled[0].revents & POLLIN) {
+			const int connection = accept(listener, nullptr, nullptr);
+			if (connection >= 0) {
+				fcntl(connection, F_SETFL, fcntl(connection, F_GETFL) | O_NONBLOCK);
+				clients.push_back({ connection, {}, {} });
+			}
+		}
+
+		for (size_t i = 1; i < polled.size() && !stopping; ++i) {
+			if (polled[i].revents == 0) {
+				continue;
+			}
+			Client& client = clients[i - 1];
+			bool alive = true;
+
+			// Take everything that arrived
+			if (polled[i].events == POLLIN) {
+				const ssize_t received = recv(client.socket, buffer, sizeof(buffer), 0);
+				if (received > 0) {
+					client.input.insert(client.input.end(), buffer, buffer + received);
+				} else {
+					alive = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+				}
+			} else if (polled[i].revents & (POLLERR | POLLHUP)) {
+				alive = false;
+			}
+
+			// Handle it, then send the replies at once, until the client stops taking them
+			while (alive) {
+				const int handled = handle(emulator, client);
+				alive = handled >= 0 && flush(client);
+				if (handled <= 0 || !client.output.empty()) {
+					break;
+				}
+			}
+
+			if (!alive) {
+				close(client.socket);
+				client.socket = -1;
+			}
+		}
+
+		// Forget disconnected clients
+		for (size_t i = clients.size(); i-- > 0;) {
+			if (clients[i].socket < 0) {
+				clients.erase(clients.begin() + i);
+			}
+		}
+	}
+}
+
+#endif
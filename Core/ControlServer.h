@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Emulator;
+
+//! Control commands (see ControlServer)
+enum ControlCommand : uint8_t {
+	Control_LoadState = 1, //!< Payload: save state         Reply: nothing
+	Control_SaveState = 2, //!< Payload: nothing            Reply: save state
+	Control_SetInput  = 3, //!< Payload: u8 buttons         Reply: nothing
+	Control_Run       = 4, //!< Payload: u32 frames         Reply: u64 frame count
+	Control_Read      = 5, //!< Payload: u16 address, u16 size   Reply: memory bytes (see MMU::Peek)
+	Control_Hash      = 6, //!< Payload: nothing            Reply: u64 frame hash (last complete frame)
+	Control_Quit      = 7, //!< Payload: nothing            Reply: nothing, then the server stops
+	Control_StateHash = 8  //!< Payload: nothing            Reply: u64 machine state hash
+};
+
+//! Reply status
+enum ControlStatus : uint8_t {
+	Control_Ok    = 0, //!< Command done, payload is the reply
+	Control_Error = 1  //!< Command failed, payload is an error message
+};
+
+/*! \brief Message header
+ *
+ *  Every command and reply is a header followed by size bytes of payload.
+ *  Integers are in the host byte order (clients are on the same host).
+ *  Commands over ControlServer::MAX_PAYLOAD bytes get the client dropped.
+ */
+struct ControlHeader {
+	uint8_t code;     //!< ControlCommand (commands) or ControlStatus (replies)
+	uint8_t reserved[3];
+	uint32_t size;    //!< Payload size
+};
+
+/*! \brief Local control socket
+ *
+ *  Lets another process drive a headless emulator over a Unix domain socket:
+ *  load/save states, set the buttons, run frames, read memory and hash the
+ *  machine state, one reply per command, in order.
+ *
+ *  Everything runs on the emulation thread, between frames. All the commands
+ *  a client sent are handled in one go and their replies sent back together,
+ *  so a client can pipeline a whole step (input, run, reads) in one write.
+ *
+ *  Sockets are non-blocking: replies a client doesn't read yet stay queued,
+ *  and its next commands wait until they're sent, without holding up the
+ *  other clients. A command that fails gets a Control_Error reply.
+ */
+class ControlServer final {
+public:
+	static const uint32_t MAX_PAYLOAD = 16 * 1024 * 1024; //!< Largest command payload accepted
+
+private:
+	//! Connected client
+	struct Client {
+		int socket;
+		std::vector<uint8_t> input;  //!< Received, not handled yet
+		std::vector<uint8_t> output; //!< Replies waiting to be sent
+	};
+
+	std::string path;
+	int listener;
+	std::vector<Client> clients;
+	bool stopping = false;
+
+	/*! \brief Handle the complete commands a client sent
+	 *
+	 *  Stops early once enough replies are queued.
+	 *
+	 *  \return Commands handled, -1 if the client sent an invalid header
+	 */
+	int handle(Emulator& emulator, Client& client);
+
+	//! Send the queued replies a client can take right now, false if the connection is gone
+	bool flush(Client& client);
+
+	//! Run one command, and queue its reply
+	void execute(Emulator& emulator, const ControlHeader& header, const uint8_t* payload, std::vector<uint8_t>& output);
+
+public:
+	/*! \brief Listen on a socket
+	 *
+	 *  Throws std::runtime_error if the socket can't be created.
+	 *
+	 *  \param path Socket file (replaced if it exists)
+	 */
+	explicit ControlServer(const std::string& path);
+
+	//! Close every connection and remove the socket file
+	~ControlServer();
+
+	ControlServer(const ControlServer&) = delete;
+	ControlServer& operator=(const ControlServer&) = delete;
+
+	/*! \brief Serve clients
+	 *
+	 *  The emulator only runs when told to. Returns on Control_Quit.
+	 *
+	 *  \param emulator Emulator to drive (already started)
+	 */
+	void Serve(Emulator& emulator);
+};
@@ -0,0 +1,136 @@
+#include "Counters.h"
+
+#include <cstring>
+#include <iomanip>
+
+static const char* const regionNames[Region_Count] = {
+	"ROM0", "ROMX", "VRAM", "ExtRAM", "WRAM0", "WRAMX", "Echo", "OAM", "Unusable", "IO", "HRAM", "IE"
+};
+
+static const char* const subsystemNames[Subsystem_Count] = {
+	"CPU", "PPU", "APU", "Timers", "Frontend"
+};
+
+static const char* const interruptNames[5] = {
+	"VBlank", "LCDcnt", "Timer", "Serial", "Input"
+};
+
+void PerfCounters::Reset() {
+	instructions = cycles = haltCycles = frames = bankSwitches = 0;
+	memset(reads, 0, sizeof(reads));
+	memset(writes, 0, sizeof(writes));
+	memset(interrupts, 0, sizeof(interrupts));
+	memset(ticks, 0, sizeof(ticks));
+}
+
+PerfCounters PerfCounters::Since(const PerfCounters& before) const {
+	PerfCounters delta;
+	delta.timing = timing;
+	delta.instructions = instructions - before.instructions;
+	delta.cycles = cycles - before.cycles;
+	delta.haltCycles = haltCycles - before.haltCycles;
+	delta.frames = frames - before.frames;
+	delta.bankSwitches = bankSwitches - before.bankSwitches;
+	for (int i = 0; i < Region_Count; ++i) {
+		delta.reads[i] = reads[i] - before.reads[i];
+		delta.writes[i] = writes[i] - before.writes[i];
+	}
+	for (int i = 0; i < 5; ++i) {
+		delta.interrupts[i] = interrupts[i] - before.interrupts[i];
+	}
+	for (int i = 0; i < Subsystem_Count; ++i) {
+		delta.ticks[i] = ticks[i] - before.ticks[i];
+	}
+	return delta;
+}
+
+uint64_t PerfCounters::Accesses() const {
+	uint64_t total = 0;
+	for (int i = 0; i < Region_Count; ++i) {
+		total += reads[i] + writes[i];
+	}
+	return total;
+}
+
+uint64_t PerfCounters::Interrupts() const {
+	uint64_t total = 0;
+	for (int i = 0; i < 5; ++i) {
+		total += interrupts[i];
+	}
+	return total;
+}
+
+// Share of a total, in percent
+static double percent(const uint64_t part, const uint64_t total) {
+	return total > 0 ? 100.0 * part / total : 0.0;
+}
+
+void PerfCounters::Print(std::ostream& out) const {
+	const std::ios::fmtflags fmt(out.flags());
+	out << std::fixed << std::setprecision(1);
+
+	out << "Frames: " << frames << "    Instructions: " << instructions
+		<< "    Cycles: " << cycles << " (" << percent(haltCycles, cycles) << "% halted)" << std::endl;
+	if (frames > 0) {
+		out << "Per frame: " << instructions / frames << " instructions, "
+			<< Accesses() / frames << " memory accesses" << std::endl;
+	}
+
+	out << "Region      Reads          Writes" << std::endl;
+	for (int i = 0; i < Region_Count; ++i) {
+		out << std::left << std::setw(10) << regionNames[i] << std::right
+			<< std::setw(14) << reads[i] << " " << std::setw(14) << writes[i] << std::endl;
+	}
+
+	out << "Bank switches: " << bankSwitches << std::endl;
+	out << "Interrupts:";
+	for (int i = 0; i < 5; ++i) {
+		out << " " << interruptNames[i] << "=" << interrupts[i];
+	}
+	out << std::endl;
+
+	uint64_t total = 0;
+	for (int i = 0; i < Subsystem_Count; ++i) {
+		total += ticks[i];
+	}
+	if (total == 0) {
+		out << "Subsystem timing is " << (timing ? "on, nothing timed yet" : "off") << std::endl;
+	} else {
+		out << "Time:";
+		for (int i = 0; i < Subsystem_Count; ++i) {
+			out << " " << subsystemNames[i] << "=" << percent(ticks[i], total) << "%";
+		}
+		out << " (" << total << " ticks)" << std::endl;
+	}
+	out.flags(fmt);
+}
+
+void PerfCounters::PrintLine(std::ostream& out) const {
+	const std::ios::fmtflags fmt(out.flags());
+	out << std::fixed << std::setprecision(1);
+
+	out << frames << " frames, " << instructions << " instr, "
+		<< cycles << " cycles (" << percent(haltCycles, cycles) << "% halted), "
+		<< "mem " << Accesses() << " (io " << reads[Region_IO] + writes[Region_IO] << "), "
+		<< "banks " << bankSwitches << ", ints " << Interrupts();
+
+	uint64_t total = 0;
+	for (int i = 0; i < Subsystem_Count; ++i) {
+		total += ticks[i];
+	}
+	if (total > 0) {
+		out << ",";
+		for (int i = 0; i < Subsystem_Count; ++i) {
+			out << " " << subsystemNames[i] << " " << percent(ticks[i], total) << "%";
+		}
+	}
+	out.flags(fmt);
+}
+
+const char* PerfCounters::RegionName(const MemoryRegion region) {
+	return region < Region_Count ? regionNames[region] : "?";
+}
+
+const char* PerfCounters::SubsystemName(const Subsystem subsystem) {
+	return subsystem < Subsystem_Count ? subsystemNames[subsystem] : "?";
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MFEMU_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MFEMU_RDTSC 1
+#endif
+
+//! Memory regions, as seen by the MMU
+enum MemoryRegion : uint8_t {
+	Region_ROM0     = 0,  //!< 0000 - 3fff (and the boot rom)
+	Region_ROMX     = 1,  //!< 4000 - 7fff
+	Region_VRAM     = 2,  //!< 8000 - 9fff
+	Region_ExtRAM   = 3,  //!< a000 - bfff
+	Region_WRAM0    = 4,  //!< c000 - cfff
+	Region_WRAMX    = 5,  //!< d000 - dfff
+	Region_Echo     = 6,  //!< e000 - fdff
+	Region_OAM      = 7,  //!< fe00 - fe9f
+	Region_Unusable = 8,  //!< fea0 - feff
+	Region_IO       = 9,  //!< ff00 - ff7f
+	Region_HRAM     = 10, //!< ff80 - fffe
+	Region_IE       = 11, //!< ffff
+	Region_Count    = 12
+};
+
+//! Timed parts of the emulator
+enum Subsystem : uint8_t {
+	Subsystem_CPU      = 0, //!< Fetching and executing instructions
+	Subsystem_PPU      = 1, //!< GPU stepping and rendering
+	Subsystem_APU      = 2, //!< Sound synthesis
+	Subsystem_Timers   = 3, //!< Divider and controllable timer
+	Subsystem_Frontend = 4, //!< Per frame work (audio, input, recording, window, events)
+	Subsystem_Count    = 5
+};
+
+/*! \brief Performance counters
+ *
+ *  Cheap running totals kept by the core while it runs, to see where the time
+ *  goes without attaching a profiler. Counting is always on, timing only when
+ *  enabled. Reading the timestamp counter costs about as much as emulating a
+ *  step, so steps are timed one in ~32 (at random, so loops don't alias with
+ *  the sampling) and each sample is weighted by the steps it stands for.
+ *
+ *  They are not part of the machine state: loading a state doesn't touch
+ *  them and forks start from zero.
+ */
+struct PerfCounters {
+	uint64_t instructions;            //!< Instructions executed
+	uint64_t cycles;                  //!< CPU cycles, halted ones included
+	uint64_t haltCycles;              //!< CPU cycles spent halted
+	uint64_t frames;                  //!< Frames completed
+	uint64_t reads[Region_Count];     //!< MMU reads per region
+	uint64_t writes[Region_Count];    //!< MMU writes per region
+	uint64_t bankSwitches;            //!< Cartridge ROM/RAM bank changes
+	uint64_t interrupts[5];           //!< Interrupts serviced (per InterruptType)
+	uint64_t ticks[Subsystem_Count];  //!< Time per subsystem (timestamp counter ticks)
+
+	bool timing;                      //!< Time subsystems (costs a few % of speed)
+
+	PerfCounters() : timing(false), interval(1), countdown(1), seed(0x9e3779b9) { Reset(); }
+
+	//! Zero every counter (keeps timing on or off)
+	void Reset();
+
+	//! Counters accumulated since an earlier copy
+	PerfCounters Since(const PerfCounters& before) const;
+
+	//! Total reads and writes, all regions
+	uint64_t Accesses() const;
+
+	//! Total interrupts serviced
+	uint64_t Interrupts() const;
+
+	//! Print every counter, one group per line
+	void Print(std::ostream& out) const;
+
+	//! Print the most useful counters on a single line
+	void PrintLine(std::ostream& out) const;
+
+	/*! \brief Should the coming step be timed?
+	 *
+	 *  \param weight Steps the sample stands for (to pass to Lap)
+	 *  \return true one step in ~32 when timing
+	 */
+	bool SampleStep(uint32_t& weight) {
+		if (!timing || --countdown != 0) {
+			return false;
+		}
+		weight = interval;
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		interval = countdown = 16 + (seed & 31);
+		return true;
+	}
+
+	//! Charge the time since a timestamp to a subsystem, return the current timestamp
+	uint64_t Lap(const Subsystem subsystem, const uint64_t since, const uint32_t weight = 1) {
+		const uint64_t now = ReadTicks();
+		ticks[subsystem] += (now - since) * weight;
+		return now;
+	}
+
+	/*! \brief Read the timestamp counter
+	 *
+	 *  rdtsc on x86 (constant rate on anything recent), a monotonic clock
+	 *  in nanoseconds elsewhere. Only meaningful as differences.
+	 */
+	static uint64_t ReadTicks() {
+#ifdef MFEMU_RDTSC
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	//! Region name
+	static const char* RegionName(const MemoryRegion region);
+
+	//! Subsystem name
+	static const char* SubsystemName(const Subsystem subsystem);
+
+private:
+	uint32_t interval;  //!< Steps between the last sample and the next one
+	uint32_t countdown; //!< Steps left until the next sample
+	uint32_t seed;      //!< Sampling jitter (xorshift)
+};
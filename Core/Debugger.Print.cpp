@@ -2,6 +2,7 @@
 #include "CPU.Defines.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <string>
 
 enum DebugRegisterType {
@@ -51,50 +52,57 @@ static inline std::string getJumpConditionName(const JumpCondition condition) {
 	}
 }
 
-static void debugPrintArgument(std::ostream &out, CPU*, MMU*, const uint16_t) {
+static void debugPrintArgument(std::ostream &out, CPU*, const Debug::CodeReader&, const uint16_t) {
 	out << "\r\n";
 }
 
 template<typename... Args>
-static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint16_t addr, const DebugRegisterType type, const RID registerId, const Args... args) {
+static void debugPrintArgument(std::ostream &out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr, const DebugRegisterType type, const RID registerId, const Args... args) {
 	std::string registerName = getRegisterName(registerId);
 	if (type == Indirect) {
 		registerName = "(" + registerName + ")";
 	}
 	out << " " << registerName;
-	debugPrintArgument(out, cpu, mmu, addr, args...);
+	debugPrintArgument(out, cpu, read, addr, args...);
 }
 
 template<typename... Args>
-static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint16_t addr, const DebugRegisterType type, const PID pairId, const Args... args) {
+static void debugPrintArgument(std::ostream &out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr, const DebugRegisterType type, const PID pairId, const Args... args) {
 	std::string pairName = getPairName(pairId);
 	if (type == Indirect) {
 		pairName = "(" + pairName + ")";
 	}
 	out << " " << pairName;
-	debugPrintArgument(out, cpu, mmu, addr, args...);
+	debugPrintArgument(out, cpu, read, addr, args...);
 }
 
 template<typename... Args>
-static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint16_t addr, const DebugFlags flag, const Args... args) {
+static void debugPrintArgument(std::ostream &out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr, const DebugFlags flag, const Args... args) {
 	switch (flag) {
 	case Comma: out << ","; break;
 	case IndStart: out << " ("; break;
 	case IndFinish: out << " )"; break;
 	}
-	debugPrintArgument(out, cpu, mmu, addr, args...);
+	debugPrintArgument(out, cpu, read, addr, args...);
 }
 
 template<typename... Args>
-static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint16_t addr, const JumpCondition condition, const Args... args) {
+static void debugPrintArgument(std::ostream &out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr, const JumpCondition condition, const Args... args) {
 	out << getJumpConditionName(condition);
-	debugPrintArgument(out, cpu, mmu, addr, args...);
+	debugPrintArgument(out, cpu, read, addr, args...);
 }
 
 template<typename... Args>
-static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint16_t addr, const DebugIntType type, const int data, const Args... args) {
-	uint8_t  low = mmu->Read(addr + (uint16_t) data);
-	uint8_t  high = mmu->Read(addr + (uint16_t) data + 1);
+static void debugPrintArgument(std::ostream &out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr, const DebugIntType type, const int data, const Args... args) {
+	// No memory: name the operand instead (see Debug::Mnemonic)
+	if (!read && type != Absolute && type != Hex8 && type != Hex16) {
+		out << (type == Offset8 ? " r8" : (type == HexOffset8 ? " d8" : " d16"));
+		debugPrintArgument(out, cpu, read, addr, args...);
+		return;
+	}
+
+	uint8_t  low = read ? read(addr + (uint16_t) data) : 0;
+	uint8_t  high = read ? read(addr + (uint16_t) data + 1) : 0;
 	uint16_t word = (high << 8) | low;
 
 	std::ios::fmtflags fmt(out.flags());
@@ -103,7 +111,7 @@ static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint
 		out << " " << std::dec << data;
 		break;
 	case Offset8:
-		out << " " << std::dec << (int) mmu->Read(addr + (uint16_t) data);
+		out << " " << std::dec << (int) read(addr + (uint16_t) data);
 		break;
 	case Offset16:
 		out << " " << std::dec << (int) word;
@@ -115,7 +123,7 @@ static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint
 		out << " $" << std::setfill('0') << std::setw(2) << std::hex << (int) data;
 		break;
 	case HexOffset8:
-		out << " $" << std::setfill('0') << std::setw(2) << std::hex << (int) mmu->Read(addr + (uint16_t) data);
+		out << " $" << std::setfill('0') << std::setw(2) << std::hex << (int) read(addr + (uint16_t) data);
 		break;
 	case HexOffset16:
 		out << " $" << std::setfill('0') << std::setw(4) << std::hex << (int) word;
@@ -123,22 +131,24 @@ static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint
 
 	}
 	out.flags(fmt);
-	debugPrintArgument(out, cpu, mmu, addr, args...);
+	debugPrintArgument(out, cpu, read, addr, args...);
 }
 
 template<typename... Args>
-static void debugPrintArgument(std::ostream &out, CPU* cpu, MMU* mmu, const uint16_t addr, const std::string& absolute, const Args... args) {
+static void debugPrintArgument(std::ostream &out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr, const std::string& absolute, const Args... args) {
 	out << " " << absolute;
-	debugPrintArgument(out, cpu, mmu, addr, args...);
+	debugPrintArgument(out, cpu, read, addr, args...);
 }
 
 template<typename... Args>
 Debug::InstructionPrinter debugPrintInstruction(const Args... args) {
-	return[args...](std::ostream& out, CPU* cpu, MMU* mmu, const uint16_t addr) {
-		std::ios::fmtflags fmt(out.flags());
-		out << std::setfill('0') << std::setw(4) << std::hex << (int) addr << " |";
-		out.flags(fmt);
-		debugPrintArgument(out, cpu, mmu, addr, args...);
+	return[args...](std::ostream& out, CPU* cpu, const Debug::CodeReader& read, const uint16_t addr) {
+		if (read) {
+			std::ios::fmtflags fmt(out.flags());
+			out << std::setfill('0') << std::setw(4) << std::hex << (int) addr << " |";
+			out.flags(fmt);
+		}
+		debugPrintArgument(out, cpu, read, addr, args...);
 	};
 }
 
@@ -402,9 +412,9 @@ const static Debug::InstructionPrinter cbhandlers[] = {
 	debugPrintInstruction("SET", Absolute, 7, Comma, Direct, A)  // ff SET 7,A
 };
 
-static void HandleCB(std::ostream& out, CPU* cpu, MMU* mmu, uint16_t addr) {
-	uint8_t opcode = mmu->Read(addr + 1);
-	cbhandlers[opcode](out, cpu, mmu, addr + 1);
+static void HandleCB(std::ostream& out, CPU* cpu, const Debug::CodeReader& read, uint16_t addr) {
+	uint8_t opcode = read(addr + 1);
+	cbhandlers[opcode](out, cpu, read, addr + 1);
 }
 
 const static Debug::InstructionPrinter handlers[] = {
@@ -666,9 +676,32 @@ const static Debug::InstructionPrinter handlers[] = {
 	debugPrintInstruction("RST", Hex8, 0x38)                   // ff RST 38h
 };
 
+void Debug::Disassemble(std::ostream& out, CPU* cpu, MMU* mmu, const uint16_t addr) {
+	Disassemble(out, cpu, [mmu](const uint16_t location) { return mmu->Peek(location); }, addr);
+}
+
+void Debug::Disassemble(std::ostream& out, CPU* cpu, const CodeReader& read, const uint16_t addr) {
+	uint8_t opcode = read(addr);
+	handlers[opcode](out, cpu, read, addr);
+}
+
+std::string Debug::Mnemonic(const uint8_t opcode, const bool prefixed) {
+	if (!prefixed && opcode == 0xcb) {
+		return "PREFIX CB";
+	}
+
+	std::ostringstream out;
+	(prefixed ? cbhandlers : handlers)[opcode](out, nullptr, CodeReader(), 0);
+
+	// Drop the separator and the line break
+	std::string text = out.str();
+	const size_t first = text.find_first_not_of(' ');
+	const size_t last = text.find_last_not_of("\r\n");
+	return first == std::string::npos ? "" : text.substr(first, last - first + 1);
+}
+
 void Debugger::printInstruction(const uint16_t addr, std::ostream& out) const {
-	uint8_t opcode = emulator->mmu.Read(addr);
-	handlers[opcode](out, &(emulator->cpu), &(emulator->mmu), addr);
+	Debug::Disassemble(out, &(emulator->cpu), &(emulator->mmu), addr);
 }
 
 void Debugger::printRegisters(std::ostream& out) const {
@@ -717,6 +750,7 @@ void Debugger::printCounters(std::ostream& out) const {
 	CycleCount counters = emulator->cpu.cycles;
 	out << "Machine: " << counters.machine << "    "
 		<< "CPU: " << counters.cpu << std::endl;
+	emulator->counters.Print(out);
 }
 
 void Debugger::printInterrupts(std::ostream& out) const {
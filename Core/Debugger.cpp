@@ -10,6 +10,7 @@
 #include <tuple>
 #include <deque>
 #include <unordered_map>
+#include <atomic>
 #if _POSIX_C_SOURCE >= 1 || _XOPEN_SOURCE || _POSIX_SOURCE
 #include <unistd.h>
 #include <csignal>
@@ -19,17 +20,18 @@
 
 using namespace Debug;
 
-static Debugger* _debugger = nullptr;
+// SIGINT is process wide: the handler only counts interrupts, every running
+// debugger pauses its own emulator when it sees a new one.
+static std::atomic<unsigned> interrupts(0);
+static std::atomic<int> prompting(0); //!< Debuggers waiting for a command
 
 // While the debugger is running, trap the SIGINT to pause the emulation.
 static void interrupt_handler(int s) {
-	if (_debugger == nullptr) return;
-	if (!_debugger->GetEmulator()->cpu.paused) {
-		std::clog << "Emulation paused. Type 'run' to resume." << std::endl;
-		_debugger->GetEmulator()->cpu.paused = true;
-		return;
+	// Already paused
+	if (prompting.load() > 0) {
+		exit(s);
 	}
-	exit(s);
+	interrupts.fetch_add(1);
 }
 
 #if _POSIX_C_SOURCE >= 1 || _XOPEN_SOURCE || _POSIX_SOURCE
@@ -70,6 +72,12 @@ enum DebugInstr {
 	CMD_DUMP,
 	CMD_COUNTERS,
 	CMD_INTS,
+	CMD_SCREENSHOT,
+	CMD_PROFILE,
+	CMD_HOTSPOTS,
+	CMD_CALLS,
+	CMD_FLAME,
+	CMD_OPCODES,
 };
 
 struct DebugCmd {
@@ -101,6 +109,12 @@ static const std::unordered_map<std::string, std::tuple<DebugInstr, int, std::st
 	{ "rominfo",    std::make_tuple(CMD_ROMINFO,   0, "Print ROM information") },
 	{ "help",       std::make_tuple(CMD_HELP,      0, "Print a help message") },
 	{ "dump",       std::make_tuple(CMD_DUMP,      1, "Dump instruction history to specified file") },
+	{ "screenshot", std::make_tuple(CMD_SCREENSHOT,1, "Save the current frame as PNG to specified file") },
+	{ "profile",    std::make_tuple(CMD_PROFILE,   1, "Profile the guest, sampling every <n> instructions (default 1, 0 stops)") },
+	{ "hotspots",   std::make_tuple(CMD_HOTSPOTS,  1, "Print the <n> hottest instructions (default 20)") },
+	{ "calls",      std::make_tuple(CMD_CALLS,     1, "Trace guest calls (on/off), or print the costliest functions") },
+	{ "flame",      std::make_tuple(CMD_FLAME,     1, "Write the traced call stacks (folded, for flamegraph.pl) to specified file") },
+	{ "opcodes",    std::make_tuple(CMD_OPCODES,   1, "Count executed opcodes (on/off), or print the <n> most executed (default 30)") },
 	{ "?",          std::make_tuple(CMD_HELP,      0, "Print a help message") }
 };
 
@@ -128,7 +142,7 @@ void Debugger::Run() {
 		emulator->init();
 
 	// Trap SIGINT to pause the execution
-	_debugger = this;
+	seenInterrupts = interrupts.load();
 #if _POSIX_C_SOURCE >= 1 || _XOPEN_SOURCE || _POSIX_SOURCE
 	setup_signal_trap();
 #elif _WIN32 || _WIN64
@@ -143,8 +157,18 @@ void Debugger::Run() {
 	while (emulator->running) {
 		emulator->CheckUpdate();
 
+		if (interrupts.load(std::memory_order_relaxed) != seenInterrupts) {
+			seenInterrupts = interrupts.load();
+			if (!emulator->cpu.paused) {
+				std::clog << "Emulation paused. Type 'run' to resume." << std::endl;
+				emulator->cpu.paused = true;
+			}
+		}
+
 		if (emulator->cpu.paused && opts & DBG_INTERACTIVE) {
+			prompting.fetch_add(1);
 			DebugCmd cmd = getCommand("(mfemu)");
+			prompting.fetch_sub(1);
 			switch (cmd.instr) {
 			case CMD_RUN:
 				std::clog << "Starting emulation..." << std::endl;
@@ -256,6 +280,63 @@ void Debugger::Run() {
 				std::clog << "Saved history dump to " << fname << std::endl;
 				break;
 			}
+			case CMD_SCREENSHOT:
+				emulator->Screenshot(cmd.args.front());
+				break;
+			case CMD_PROFILE: {
+				const int interval = cmd.args.front().empty() ? 1 : atoi(cmd.args.front().c_str());
+				if (interval <= 0) {
+					emulator->profiler.reset();
+					std::clog << "Profiler stopped" << std::endl;
+				} else {
+					emulator->profiler.reset(new PCProfiler(interval));
+					std::clog << "Profiling every " << interval << " instructions" << std::endl;
+				}
+				break;
+			}
+			case CMD_HOTSPOTS: {
+				if (!emulator->profiler) {
+					std::cerr << "The profiler is not running: type `profile` to start it." << std::endl;
+					break;
+				}
+				const int count = cmd.args.front().empty() ? 20 : atoi(cmd.args.front().c_str());
+				emulator->PrintProfile(std::cout, count > 0 ? count : 20);
+				break;
+			}
+			case CMD_CALLS: {
+				const std::string& arg = cmd.args.front();
+				if (arg == "on" || arg == "off") {
+					emulator->TraceCalls(arg == "on");
+					std::clog << "Call tracing is now " << (arg == "on" ? "ENABLED" : "DISABLED") << std::endl;
+				} else if (!emulator->callGraph) {
+					std::cerr << "Calls are not traced: type `calls on` to start." << std::endl;
+				} else {
+					emulator->callGraph->Report(std::cout, 20, emulator->cpu.cycles.cpu);
+				}
+				break;
+			}
+			case CMD_OPCODES: {
+				const std::string& arg = cmd.args.front();
+				if (arg == "on" || arg == "off") {
+					emulator->CountOpcodes(arg == "on");
+					std::clog << "Opcode counting is now " << (arg == "on" ? "ENABLED" : "DISABLED") << std::endl;
+				} else if (!emulator->histogram) {
+					std::cerr << "Opcodes are not counted: type `opcodes on` to start." << std::endl;
+				} else {
+					const int count = arg.empty() ? 30 : atoi(arg.c_str());
+					emulator->PrintOpcodes(std::cout, count > 0 ? count : 30);
+				}
+				break;
+			}
+			case CMD_FLAME: {
+				const std::string fname = cmd.args.front().empty() ? "calls.folded" : cmd.args.front();
+				if (emulator->WriteCallGraph(fname)) {
+					std::clog << "Saved call stacks to " << fname << std::endl;
+				} else {
+					std::cerr << "Could not save call stacks (type `calls on` to trace them)" << std::endl;
+				}
+				break;
+			}
 			default:
 				std::cerr << "Invalid command" << std::endl;
 			}
@@ -8,7 +8,19 @@
 
 namespace Debug {
 
-using InstructionPrinter = std::function<void(std::ostream& out, CPU* cpu, MMU* mmu, const uint16_t addr)>;
+//! Gives the code bytes to disassemble (empty: operands are named instead of read)
+using CodeReader = std::function<uint8_t(const uint16_t addr)>;
+
+using InstructionPrinter = std::function<void(std::ostream& out, CPU* cpu, const CodeReader& read, const uint16_t addr)>;
+
+//! Print the instruction at an address (as mapped right now), with a line break
+void Disassemble(std::ostream& out, CPU* cpu, MMU* mmu, const uint16_t addr);
+
+//! Print the instruction at an address, reading its bytes from any source, with a line break
+void Disassemble(std::ostream& out, CPU* cpu, const CodeReader& read, const uint16_t addr);
+
+//! Opcode mnemonic, with operands named (d8, d16, r8) instead of read
+std::string Mnemonic(const uint8_t opcode, const bool prefixed);
 
 enum DebugOpts : uint8_t {
 	DBG_INTERACTIVE = 1,
@@ -25,6 +37,7 @@ private:
 	uint8_t opts;
 	std::unordered_set<uint16_t> breakPoints;
 	bool track = false;
+	unsigned seenInterrupts = 0;  //!< SIGINTs already handled
 
 	void setBreakpoint(const uint16_t addr);
 	void printInstruction(const uint16_t addr, std::ostream& out = std::cout) const;
@@ -1,38 +1,188 @@
 #include "Emulator.h"
+#include "Debugger.h"
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
 #include <iostream>
 #include <sstream>
 
-Emulator::Emulator(const std::string& romfile, const EmulatorFlags emuflags)
-	: rom(ROM::FromFile(romfile)), mmu(&rom, &gpu, &input), cpu(&mmu) {
+Emulator::Emulator(const std::string& romfile, const EmulatorFlags emuflags, const Config& config)
+	: Emulator(ROM::FromFile(romfile), romfile, emuflags, config) {}
+
+Emulator::Emulator(const ROM& romdata, const std::string& romfile, const EmulatorFlags emuflags, const Config& config)
+	: rom(romdata), mmu(&rom, &gpu, &input, &apu, &counters), cpu(&mmu), input(config) {
 	window = nullptr;
 	renderer = nullptr;
 	running = true;
 	flags = emuflags;
 	frameCycles = 0;
 	titleFpsCount = 0;
+	frameCount = 0;
+	slotFile = romfile + ".state";
+	profileFile = romfile + ".profile";
+	counters.timing = flags.timing;
+
+	// Pick the renderer (the FIFO one can be forced or enabled per ROM)
+	const uint16_t checksum = (rom.header.globalChecksum[0] << 8) | rom.header.globalChecksum[1];
+	gpu.renderMode = flags.forceFifo ? Render_FIFO : config.Renderer(checksum);
+}
+
+Emulator::Emulator(const Emulator& parent)
+	: rom(parent.rom), mmu(&rom, &gpu, &input, &apu, &counters), cpu(&mmu), input(parent.input) {
+	window = nullptr;
+	renderer = nullptr;
+	running = parent.running;
+	titleFpsCount = 0;
+	slotFile = parent.slotFile;
+
+	// Forks are bare machines
+	flags = parent.flags;
+	flags.headless = true;
+	flags.audio = false;
+	flags.recordFile.clear();
+	flags.dumpFirst = flags.dumpLast = -1;
+	flags.stateFile.clear();
+	flags.movieRecord.clear();
+	flags.moviePlay.clear();
+	flags.rewindEvery = 0;
+	flags.hashEvery = 0;
+	flags.sharedName.clear();
+	flags.statsEvery = 0;
+	flags.traceFile.clear();
+	flags.profileEvery = 0;
+	flags.callGraphFile.clear();
+	flags.opcodeFile.clear();
+	counters.timing = parent.counters.timing;
+
+	SaveState::Copy(parent, *this);
+
+	// Not part of the state, but needed to carry on the same way
+	gpu.renderMode = parent.gpu.renderMode;
+	gpu.percent = parent.gpu.percent;
+	memcpy(gpu.screen, parent.gpu.screen, sizeof(gpu.screen));
+	apu.SetRateAdjust(parent.audioRate);
+
+	gpu.InitScreen(nullptr);
+	isInit = true;
+}
+
+std::unique_ptr<Emulator> Emulator::Fork() const {
+	return std::unique_ptr<Emulator>(new Emulator(*this));
 }
 
 Emulator::~Emulator() {
+	if (movie && movieRecording) {
+		if (movie->Save(flags.movieRecord)) {
+			std::cout << "[INFO] Saved " << movie->frames.size() << " frames of input to " << flags.movieRecord << std::endl;
+		} else {
+			std::cout << "[WARNING] Could not write movie " << flags.movieRecord << std::endl;
+		}
+	}
+	if (profiler && flags.profileEvery > 0) {
+		std::ofstream report(profileFile);
+		PrintProfile(report, 100);
+		if (report.good()) {
+			std::cout << "[INFO] Wrote the guest profile to " << profileFile << std::endl;
+		} else {
+			std::cout << "[WARNING] Could not write guest profile " << profileFile << std::endl;
+		}
+	}
+	if (callGraph && !flags.callGraphFile.empty()) {
+		if (WriteCallGraph(flags.callGraphFile)) {
+			std::cout << "[INFO] Wrote the guest call stacks to " << flags.callGraphFile << std::endl;
+		} else {
+			std::cout << "[WARNING] Could not write guest call stacks " << flags.callGraphFile << std::endl;
+		}
+	}
+	if (histogram && !flags.opcodeFile.empty()) {
+		std::ofstream table(flags.opcodeFile);
+		const std::string& path = flags.opcodeFile;
+		if (path.size() > 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+			histogram->WriteCSV(table, Debug::Mnemonic);
+		} else {
+			PrintOpcodes(table, 512);
+		}
+		if (table.good()) {
+			std::cout << "[INFO] Wrote the opcode histogram to " << flags.opcodeFile << std::endl;
+		} else {
+			std::cout << "[WARNING] Could not write opcode histogram " << flags.opcodeFile << std::endl;
+		}
+	}
+	if (!flags.traceFile.empty()) {
+		const long long events = Trace::Export(flags.traceFile);
+		if (events >= 0) {
+			std::cout << "[INFO] Wrote " << events << " trace events to " << flags.traceFile << std::endl;
+		} else {
+			std::cout << "[WARNING] Could not write trace " << flags.traceFile << std::endl;
+		}
+	}
+	if (audioDevice != 0) {
+		SDL_CloseAudioDevice(audioDevice);
+	}
 	if (renderer != nullptr) {
 		SDL_DestroyRenderer(renderer);
 	}
 	if (window != nullptr) {
 		SDL_DestroyWindow(window);
 	}
-	SDL_Quit();
+	// Forks and headless machines never started SDL, others may still be using it
+	if (sdlStarted) {
+		SDL_Quit();
+	}
 }
 
 bool Emulator::init() {
 	// Initialize SDL
-	if (!initSDL()) {
+	if (!flags.headless && !initSDL()) {
 		std::cout << "Emulator could not start correctly, check error above.." << std::endl;
 		return false;
 	}
-	// Initialize GPU
-	gpu.InitScreen(renderer);
+	// Initialize GPU (without a screen when headless)
+	gpu.InitScreen(renderer, flags.scaler);
 	if (!flags.useBootrom) {
 		fakeBootrom();
 	}
+	// Resume from a save state
+	if (!flags.stateFile.empty()) {
+		LoadSnapshot(flags.stateFile);
+	}
+	// Start recording or playing input
+	if (!startMovie()) {
+		return false;
+	}
+	// Start capturing the rewind history (movies can't go back in time)
+	if (flags.rewindEvery > 0 && !movie) {
+		rewind.reset(new RewindBuffer(flags.rewindMemory));
+	}
+	// Start recording
+	if (!flags.recordFile.empty()) {
+		try {
+			recorder.reset(new Recorder(flags.recordFile, flags.recordEvery, flags.scaler));
+			std::cout << "Recording to " << flags.recordFile << std::endl;
+		} catch (const std::exception& error) {
+			std::cout << "[WARNING] " << error.what() << ", not recording" << std::endl;
+		}
+	}
+	// Start exporting frames to other processes
+	if (!flags.sharedName.empty()) {
+		try {
+			sharedExport.reset(new SharedExport(flags.sharedName));
+			std::cout << "[INFO] Exporting frames to shared memory " << flags.sharedName << std::endl;
+		} catch (const std::exception& error) {
+			std::cout << "[WARNING] " << error.what() << std::endl;
+		}
+	}
+	// Profile the guest
+	if (flags.profileEvery > 0) {
+		profiler.reset(new PCProfiler(flags.profileEvery));
+	}
+	if (!flags.callGraphFile.empty()) {
+		TraceCalls(true);
+	}
+	if (!flags.opcodeFile.empty()) {
+		CountOpcodes(true);
+	}
+	lastStatsTime = std::chrono::steady_clock::now();
 	return isInit = true;
 }
 
@@ -41,19 +191,56 @@ bool Emulator::initSDL() {
 		std::cout << "SDL_Init Error: " << SDL_GetError() << std::endl;
 		return false;
 	}
+	sdlStarted = true;
+
+	// Sound is optional, keep going without it
+	if (!flags.audio && flags.sync == Sync_Audio) {
+		std::cout << "[WARNING] Audio sync needs sound, using video sync" << std::endl;
+		flags.sync = Sync_Video;
+	}
+	if (flags.audio) {
+		SDL_AudioSpec want, have;
+		SDL_zero(want);
+		want.freq = apu.SampleRate();
+		want.format = AUDIO_S16SYS;
+		want.channels = 2;
+		want.samples = 1024;
+		want.callback = audioCallback;
+		want.userdata = this;
+
+		// Room for 250ms of stereo samples
+		audioRing.reset(new AudioRing(apu.SampleRate() / 2));
+		if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0 ||
+			(audioDevice = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0)) == 0) {
+			std::cout << "[WARNING] Could not open audio device: " << SDL_GetError() << std::endl;
+			audioRing.reset();
+			if (flags.sync == Sync_Audio) {
+				std::cout << "[WARNING] Audio sync needs sound, using video sync" << std::endl;
+				flags.sync = Sync_Video;
+			}
+		} else {
+			// Keep two device buffers queued on top of the one being played
+			audioTarget = have.samples * 2 * 2;
+		}
+		// Playback starts once the first frames are queued
+	}
 
 	window = SDL_CreateWindow("mfemu", 100, 100, WIDTH * flags.scale, HEIGHT * flags.scale, SDL_WINDOW_SHOWN);
 	if (window == nullptr){
 		std::cout << "SDL_CreateWindow Error: " << SDL_GetError() << std::endl;
 		SDL_Quit();
+		sdlStarted = false;
 		return false;
 	}
 
-	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	// The audio clock replaces vsync in audio sync mode
+	const Uint32 rendererFlags = flags.sync == Sync_Audio ? 0 : SDL_RENDERER_PRESENTVSYNC;
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | rendererFlags);
 	if (renderer == nullptr){
 		SDL_DestroyWindow(window);
 		std::cout << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
 		SDL_Quit();
+		sdlStarted = false;
 		return false;
 	}
 
@@ -71,17 +258,340 @@ void Emulator::Run() {
 	std::cout << "CPU Halted" << std::endl;
 }
 
+bool Emulator::Start() {
+	return isInit || init();
+}
+
+void Emulator::RunFrame() {
+	const uint64_t frame = frameCount;
+	while (running && frameCount == frame) {
+		CheckUpdate();
+		Step();
+	}
+}
+
 void Emulator::Step() {
+	MFEMU_ZONE_FINE("Emulator::Step");
+
+	// Only some steps are timed (the rest is a few increments)
+	uint32_t weight = 0;
+	const bool timing = counters.SampleStep(weight);
+	uint64_t mark = timing ? PerfCounters::ReadTicks() : 0;
+
+	// The instruction about to run, for the guest profiler
+	const bool profiling = profiler && profiler->Due();
+	const uint16_t pc = cpu.PC;
+	const uint8_t bank = profiling ? rom.controller->romBankId : 0; // Before the instruction can switch it
+
+	const bool halted = !cpu.running;
 	const CycleCount c = cpu.Step();
-	frameCycles += c.machine;
+	frameCycles += c.cpu;
+	if (profiling) {
+		profiler->Record(bank, pc, c.cpu, halted);
+	}
+	counters.cycles += c.cpu;
+	if (halted) {
+		counters.haltCycles += c.cpu;
+	} else {
+		counters.instructions++;
+	}
+	if (timing) {
+		mark = counters.Lap(Subsystem_CPU, mark, weight);
+	}
+
 	mmu.UpdateTimers(c);
-	gpu.Step(c.machine);
+	if (timing) {
+		mark = counters.Lap(Subsystem_Timers, mark, weight);
+	}
+	gpu.Step(c.cpu);
+	if (timing) {
+		mark = counters.Lap(Subsystem_PPU, mark, weight);
+	}
+	apu.Step(c.cpu);
+	if (timing) {
+		counters.Lap(Subsystem_APU, mark, weight);
+	}
+
+	if (gpu.frameCount != frameCount) {
+		frameCount = gpu.frameCount;
+		counters.frames++;
+
+		// Once a frame, always timed
+		const uint64_t start = counters.timing ? PerfCounters::ReadTicks() : 0;
+		onFrame();
+		if (counters.timing) {
+			counters.Lap(Subsystem_Frontend, start);
+		}
+	}
 
 	if (mmu.interruptsEnabled) {
 		checkInterrupts();
 	}
 }
 
+void Emulator::onFrame() {
+	MFEMU_ZONE("Emulator::onFrame");
+
+	pushAudio();
+	updateInput();
+
+	// Go back one state per frame while the hotkey is held, capture otherwise
+	if (rewinding) {
+		Rewind();
+	} else if (rewind && frameCount % flags.rewindEvery == 0) {
+		SaveState::Save(*this, rewindState);
+		rewind->Push(rewindState);
+	}
+
+	if (recorder) {
+		recorder->PushFrame(gpu.screen);
+	}
+
+	if (sharedExport) {
+		sharedExport->Publish(*this);
+	}
+
+	// Log state hashes, to compare runs
+	if (flags.hashEvery > 0 && frameCount % flags.hashEvery == 0) {
+		const uint64_t hash = SaveState::Hash(*this, stateHashes);
+		std::cout << "[HASH] frame " << frameCount << std::hex << std::setfill('0') << " " << std::setw(16) << hash;
+		for (const ChunkHash& chunk : stateHashes) {
+			std::cout << " " << chunk.tag << "=" << std::setw(16) << chunk.hash;
+		}
+		std::cout << std::dec << std::endl;
+	}
+
+	// Dump frames in the requested range
+	const int64_t frame = (int64_t)frameCount;
+	if (flags.dumpFirst >= 0 && frame >= flags.dumpFirst && frame <= flags.dumpLast) {
+		std::stringstream path;
+		path << "frame-" << std::setw(6) << std::setfill('0') << frame << ".png";
+		Screenshot(path.str());
+	}
+
+	if (flags.statsEvery > 0 && frameCount % flags.statsEvery == 0) {
+		printStats();
+	}
+}
+
+void Emulator::printStats() {
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(now - lastStatsTime).count();
+	const PerfCounters delta = counters.Since(lastStats);
+
+	const std::ios::fmtflags fmt(std::cout.flags());
+	std::cout << "[STATS] frame " << frameCount << ": " << std::fixed << std::setprecision(1)
+		<< (seconds > 0 ? delta.frames / seconds : 0.0) << " fps, ";
+	std::cout.flags(fmt);
+	delta.PrintLine(std::cout);
+	std::cout << std::endl;
+
+	lastStats = counters;
+	lastStatsTime = now;
+}
+
+void Emulator::PrintProfile(std::ostream& out, const size_t count) {
+	if (!profiler) {
+		return;
+	}
+
+	// Read banked code from the bank it ran from, whatever is mapped now
+	const MBC& controller = *rom.controller;
+	profiler->Report(out, count, [this, &controller](std::ostream& line, const uint8_t bank, const uint16_t pc) {
+		Debug::Disassemble(line, &cpu, [this, &controller, bank](const uint16_t addr) -> uint8_t {
+			if (addr < 0x4000 && !mmu.usingBootstrap) {
+				return controller.ReadROM(0, addr);
+			}
+			if (addr >= 0x4000 && addr < 0x8000) {
+				return controller.ReadROM(bank, addr);
+			}
+			return mmu.Peek(addr);
+		}, pc);
+	});
+}
+
+void Emulator::TraceCalls(const bool enable) {
+	if (enable) {
+		callGraph.reset(new CallGraph(rom.controller, cpu.cycles.cpu));
+		cpu.TraceCalls(callGraph.get());
+	} else {
+		cpu.TraceCalls(nullptr);
+		callGraph.reset();
+	}
+}
+
+bool Emulator::WriteCallGraph(const std::string& path) {
+	if (!callGraph) {
+		return false;
+	}
+	std::ofstream out(path);
+	callGraph->WriteFolded(out, cpu.cycles.cpu);
+	return out.good();
+}
+
+void Emulator::CountOpcodes(const bool enable) {
+	histogram.reset(enable ? new OpcodeHistogram() : nullptr);
+	cpu.histogram = histogram.get();
+}
+
+void Emulator::PrintOpcodes(std::ostream& out, const size_t count) {
+	if (histogram) {
+		histogram->Report(out, count, Debug::Mnemonic);
+	}
+}
+
+void Emulator::Screenshot(const std::string& path) {
+	if (!screenshots) {
+		screenshots.reset(new ScreenshotWriter(flags.scaler));
+	}
+
+	if (!path.empty()) {
+		screenshots->Save(path, gpu.screen);
+		return;
+	}
+
+	std::stringstream name;
+	name << "screenshot-" << std::setw(6) << std::setfill('0') << frameCount << ".png";
+	screenshots->Save(name.str(), gpu.screen);
+}
+
+bool Emulator::SaveSnapshot(const std::string& path) {
+	const std::string& file = path.empty() ? slotFile : path;
+	if (!SaveState::SaveToFile(*this, file)) {
+		std::cout << "[WARNING] Could not write save state " << file << std::endl;
+		return false;
+	}
+	std::cout << "[INFO] Saved state to " << file << std::endl;
+	return true;
+}
+
+bool Emulator::LoadSnapshot(const std::string& path) {
+	const std::string& file = path.empty() ? slotFile : path;
+	if (movie) {
+		std::cout << "[WARNING] Can't load states while a movie is recording or playing" << std::endl;
+		return false;
+	}
+	try {
+		SaveState::LoadFromFile(*this, file);
+	} catch (const std::runtime_error& error) {
+		std::cout << "[WARNING] " << error.what() << std::endl;
+		return false;
+	}
+	std::cout << "[INFO] Loaded state from " << file << std::endl;
+	return true;
+}
+
+bool Emulator::startMovie() {
+	if (!flags.moviePlay.empty()) {
+		try {
+			movie.reset(new Movie(Movie::Load(flags.moviePlay)));
+			if (movie->romHash != rom.hash) {
+				throw std::runtime_error("Movie was recorded with a different ROM");
+			}
+			SaveState::Load(*this, movie->initialState.data(), movie->initialState.size());
+		} catch (const std::runtime_error& error) {
+			std::cout << "Could not play movie " << flags.moviePlay << ": " << error.what() << std::endl;
+			movie.reset();
+			return false;
+		}
+		movieRecording = false;
+		movieFrame = 0;
+		std::cout << "[INFO] Playing " << movie->frames.size() << " frames of input from " << flags.moviePlay << std::endl;
+	} else if (!flags.movieRecord.empty()) {
+		movie.reset(new Movie());
+		movie->romHash = rom.hash;
+		SaveState::Save(*this, movie->initialState);
+		movieRecording = true;
+		std::cout << "[INFO] Recording input to " << flags.movieRecord << std::endl;
+	}
+	return true;
+}
+
+void Emulator::updateInput() {
+	if (!movie || movieRecording) {
+		input.Latch();
+		if (movie) {
+			const MovieFrame frame = { input.GetButtons(), input.buttonPressed };
+			movie->frames.push_back(frame);
+		}
+		return;
+	}
+
+	if (movieFrame == movie->frames.size()) {
+		std::cout << "[INFO] Movie finished after " << movieFrame << " frames" << std::endl;
+		movie.reset();
+		// Nothing left to do without a screen
+		if (flags.headless) {
+			running = false;
+		}
+		return;
+	}
+
+	const MovieFrame& frame = movie->frames[movieFrame++];
+	input.SetButtons(frame.buttons);
+	input.buttonPressed = frame.pressed != 0;
+}
+
+bool Emulator::Rewind() {
+	if (!rewind || !rewind->Pop(rewindState)) {
+		return false;
+	}
+	SaveState::Load(*this, rewindState.data(), rewindState.size());
+	return true;
+}
+
+void Emulator::pushAudio() {
+	// Drain the synthesized audio and hand it to the audio callback
+	apu.Flush();
+	audioBuffer.resize(apu.Available() * 2);
+	const size_t frames = apu.ReadSamples(audioBuffer.data(), apu.Available());
+	if (!audioRing) {
+		return;
+	}
+
+	// In audio sync, wait for the device to play what's queued instead of dropping
+	if (flags.sync == Sync_Audio && audioStarted) {
+		MFEMU_ZONE("Audio sync wait");
+		while (audioRing->Size() > audioTarget && running) {
+			SDL_Delay(1);
+		}
+	}
+
+	audioRing->Push(audioBuffer.data(), frames * 2);
+
+	// Start playing once the target is queued, to not underrun right away
+	if (!audioStarted && audioRing->Size() >= audioTarget) {
+		SDL_PauseAudioDevice(audioDevice, 0);
+		audioStarted = true;
+	}
+
+	// Dynamic rate control: produce up to 0.5% more/less samples to
+	// bring the queue back to its target without audible pitch changes
+	if (flags.sync == Sync_Dynamic && audioStarted) {
+		const double maxDelta = 0.005;
+		double fill = ((double)audioRing->Size() - audioTarget) / audioTarget;
+		fill = fill < -1 ? -1 : (fill > 1 ? 1 : fill);
+		audioRate = 1.0 - maxDelta * fill;
+		apu.SetRateAdjust(audioRate);
+	}
+}
+
+void Emulator::audioCallback(void* userdata, Uint8* stream, int length) {
+	Emulator* emulator = static_cast<Emulator*>(userdata);
+	emulator->audioRing->Pop(reinterpret_cast<int16_t*>(stream), length / sizeof(int16_t));
+}
+
+AudioStats Emulator::GetAudioStats() const {
+	AudioStats stats = { 0, 0, 0, 1.0 };
+	if (audioRing) {
+		stats.underruns = audioRing->Underruns();
+		stats.overruns = audioRing->Overruns();
+		stats.queued = audioRing->Size() / 2;
+		stats.rate = audioRate;
+	}
+	return stats;
+}
+
 void Emulator::checkInterrupts() {
 	if (gpu.didVblank) {
 		mmu.SetInterrupt(IntLCDVblank);
@@ -98,7 +608,16 @@ void Emulator::checkInterrupts() {
 		input.buttonPressed = false;
 	}
 
+	// Count the interrupt serviced (the one whose flag got cleared)
+	const uint8_t pending = mmu.interruptFlags.raw;
 	cpu.HandleInterrupts();
+	const uint8_t serviced = pending & ~mmu.interruptFlags.raw;
+	for (int type = 0; type < 5; ++type) {
+		if (serviced & (1 << type)) {
+			counters.interrupts[type]++;
+			break;
+		}
+	}
 }
 
 void Emulator::CheckUpdate() {
@@ -110,15 +629,36 @@ void Emulator::CheckUpdate() {
 }
 
 void Emulator::Update() {
+	// No window nor events
+	if (flags.headless) {
+		return;
+	}
+
+	MFEMU_ZONE("Emulator::Update");
+
+	// Runs between steps, so it's timed on its own
+	const uint64_t start = counters.timing ? PerfCounters::ReadTicks() : 0;
+	updateWindow();
+	if (counters.timing) {
+		counters.Lap(Subsystem_Frontend, start);
+	}
+}
+
+void Emulator::updateWindow() {
 	// Update window title once every 10 frames
 	if (++titleFpsCount == 10) {
 		titleFpsCount = 0;
 		std::stringstream winTitleStream;
 		winTitleStream << rom.header.GBC.title << " (" << int(gpu.percent) << "%)";
+		const AudioStats audio = GetAudioStats();
+		if (audio.underruns > 0 || audio.overruns > 0) {
+			winTitleStream << " [audio underruns: " << audio.underruns << ", overruns: " << audio.overruns << "]";
+		}
 		SDL_SetWindowTitle(window, winTitleStream.str().c_str());
 	}
 
 	// Get system events
+	MFEMU_ZONE("Poll events");
 	SDL_Event event;
 	while (SDL_PollEvent(&event)) {
 		switch (event.type) {
@@ -126,7 +666,34 @@ void Emulator::Update() {
 			running = false;
 			break;
 		case SDL_KEYDOWN:
+			// Hotkeys
+			if (event.key.repeat == 0) {
+				switch (event.key.keysym.scancode) {
+				case SDL_SCANCODE_F5:
+					SaveSnapshot();
+					continue;
+				case SDL_SCANCODE_F9:
+					LoadSnapshot();
+					continue;
+				case SDL_SCANCODE_F12:
+					Screenshot();
+					continue;
+				case SDL_SCANCODE_F2:
+					rewinding = true;
+					continue;
+				default:
+					break;
+				}
+			}
+			input.HandleInputEvent(event);
+			break;
 		case SDL_KEYUP:
+			if (event.key.keysym.scancode == SDL_SCANCODE_F2) {
+				rewinding = false;
+				break;
+			}
+			input.HandleInputEvent(event);
+			break;
 		case SDL_JOYBUTTONUP:
 		case SDL_JOYBUTTONDOWN:
 		case SDL_JOYAXISMOTION:
@@ -143,6 +710,11 @@ void Emulator::fakeBootrom() {
 	// Zero the VRAM the fast(tm) way
 	memset(gpu.VRAM[0].bytes, 0, 8 * 1024);
 
+	// Sound on, full volume on both outputs (as left by the boot rom)
+	mmu.Write(0xff26, 0x80);
+	mmu.Write(0xff24, 0x77);
+	mmu.Write(0xff25, 0xf3);
+
 	// Turn off Bootrom
 	mmu.Write(0xff50, 1);
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include "SDL.h"
 
@@ -7,12 +9,61 @@
 #include "MMU.h"
 #include "CPU.h"
 #include "GPU.h"
+#include "APU.h"
 #include "Input.h"
+#include "Config.h"
+#include "AudioRing.h"
+#include "Recorder.h"
+#include "Screenshot.h"
+#include "Rewind.h"
+#include "Movie.h"
+#include "SaveState.h"
+#include "SharedExport.h"
+#include "Counters.h"
+#include "Trace.h"
+#include "Profiler.h"
+
+//! What paces the emulation
+enum SyncMode : uint8_t {
+	Sync_Video   = 0, //!< Display vsync only, audio is pushed as it comes
+	Sync_Audio   = 1, //!< Audio device only (no vsync), wait when enough audio is queued
+	Sync_Dynamic = 2  //!< Display vsync, audio rate stretched (+-0.5%) to keep the queue steady
+};
 
 //! Emulator options
 struct EmulatorFlags {
 	bool useBootrom = true; //!< Enable original Game Boy boot rom
 	int scale = 1;          //!< Scale the window X time the original Game Boy resolution
+	bool audio = true;      //!< Play sound
+	SyncMode sync = Sync_Dynamic; //!< What paces the emulation
+	bool forceFifo = false; //!< Always use the pixel FIFO renderer
+	ScalerType scaler = Scaler_None; //!< Upscaler for presented frames
+	std::string recordFile; //!< Record video to this file (.y4m or raw)
+	int recordEvery = 1;    //!< Record one frame every N
+	int64_t dumpFirst = -1; //!< First frame to dump to PNG (-1: none)
+	int64_t dumpLast = -1;  //!< Last frame to dump to PNG
+	std::string stateFile;  //!< Save state to load at startup
+	int rewindEvery = 2;    //!< Capture a rewind state every N frames (0: no rewind)
+	size_t rewindMemory = 8 * 1024 * 1024; //!< Memory for the rewind history (bytes)
+	std::string movieRecord; //!< Record input to this movie file
+	std::string moviePlay;  //!< Replay input from this movie file
+	bool headless = false;  //!< No window, sound or events, run as fast as possible
+	int hashEvery = 0;      //!< Log a hash of the machine state every N frames (0: never)
+	std::string sharedName; //!< Export screen and RAM to this shared memory segment every frame
+	int statsEvery = 0;     //!< Print a line of performance counters every N frames (0: never)
+	bool timing = false;    //!< Time each subsystem (see PerfCounters)
+	std::string traceFile;  //!< Write instrumentation zones to this Chrome trace on exit (MFEMU_TRACE builds)
+	int profileEvery = 0;   //!< Profile the guest PC every N instructions, report in <romfile>.profile on exit (0: off)
+	std::string callGraphFile; //!< Trace guest calls, write the folded call stacks to this file on exit
+	std::string opcodeFile; //!< Count executed opcodes, write the table to this file on exit (CSV if *.csv)
+};
+
+//! Audio output counters (for the frontend)
+struct AudioStats {
+	uint64_t underruns;     //!< Times the sound card ran out of samples
+	uint64_t overruns;      //!< Times samples had to be dropped (ring full)
+	size_t queued;          //!< Stereo samples waiting to be played
+	double rate;            //!< Current output rate adjustment (dynamic sync)
 };
 
 /*! \brief Game boy Emulator
@@ -22,15 +73,40 @@ struct EmulatorFlags {
  */
 class Emulator final {
 	friend class Debugger;
+	friend class SaveState;
+	friend class LockstepChecker;
 private:
 	SDL_Window* window;
 	SDL_Renderer* renderer;
+	bool sdlStarted = false;              //!< This instance initialized SDL (and has to quit it)
+	SDL_AudioDeviceID audioDevice = 0;
+	bool audioStarted = false;
+	std::vector<int16_t> audioBuffer;
+	std::unique_ptr<AudioRing> audioRing; //!< Samples for the audio callback
+	size_t audioTarget = 0;               //!< Samples to keep queued
+	double audioRate = 1.0;               //!< Current output rate adjustment
 
 	EmulatorFlags flags;
 
 	uint64_t frameCycles;
 	uint64_t titleFpsCount;
+	uint64_t frameCount;
 	bool isInit = false;
+	std::string slotFile;                 //!< Save state slot (<romfile>.state)
+	std::string profileFile;              //!< Guest profile report (<romfile>.profile)
+
+	std::unique_ptr<Recorder> recorder;
+	std::unique_ptr<ScreenshotWriter> screenshots;
+	std::unique_ptr<RewindBuffer> rewind; //!< Rewind history (null if disabled)
+	std::vector<uint8_t> rewindState;     //!< Capture/restore buffer
+	bool rewinding = false;               //!< Rewind hotkey held
+	std::unique_ptr<Movie> movie;         //!< Movie being recorded or played (null if none)
+	bool movieRecording = false;          //!< Recording (true) or playing (false) the movie
+	size_t movieFrame = 0;                //!< Next movie frame to play
+	std::vector<ChunkHash> stateHashes;   //!< Per chunk hashes (hash logging)
+	std::unique_ptr<SharedExport> sharedExport; //!< Shared memory export (null if disabled)
+	PerfCounters lastStats;               //!< Counters at the last stats line
+	std::chrono::steady_clock::time_point lastStatsTime; //!< When the last stats line was printed
 
 
 	//! Initializes all the Emulator's subsystems
@@ -38,14 +114,44 @@ private:
 	bool initSDL();
 	void checkInterrupts();
 	void fakeBootrom();
+
+	//! SDL audio callback (runs on the audio thread)
+	static void audioCallback(void* userdata, Uint8* stream, int length);
+
+	//! Called once a frame is complete (at VBlank)
+	void onFrame();
+
+	//! Print the counters accumulated since the last stats line
+	void printStats();
+
+	//! Window title and events (see Update)
+	void updateWindow();
+
+	//! Hand the frame's audio to the audio callback and pace the emulation
+	void pushAudio();
+
+	//! Start recording or playing the movie given in the flags
+	bool startMovie();
+
+	//! Latch the frame's input, from the movie if playing one
+	void updateInput();
+
+	//! Create a fork of an emulator (see Fork)
+	Emulator(const Emulator& parent);
 public:
 	ROM rom;      //!< ROM file
 	GPU gpu;      //!< LCD driver
+	APU apu;      //!< Sound
 	MMU mmu;      //!< Memory management unit
 	CPU cpu;      //!< CPU
 
 	Input input;  //!< Input manager
 
+	PerfCounters counters; //!< Performance counters (set counters.timing to time subsystems)
+	std::unique_ptr<PCProfiler> profiler; //!< Guest PC profiler (null when not profiling)
+	std::unique_ptr<CallGraph> callGraph; //!< Guest call graph (null when not tracing, see TraceCalls)
+	std::unique_ptr<OpcodeHistogram> histogram; //!< Opcode counts (null when not counting, see CountOpcodes)
+
 	bool running; //!< Is the emulator running?
 
 	/*! \brief Create a GB emulator
@@ -55,17 +161,48 @@ public:
 	 *
 	 *  \param romfile Path to the ROM to load
 	 *  \param flags Emulator options
+	 *  \param config Key bindings and renderer settings
 	 */
-	explicit Emulator(const std::string& romfile, const EmulatorFlags flags);
+	explicit Emulator(const std::string& romfile, const EmulatorFlags flags, const Config& config = Config());
+
+	/*! \brief Create a GB emulator from a loaded ROM
+	 *
+	 *  \param rom ROM to run (its data is shared, see ROM(const ROM&))
+	 *  \param romfile Name the save state and profile files are based on
+	 *  \param flags Emulator options
+	 *  \param config Key bindings and renderer settings
+	 */
+	Emulator(const ROM& rom, const std::string& romfile, const EmulatorFlags flags, const Config& config = Config());
 
 	~Emulator();
 
+	Emulator& operator=(const Emulator&) = delete;
+
+	/*! \brief Branch off the current machine
+	 *
+	 *  Creates an independent, headless copy of the emulator, ready to Step().
+	 *  The ROM is shared and cartridge RAM is only copied page by page once
+	 *  either side writes to it, the rest of the state is copied in bulk.
+	 *  Forks don't record, rewind or play movies. They can run on other threads.
+	 *
+	 *  \return Forked emulator
+	 */
+	std::unique_ptr<Emulator> Fork() const;
+
 	/*! \brief Run the emulator
 	 *
 	 *  Runs the emulator in a "blocking" way.
 	 */
 	void Run();
 
+	/*! \brief Initialize without running
+	 *
+	 *  For external loops driving the emulator with Step() or RunFrame().
+	 *
+	 *  \return false if the emulator could not start
+	 */
+	bool Start();
+
 	/*! \brief Execute a single step
 	 *
 	 *  Executes a single step, useful for running
@@ -73,6 +210,12 @@ public:
 	 */
 	void Step();
 
+	/*! \brief Run until the current frame is complete
+	 *
+	 *  Steps (and checks for updates) until the next VBlank.
+	 */
+	void RunFrame();
+
 	/*! \brief Check for window update
 	 *
 	 *  Checks if the window should be updated (title / fps count)
@@ -84,4 +227,85 @@ public:
 	 *  Updates the window title and internal timers (ie. fps count)
 	 */
 	void Update();
+
+	//! Frames completed since power on
+	uint64_t FrameCount() const { return frameCount; }
+
+	//! Audio underrun/overrun counters and ring fill
+	AudioStats GetAudioStats() const;
+
+	/*! \brief Print the guest profile
+	 *
+	 *  Lists the hottest instructions of the profiler, disassembled
+	 *  from the ROM bank they ran in. Does nothing if not profiling.
+	 *
+	 *  \param out Stream to print to
+	 *  \param count Instructions to list
+	 */
+	void PrintProfile(std::ostream& out, const size_t count = 20);
+
+	/*! \brief Trace guest calls
+	 *
+	 *  Starts building a new call graph (see CallGraph), or stops and drops it.
+	 *
+	 *  \param enable Start (true) or stop (false) tracing
+	 */
+	void TraceCalls(const bool enable);
+
+	/*! \brief Write the traced call stacks
+	 *
+	 *  \param path File to write (folded stacks, see CallGraph::WriteFolded)
+	 *  \return false if not tracing or the file could not be written
+	 */
+	bool WriteCallGraph(const std::string& path);
+
+	/*! \brief Count executed opcodes
+	 *
+	 *  Starts a new opcode histogram, or stops and drops it.
+	 *
+	 *  \param enable Start (true) or stop (false) counting
+	 */
+	void CountOpcodes(const bool enable);
+
+	/*! \brief Print the most executed opcodes
+	 *
+	 *  Does nothing if opcodes are not counted.
+	 *
+	 *  \param out Stream to print to
+	 *  \param count Opcodes to list
+	 */
+	void PrintOpcodes(std::ostream& out, const size_t count = 30);
+
+	/*! \brief Save the current frame as PNG
+	 *
+	 *  Queues the last complete frame to be written in the background.
+	 *
+	 *  \param path PNG file to write (default: screenshot-<frame>.png)
+	 */
+	void Screenshot(const std::string& path = "");
+
+	/*! \brief Save the machine state
+	 *
+	 *  \param path State file to write (default: <romfile>.state)
+	 *  \return true if the state was written
+	 */
+	bool SaveSnapshot(const std::string& path = "");
+
+	/*! \brief Restore a machine state
+	 *
+	 *  Leaves the machine untouched if the state can't be loaded.
+	 *
+	 *  \param path State file to read (default: <romfile>.state)
+	 *  \return true if the state was loaded
+	 */
+	bool LoadSnapshot(const std::string& path = "");
+
+	/*! \brief Go back in time
+	 *
+	 *  Restores the newest state of the rewind history (captured
+	 *  every EmulatorFlags::rewindEvery frames) and drops it.
+	 *
+	 *  \return false if the history is empty or rewind is disabled
+	 */
+	bool Rewind();
 };
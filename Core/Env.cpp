@@ -0,0 +1,128 @@
+#include "Env.h"
+#include "Emulator.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+//! Watched RAM range
+struct WatchedRegion {
+	uint16_t address;
+	size_t size;
+};
+
+struct mfemu_env {
+	std::unique_ptr<Emulator> emulator;
+	std::unique_ptr<Emulator> start;        //!< Start state (never run)
+	std::vector<WatchedRegion> watched;
+	std::vector<const uint8_t*> regions;    //!< Where the watched ranges are right now
+	struct mfemu_observation observation;
+	std::string error;                      //!< Why the last call failed (empty if it succeeded)
+};
+
+// Run a call, turning exceptions into an error result (they must not reach C callers)
+template<typename Result, typename Body>
+static Result guarded(mfemu_env* env, const Result failed, Body body) {
+	env->error.clear();
+	try {
+		return body();
+	} catch (const std::exception& error) {
+		env->error = error.what();
+	} catch (...) {
+		env->error = "Unknown error";
+	}
+	return failed;
+}
+
+// Point the observation at the machine's current memory
+static const struct mfemu_observation* observe(mfemu_env* env) {
+	Emulator& emulator = *env->emulator;
+	for (size_t i = 0; i < env->watched.size(); ++i) {
+		env->regions[i] = emulator.mmu.Region(env->watched[i].address, env->watched[i].size);
+	}
+
+	struct mfemu_observation& observation = env->observation;
+	observation.screen = emulator.gpu.screen;
+	observation.width = WIDTH;
+	observation.height = HEIGHT;
+	observation.regions = env->regions.data();
+	observation.regionCount = env->regions.size();
+	observation.frame = emulator.FrameCount();
+	observation.halted = emulator.running ? 0 : 1;
+	return &observation;
+}
+
+mfemu_env* mfemu_create(const char* romfile, const char* statefile) {
+	EmulatorFlags flags;
+	flags.headless = true;
+	flags.audio = false;
+	flags.rewindEvery = 0;
+
+	std::unique_ptr<mfemu_env> env(new mfemu_env());
+	try {
+		env->start.reset(new Emulator(romfile, flags));
+		if (!env->start->Start()) {
+			return nullptr;
+		}
+		if (statefile != nullptr) {
+			SaveState::LoadFromFile(*env->start, statefile);
+		}
+		env->emulator = env->start->Fork();
+	} catch (const std::exception& error) {
+		std::cout << "[WARNING] Could not create environment: " << error.what() << std::endl;
+		return nullptr;
+	}
+
+	observe(env.get());
+	return env.release();
+}
+
+void mfemu_destroy(mfemu_env* env) {
+	delete env;
+}
+
+int mfemu_watch(mfemu_env* env, uint16_t address, size_t size) {
+	return guarded(env, -1, [&]() -> int {
+		if (env->emulator->mmu.Region(address, size) == nullptr) {
+			return -1;
+		}
+
+		const WatchedRegion region = { address, size };
+		env->watched.push_back(region);
+		env->regions.push_back(nullptr);
+		observe(env);
+		return (int)env->watched.size() - 1;
+	});
+}
+
+const struct mfemu_observation* mfemu_reset(mfemu_env* env) {
+	return guarded(env, (const struct mfemu_observation*)nullptr, [&]() -> const struct mfemu_observation* {
+		Emulator& emulator = *env->emulator;
+		const Emulator& start = *env->start;
+
+		SaveState::Copy(start, emulator);
+		memcpy(emulator.gpu.screen, start.gpu.screen, sizeof(emulator.gpu.screen));
+		emulator.running = start.running;
+		return observe(env);
+	});
+}
+
+const struct mfemu_observation* mfemu_step(mfemu_env* env, uint8_t actions, int frames) {
+	return guarded(env, (const struct mfemu_observation*)nullptr, [&]() -> const struct mfemu_observation* {
+		Emulator& emulator = *env->emulator;
+
+		emulator.input.QueueButtons(actions);
+		for (int i = 0; i < frames && emulator.running; ++i) {
+			emulator.RunFrame();
+		}
+		return observe(env);
+	});
+}
+
+const struct mfemu_observation* mfemu_observation(const mfemu_env* env) {
+	return &env->observation;
+}
+
+const char* mfemu_error(const mfemu_env* env) {
+	return env->error.empty() ? nullptr : env->error.c_str();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/*! \file Env.h
+ *  \brief Environment API for training agents
+ *
+ *  Plain C interface over a headless emulator: reset to a start state, step
+ *  a number of frames holding a set of buttons, then read the screen and
+ *  watched RAM ranges in place. Nothing goes through SDL, and observations
+ *  point straight into the machine's memory (no copies).
+ *
+ *  Environments are independent, each one can run on its own thread.
+ *  No C++ exception crosses this interface: a failing call returns NULL
+ *  (or -1) and mfemu_error tells why.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Buttons for mfemu_step (one bit each, can be combined)
+enum mfemu_button {
+	MFEMU_A      = 1 << 0,
+	MFEMU_B      = 1 << 1,
+	MFEMU_SELECT = 1 << 2,
+	MFEMU_START  = 1 << 3,
+	MFEMU_RIGHT  = 1 << 4,
+	MFEMU_LEFT   = 1 << 5,
+	MFEMU_UP     = 1 << 6,
+	MFEMU_DOWN   = 1 << 7
+};
+
+//! Emulator environment (opaque)
+typedef struct mfemu_env mfemu_env;
+
+/*! \brief What an environment looks like after the last reset/step
+ *
+ *  Pointers stay valid until the environment is destroyed, their contents
+ *  change with every mfemu_reset and mfemu_step (copy what has to be kept).
+ *  Always spelled struct mfemu_observation, the name alone is the getter.
+ */
+struct mfemu_observation {
+	const uint32_t* screen;         //!< Last complete frame (ARGB8888, width * height)
+	int width, height;              //!< Screen size in pixels
+	const uint8_t* const* regions;  //!< Watched RAM ranges, in mfemu_watch order
+	size_t regionCount;             //!< Number of watched ranges
+	uint64_t frame;                 //!< Frames since power on
+	int halted;                     //!< The machine stopped (CPU locked up), steps do nothing
+};
+
+/*! \brief Create an environment
+ *
+ *  Loads the ROM and the start state every reset goes back to.
+ *
+ *  \param romfile ROM to run
+ *  \param statefile Save state to start from (NULL: power on)
+ *  \return New environment, NULL if the ROM or state could not be loaded
+ */
+mfemu_env* mfemu_create(const char* romfile, const char* statefile);
+
+//! Destroy an environment
+void mfemu_destroy(mfemu_env* env);
+
+/*! \brief Watch a RAM range
+ *
+ *  The range is then part of every observation (VRAM, WRAM or zero page,
+ *  switchable banks follow the bank mapped at the time of the observation).
+ *
+ *  \param env Environment
+ *  \param address First address of the range
+ *  \param size Length of the range
+ *  \return Index of the range in mfemu_observation::regions, -1 if it can't be read in place (or on error)
+ */
+int mfemu_watch(mfemu_env* env, uint16_t address, size_t size);
+
+/*! \brief Go back to the start state
+ *
+ *  \param env Environment
+ *  \return Observation of the start state, NULL on error (see mfemu_error)
+ */
+const struct mfemu_observation* mfemu_reset(mfemu_env* env);
+
+/*! \brief Advance the environment
+ *
+ *  Holds the buttons for a number of frames (action repeat), only the last
+ *  one is observed (frame skip). Like a real joypad, the game sees the new
+ *  buttons from the next VBlank on.
+ *
+ *  \param env Environment
+ *  \param actions Buttons held (mfemu_button bits)
+ *  \param frames Frames to run (at least 1)
+ *  \return Observation after the last frame, NULL on error (see mfemu_error, reset to go on)
+ */
+const struct mfemu_observation* mfemu_step(mfemu_env* env, uint8_t actions, int frames);
+
+//! Current observation (as returned by the last reset/step)
+const struct mfemu_observation* mfemu_observation(const mfemu_env* env);
+
+//! Why the last call on an environment failed (NULL if it succeeded), valid until the next call
+const char* mfemu_error(const mfemu_env* env);
+
+#ifdef __cplusplus
+}
+#endif
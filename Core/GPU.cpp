@@ -1,4 +1,9 @@
 #include "GPU.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 
 // BGB palette
 const static uint32_t shades[] = { 0xffe7ffd6, 0xff88c070, 0xff346856, 0xff081820 };
@@ -7,6 +12,7 @@ void GPU::Step(const uint64_t cycles) {
 	if (!lcdControl.flags.enableLCD) {
 		lcdStatus.flags.mode = Mode_VBlank;
 		line = 0;
+		windowLine = 0;
 		return;
 	}
 
@@ -15,7 +21,7 @@ void GPU::Step(const uint64_t cycles) {
 	switch (lcdStatus.flags.mode) {
 	// Hblank
 	case Mode_HBlank:
-		if (cycleCount >= 204) {
+		if (cycleCount >= hblankLength) {
 			// Next scanline
 			cycleCount = 0;
 			line++;
@@ -31,9 +37,10 @@ void GPU::Step(const uint64_t cycles) {
 				}
 			}
 
-			if (line == 143) {
+			if (line == HEIGHT) {
 				// Go into Vblank
 				lcdStatus.flags.mode = Mode_VBlank;
+				frameCount++;
 				drawScreen();
 				didVblank = true;
 
@@ -72,6 +79,7 @@ void GPU::Step(const uint64_t cycles) {
 			if (line > 153) {
 				// Last line, go back up
 				line = 0;
+				windowLine = 0;
 				lcdStatus.flags.mode = Mode_OAM;
 
 				// Trigger LCD interrupt if the OAM int mode flag is on
@@ -87,140 +95,435 @@ void GPU::Step(const uint64_t cycles) {
 			// Go into VRAM read
 			cycleCount = 0;
 			lcdStatus.flags.mode = Mode_VRAM;
+
+			// Pick the renderer for this line
+			useFifo = renderMode == Render_FIFO || (renderMode == Render_Auto && rasterWrites);
+			if (useFifo) {
+				startFifo();
+			}
 		}
 		break;
 	// VRAM read
 	case Mode_VRAM:
-		if (cycleCount >= 172) {
-			// Go into Hblank
-			cycleCount = 0;
-			lcdStatus.flags.mode = Mode_HBlank;
-
-			if (lcdControl.flags.enableLCD) {
-				drawLine();
+		if (useFifo) {
+			// Push pixels as dots go by, the mode lasts until the line is complete
+			while (fifo.dots < (int) cycleCount && fifo.x < WIDTH) {
+				stepFifo();
+			}
+			if (fifo.x < WIDTH) {
+				break;
 			}
 
-			// Trigger LCD interrupt if the HBlank int mode flag is on
-			if (lcdStatus.flags.intMode0) {
-				didLCDInterrupt = true;
+			// Longer mode 3 (scrolling, sprites) means shorter HBlank
+			hblankLength = 456 - 80 - fifo.dots;
+		} else {
+			if (cycleCount < 172) {
+				break;
 			}
+
+			drawLine();
+			hblankLength = 204;
+		}
+
+		// Go into Hblank
+		cycleCount = 0;
+		lcdStatus.flags.mode = Mode_HBlank;
+
+		// Trigger LCD interrupt if the HBlank int mode flag is on
+		if (lcdStatus.flags.intMode0) {
+			didLCDInterrupt = true;
 		}
 		break;
 	}
 }
 
 GPU::GPU() {
+	// Clear all registers (and padding, so saved states are reproducible)
+	memset(static_cast<GPUState*>(this), 0, sizeof(GPUState));
+
 	line = 0;
+	windowLine = 0;
+	frameCount = 0;
 	cycleCount = 0;
+	hblankLength = 204;
+	renderMode = Render_Scanline;
+	useFifo = rasterWrites = false;
 	bgScrollX = bgScrollY = 0;
+	winScrollX = winScrollY = 0;
 	didVblank = didLCDInterrupt = false;
 	lcdStatus.flags.mode = Mode_HBlank;
-	lastFrameTime = SDL_GetTicks();
+	lastFrameTime = SDL_GetPerformanceCounter();
+	percent = 100;
+	renderer = nullptr;
+	texture = nullptr;
 
 	// Push at least one VRAM bank (GB classic)
 	VRAM.push_back({});
 }
 
-void GPU::InitScreen(SDL_Renderer* _renderer) {
+void GPU::RasterWrite() {
+	if (renderMode != Render_Auto || rasterWrites) {
+		return;
+	}
+
+	if (lcdControl.flags.enableLCD && lcdStatus.flags.mode == Mode_VRAM) {
+		rasterWrites = true;
+		std::clog << "[INFO] Mid-scanline register writes detected, switching to the pixel FIFO renderer" << std::endl;
+	}
+}
+
+void GPU::InitScreen(SDL_Renderer* _renderer, const ScalerType scalerType) {
 	renderer = _renderer;
-	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
+	scaler = Scaler(scalerType);
+	if (renderer == nullptr) {
+		// Headless, frames are only kept in the screen buffer
+		texture = nullptr;
+		return;
+	}
+	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, scaler.Width(), scaler.Height());
 }
 
 void GPU::drawLine() {
-	const uint16_t dataOffset = lcdControl.flags.tilePatternTable ? 0x0000 : 0x0800;
+	MFEMU_ZONE("GPU::drawLine");
+	// Color ids of the BG/Window and of the sprites for the current line
+	uint8_t bgLine[WIDTH] = { 0 };
+	uint8_t objLine[WIDTH] = { 0 };
 
 	if (lcdControl.flags.displayBackground) {
-		const uint16_t mapOffset = lcdControl.flags.bgTileTable ? 0x1c00 : 0x1800;
+		// Window starts from WX-7 if its Y position has been reached
+		int windowX = WIDTH;
+		if (lcdControl.flags.displayWindow && line >= winScrollY && winScrollX < WIDTH + 7) {
+			windowX = winScrollX < 7 ? 0 : winScrollX - 7;
+		}
 
-		const uint8_t ty = line + bgScrollY;
-		const uint16_t tileRow = ty / 8;
-		const uint8_t lineOffset = ty % 8;
+		// Background (up to where the window starts)
+		if (windowX > 0) {
+			const uint16_t mapOffset = lcdControl.flags.bgTileTable ? 0x1c00 : 0x1800;
+			fetchTiles(bgLine, mapOffset, line + bgScrollY, bgScrollX, 0);
+		}
 
-		//TODO Calculate scroll offset
+		// Window (covers the rest of the line)
+		if (windowX < WIDTH) {
+			const uint16_t mapOffset = lcdControl.flags.windowTileTable ? 0x1c00 : 0x1800;
+			fetchTiles(bgLine, mapOffset, windowLine, windowX + 7 - winScrollX, windowX);
+			windowLine++;
+		}
+	}
+
+	if (lcdControl.flags.displaySprites) {
+		fetchSprites(objLine);
+	}
 
-		for (uint8_t x = 0; x <= WIDTH; ++x) {
-			const uint8_t tx = x + bgScrollX;
+	// Resolve palettes once per line
+	uint32_t bgShades[4], objShades[2][4];
+	for (int i = 0; i < 4; ++i) {
+		// BG and window are blank (white) when the background is off
+		bgShades[i] = shades[lcdControl.flags.displayBackground ? (bgPalette.raw >> (i * 2)) & 0x3 : 0];
+		objShades[0][i] = shades[(spritePalette1.raw >> (i * 2)) & 0x3];
+		objShades[1][i] = shades[(spritePalette2.raw >> (i * 2)) & 0x3];
+	}
 
-			// Get tile id
-			const uint8_t tileCol = tx / 8;
-			uint8_t tileId = VRAM[VRAMbankId].bytes[mapOffset + (tileRow * 32) + tileCol];
+	// Compose the line, a sprite pixel wins over the BG unless it's transparent
+	// or the sprite is set behind the BG and the BG color isn't #0
+	uint32_t* out = &screen[line * WIDTH];
+	for (int x = 0; x < WIDTH; ++x) {
+		const uint8_t obj = objLine[x];
+		const uint8_t bg = bgLine[x];
+		if ((obj & 0x3) != 0 && ((obj & 0x8) == 0 || bg == 0)) {
+			out[x] = objShades[(obj >> 2) & 0x1][obj & 0x3];
+		} else {
+			out[x] = bgShades[bg];
+		}
+	}
+}
 
-			// Convert signed to unsigned if Pattern table #1
+void GPU::fetchTiles(uint8_t* buffer, const uint16_t mapOffset, const uint8_t mapY, uint8_t mapX, const int from) const {
+	const uint8_t* vram = VRAM[VRAMbankId].bytes;
+	const uint16_t dataOffset = lcdControl.flags.tilePatternTable ? 0x0000 : 0x0800;
+	const uint16_t tileRow = mapY / 8;
+	const uint8_t lineOffset = mapY % 8;
+
+	uint8_t color0 = 0, color1 = 0;
+	for (int x = from; x < WIDTH; ++x, ++mapX) {
+		// Fetch a new tile when entering it
+		if (x == from || mapX % 8 == 0) {
+			// Get tile id (the map wraps around every 32 tiles)
+			const uint8_t tileCol = mapX / 8;
+			uint8_t tileId = vram[mapOffset + (tileRow * 32) + tileCol];
+
+			// Convert signed to unsigned if Pattern table #0
 			if (lcdControl.flags.tilePatternTable == 0) {
 				tileId ^= 0x80;
 			}
 
 			// Get colors (2 bytes) of the current tile's line
 			const uint16_t colorOffset = dataOffset + (tileId * 16) + (lineOffset * 2);
-			const uint8_t color0 = VRAM[VRAMbankId].bytes[colorOffset];
-			const uint8_t color1 = VRAM[VRAMbankId].bytes[colorOffset + 1];
+			color0 = vram[colorOffset];
+			color1 = vram[colorOffset + 1];
+		}
 
-			// Get palette color id of current pixel
-			// This is a 2 bit number, MSB is color1[pixel], LSB is color0[pixel]
-			const uint8_t tileOffset = 7 - tx % 8;
-			const uint8_t colorId = ((color1 >> tileOffset & 0x1) << 1) | (color0 >> tileOffset & 0x1);
+		// Get palette color id of current pixel
+		// This is a 2 bit number, MSB is color1[pixel], LSB is color0[pixel]
+		const uint8_t tileOffset = 7 - mapX % 8;
+		buffer[x] = ((color1 >> tileOffset & 0x1) << 1) | (color0 >> tileOffset & 0x1);
+	}
+}
 
-			// Get actual color from the palette
-			const uint8_t actualColor = (bgPalette.raw >> (colorId * 2)) & 0x3;
+int GPU::selectSprites(int* visible) const {
+	const int spriteHeight = lcdControl.flags.spriteSize == SpriteSize_8x16 ? 16 : 8;
 
-			// Set pixel to shade defined by the color
-			screen[line * WIDTH + x] = shades[actualColor];
+	// Pick the first sprites (in OAM order) that are on this line
+	int count = 0;
+	for (int cur = 0; cur < SPRITE_COUNT && count < LINE_SPRITES; ++cur) {
+		// OAM position is offset by 16 pixels vertically
+		const int top = sprites[cur].y - 16;
+		if (line >= top && line < top + spriteHeight) {
+			visible[count++] = cur;
 		}
 	}
 
-	// Check for sprites
-	for (int cur = 0; cur < SPRITE_COUNT; ++cur) {
-		const OAMBlock currentSprite = sprites[cur];
-		const uint16_t spriteHeight = lcdControl.flags.spriteSize == SpriteSize_8x16 ? 16 : 8;
-		// Check if it's on screen (vertically)
-		if (currentSprite.y > line || currentSprite.y + spriteHeight < line) {
-			continue;
+	// Sprites with lower X are drawn on top, ties are won by the lower OAM index
+	std::stable_sort(visible, visible + count, [this](const int a, const int b) {
+		return sprites[a].x < sprites[b].x;
+	});
+
+	return count;
+}
+
+void GPU::fetchSpriteRow(const OAMBlock& sprite, uint8_t& color0, uint8_t& color1) const {
+	const uint8_t* vram = VRAM[VRAMbankId].bytes;
+	const int spriteHeight = lcdControl.flags.spriteSize == SpriteSize_8x16 ? 16 : 8;
+
+	int spriteLineId = line - (sprite.y - 16);
+	if (sprite.flags.single.flipY) {
+		spriteLineId = spriteHeight - 1 - spriteLineId;
+	}
+
+	// Sprites always use the 8000-8fff pattern table, in 8x16 mode
+	// the lowest bit of the pattern number is ignored
+	uint8_t pattern = sprite.pattern;
+	if (spriteHeight == 16) {
+		pattern &= 0xfe;
+	}
+
+	// Get colors (2 bytes) of the current sprite's line
+	const uint16_t colorOffset = (pattern * 16) + (spriteLineId * 2);
+	color0 = vram[colorOffset];
+	color1 = vram[colorOffset + 1];
+}
+
+void GPU::fetchSprites(uint8_t* buffer) const {
+	int visible[LINE_SPRITES];
+	const int count = selectSprites(visible);
+
+	for (int i = 0; i < count; ++i) {
+		const OAMBlock& sprite = sprites[visible[i]];
+
+		uint8_t color0, color1;
+		fetchSpriteRow(sprite, color0, color1);
+		const uint8_t attributes = (sprite.flags.single.palette << 2) | (sprite.flags.single.priority << 3);
+
+		for (int x = 0; x < 8; ++x) {
+			// OAM position is offset by 8 pixels horizontally
+			const int absX = sprite.x - 8 + x;
+			if (absX < 0 || absX >= WIDTH) {
+				continue;
+			}
+
+			// Keep pixels from sprites with higher priority
+			if ((buffer[absX] & 0x3) != 0) {
+				continue;
+			}
+
+			const uint8_t tileOffset = sprite.flags.single.flipX ? x : 7 - x;
+			const uint8_t colorId = ((color1 >> tileOffset & 0x1) << 1) | (color0 >> tileOffset & 0x1);
+
+			// Color #0 is always transparent for sprites
+			if (colorId == 0) {
+				continue;
+			}
+
+			buffer[absX] = colorId | attributes;
 		}
+	}
+}
 
-		//TODO Handle Y-flip
-		const int spriteLineId = line - currentSprite.y;
+void GPU::startFifo() {
+	fifo.bgHead = fifo.bgSize = 0;
+	memset(fifo.obj, 0, sizeof(fifo.obj));
 
-		// Get colors (2 bytes) of the current sprite's line
-		const uint16_t colorOffset = dataOffset + (currentSprite.pattern * 2 * spriteHeight) + (spriteLineId * 2);
-		const Palette palette = currentSprite.flags.single.palette ? spritePalette2 : spritePalette1;
-		const uint8_t color0 = VRAM[VRAMbankId].bytes[colorOffset];
-		const uint8_t color1 = VRAM[VRAMbankId].bytes[colorOffset + 1];
+	fifo.x = 0;
+	fifo.dots = 0;
+	fifo.stall = 0;
+	fifo.window = false;
 
-		for (uint8_t x = 0; x <= 8; ++x) {
-			const uint8_t absX = currentSprite.x + x;
-			if (absX >= WIDTH) {
-				break;
+	// The first tile is fetched twice, the first fetch is thrown away
+	fifo.fetchDots = -6;
+	fifo.fetchX = 0;
+
+	// Fine scrolling is done by dropping the first pixels of the line
+	fifo.discard = bgScrollX % 8;
+
+	fifo.spriteCount = lcdControl.flags.displaySprites ? (uint8_t) selectSprites(fifo.sprites) : 0;
+	fifo.spritesDone = 0;
+}
+
+void GPU::stepFifo() {
+	fifo.dots++;
+
+	// Sprite fetches stall the whole pipeline
+	if (fifo.stall > 0) {
+		fifo.stall--;
+		return;
+	}
+
+	// Fetch the sprites starting on the next pixel (once the BG is ready)
+	if (fifo.bgSize > 0 && fifo.discard == 0) {
+		for (int i = 0; i < fifo.spriteCount; ++i) {
+			if ((fifo.spritesDone & (1 << i)) != 0) {
+				continue;
 			}
-			const uint8_t colorId = ((color1 >> x & 0x1) << 1) | (color0 >> x & 0x1);
-			const uint8_t actualColor = (palette.raw >> (colorId * 2)) & 0x3;
 
-			// Transparency checks
-			if (lcdControl.flags.color0Opacity) {
-				//TODO Blit under background
+			const OAMBlock& sprite = sprites[fifo.sprites[i]];
+			const int left = sprite.x - 8;
+			if (left > fifo.x || (left < fifo.x && fifo.x > 0)) {
+				continue;
+			}
 
-				// Don't blit transparent pixels
-				if (colorId == 0) {
+			// Merge the sprite line into the sprite queue, keeping older
+			// (higher priority) pixels
+			uint8_t color0, color1;
+			fetchSpriteRow(sprite, color0, color1);
+			const uint8_t attributes = (sprite.flags.single.palette << 2) | (sprite.flags.single.priority << 3);
+			for (int x = 0; x < 8; ++x) {
+				const int offset = left + x - fifo.x;
+				if (offset < 0 || (fifo.obj[offset] & 0x3) != 0) {
 					continue;
 				}
+				const uint8_t tileOffset = sprite.flags.single.flipX ? x : 7 - x;
+				fifo.obj[offset] = (((color1 >> tileOffset & 0x1) << 1) | (color0 >> tileOffset & 0x1)) | attributes;
 			}
 
-			// Set pixel to shade defined by the color
-			screen[line * WIDTH + absX] = shades[actualColor];
+			fifo.spritesDone |= 1 << i;
+			fifo.stall = 6;
+			return;
+		}
+	}
+
+	// Push a pixel to the LCD
+	if (fifo.bgSize > 0) {
+		// Check if the window starts here (like the scanline renderer, not while the BG is off,
+		// so the window line counter only counts lines that showed the window)
+		if (!fifo.window && lcdControl.flags.displayWindow && lcdControl.flags.displayBackground &&
+			line >= winScrollY && fifo.x + 7 >= winScrollX && fifo.discard == 0) {
+			// Restart the fetcher on the window tile map
+			fifo.window = true;
+			fifo.bgSize = 0;
+			fifo.fetchDots = 0;
+			fifo.fetchX = 0;
+			windowLine++;
+
+			// With WX < 7 the window starts left of the screen: drop its hidden pixels
+			fifo.discard = winScrollX < 7 ? 7 - winScrollX : 0;
+		} else {
+			const uint8_t bg = fifo.bg[fifo.bgHead];
+			fifo.bgHead = (fifo.bgHead + 1) % 16;
+			fifo.bgSize--;
+
+			if (fifo.discard > 0) {
+				fifo.discard--;
+			} else {
+				const uint8_t obj = fifo.obj[0];
+				memmove(fifo.obj, fifo.obj + 1, sizeof(fifo.obj) - 1);
+				fifo.obj[7] = 0;
+
+				// Palettes are read as the pixel is pushed
+				uint32_t color;
+				if ((obj & 0x3) != 0 && ((obj & 0x8) == 0 || bg == 0)) {
+					const Palette palette = (obj & 0x4) ? spritePalette2 : spritePalette1;
+					color = shades[(palette.raw >> ((obj & 0x3) * 2)) & 0x3];
+				} else if (lcdControl.flags.displayBackground) {
+					color = shades[(bgPalette.raw >> (bg * 2)) & 0x3];
+				} else {
+					color = shades[0];
+				}
+				screen[line * WIDTH + fifo.x] = color;
+				fifo.x++;
+			}
+		}
+	}
+
+	// Background fetcher (2 dots per step: tile id, low bits, high bits, push)
+	fifo.fetchDots++;
+	const uint8_t* vram = VRAM[VRAMbankId].bytes;
+	switch (fifo.fetchDots) {
+	case 2: {
+		// Scrolling registers are read as the tile is fetched
+		uint16_t mapOffset;
+		uint8_t tileCol, tileRow;
+		if (fifo.window) {
+			mapOffset = lcdControl.flags.windowTileTable ? 0x1c00 : 0x1800;
+			tileCol = fifo.fetchX;
+			tileRow = (uint8_t)(windowLine - 1) / 8;
+		} else {
+			mapOffset = lcdControl.flags.bgTileTable ? 0x1c00 : 0x1800;
+			tileCol = (bgScrollX / 8 + fifo.fetchX) % 32;
+			tileRow = (uint8_t)(line + bgScrollY) / 8;
+		}
+		fifo.tileId = vram[mapOffset + (tileRow * 32) + tileCol];
+		break;
+	}
+	case 4:
+	case 6: {
+		const uint8_t lineOffset = fifo.window ? (uint8_t)(windowLine - 1) % 8 : (uint8_t)(line + bgScrollY) % 8;
+		const uint16_t dataOffset = lcdControl.flags.tilePatternTable ? 0x0000 : 0x0800;
+		const uint8_t tileId = lcdControl.flags.tilePatternTable ? fifo.tileId : fifo.tileId ^ 0x80;
+		const uint16_t colorOffset = dataOffset + (tileId * 16) + (lineOffset * 2);
+		if (fifo.fetchDots == 4) {
+			fifo.color0 = vram[colorOffset];
+		} else {
+			fifo.color1 = vram[colorOffset + 1];
+		}
+		break;
+	}
+	default:
+		// Push the tile line once the queue has room for it
+		if (fifo.fetchDots > 6 && fifo.bgSize <= 8) {
+			for (int x = 0; x < 8; ++x) {
+				const uint8_t tileOffset = 7 - x;
+				const uint8_t colorId = ((fifo.color1 >> tileOffset & 0x1) << 1) | (fifo.color0 >> tileOffset & 0x1);
+				fifo.bg[(fifo.bgHead + fifo.bgSize) % 16] = lcdControl.flags.displayBackground ? colorId : 0;
+				fifo.bgSize++;
+			}
+			fifo.fetchDots = 0;
+			fifo.fetchX++;
 		}
 	}
 }
 
 void GPU::drawScreen() {
-	// Update speed %
-	const uint32_t now = SDL_GetTicks();
-	const uint32_t diff = now - lastFrameTime;
-	percent = 1666.66 / diff;
+	MFEMU_ZONE("GPU::drawScreen");
+
+	// Update speed % (a real frame lasts 70224 / 4194304 s), smoothed over a few frames
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const double elapsed = (double)(now - lastFrameTime) / SDL_GetPerformanceFrequency();
+	if (elapsed > 0) {
+		percent += (100.0 * 70224 / 4194304 / elapsed - percent) * 0.1;
+	}
 	lastFrameTime = now;
 
-	// Put buffer to texture
-	SDL_UpdateTexture(texture, NULL, &screen, WIDTH * sizeof(uint32_t));
+	if (texture == nullptr) {
+		return;
+	}
+
+	// Upscale (if enabled) and put buffer to texture
+	const uint32_t* frame = scaler.Scale(screen);
+	SDL_UpdateTexture(texture, NULL, frame, scaler.Width() * sizeof(uint32_t));
 	SDL_RenderClear(renderer);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
+
+	// Blocks until vsync
+	MFEMU_ZONE("Present");
 	SDL_RenderPresent(renderer);
 }
 
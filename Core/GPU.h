@@ -2,12 +2,14 @@
 
 #include <vector>
 #include "SDL.h"
+#include "Scaler.h"
 
 const int
 	WIDTH = 160,             //!< Gameboy screen width
 	HEIGHT = 144,            //!< Gameboy screen height
 	PIXELS = WIDTH * HEIGHT, //!< Gameboy framebuffer pixel count
-	SPRITE_COUNT = 40;       //!< Gameboy OAM sprite count
+	SPRITE_COUNT = 40,       //!< Gameboy OAM sprite count
+	LINE_SPRITES = 10;       //!< Max sprites shown on a single scanline
 
 //! Single VRAM bank
 struct VRAMBank {
@@ -22,18 +24,19 @@ enum Mode : uint8_t {
 	Mode_VRAM   = 3          //!< Currently reading VRAM (for scanline drawing)
 };
 
-//! Opacity flag
-enum Opacity : uint8_t {
-	Opacity_Transparent = 0, //!< Makes color #0 act as a transparent color
-	Opacity_Solid       = 1  //!< Makes color #0 opaque
-};
-
 //! Sprite size flag
 enum SpriteSize : uint8_t {
 	SpriteSize_8x8  = 0,     //!< Sprite size 8x8 pixels
 	SpriteSize_8x16 = 1      //!< Sprite size 8x16 pixels
 };
 
+//! Scanline rendering method
+enum RenderMode : uint8_t {
+	Render_Scanline = 0,     //!< Draw whole lines at the end of mode 3 (fast)
+	Render_FIFO     = 1,     //!< Push pixels dot by dot like the pixel FIFO does
+	Render_Auto     = 2      //!< Draw lines, switch to FIFO on mid-scanline writes
+};
+
 //! Gameboy colors, aka shades
 enum GBColor : uint8_t {
 	GBColor_White     = 0,
@@ -47,7 +50,7 @@ union LCDControl {
 	uint8_t raw;
 	struct Flags {
 		uint8_t    displayBackground : 1; //!< Show background
-		Opacity    color0Opacity     : 1; //!< Is Color #0 visible or transparent
+		uint8_t    displaySprites    : 1; //!< Show sprites
 		SpriteSize spriteSize        : 1; //!< Sprite size
 		uint8_t    bgTileTable       : 1; //!< Background tilemap (#0 or #1)
 		uint8_t    tilePatternTable  : 1; //!< Background tileset (#0 or #1)
@@ -94,34 +97,52 @@ struct OAMBlock {
 			uint8_t palette  : 1; //!< Palette number (#0/#1)
 			uint8_t flipX    : 1; //!< Flip sprite horizontally
 			uint8_t flipY    : 1; //!< Flip sprite vertically
-			uint8_t priority : 1; //!< Show sprite above window
+			uint8_t priority : 1; //!< Hide sprite behind BG/window colors #1-3
 		} single;
 	} flags;                      //!< Sprite flags
 };
 
-/*! \brief Game boy LCD emulation
+/*! \brief Pixel FIFO state
  *
- *  Emulates the Game boy graphics behavior and LCD blitting
- *  using cycles to sync up with the rest of the machine (mainly CPU)
+ *  State of the background fetcher and of the BG/sprite pixel queues used by
+ *  the pixel FIFO renderer during mode 3 (VRAM read).
  */
-class GPU {
-private:
-	SDL_Renderer* renderer;
-	SDL_Texture* texture;
-	uint32_t screen[PIXELS];
+struct PixelFIFO {
+	uint8_t bg[16];          //!< BG/Window color ids queue
+	uint8_t bgHead,          //!< Index of the next BG pixel to pop
+	        bgSize;          //!< Queued BG pixels
+	uint8_t obj[8];          //!< Sprite pixels, obj[0] is mixed with the next BG pixel
 
-	uint32_t lastFrameTime;
+	int x;                   //!< Next screen pixel to push
+	int dots;                //!< Dots spent in mode 3
+	int discard;             //!< BG pixels to drop (fine horizontal scrolling)
+	int stall;               //!< Dots left before the current sprite fetch is done
 
-	void drawLine();
-	void drawScreen();
+	int fetchDots;           //!< Dots spent on the current tile fetch
+	uint8_t fetchX;          //!< Tile column being fetched
+	uint8_t tileId,          //!< Fetched tile id
+	        color0,          //!< Fetched tile line (low bits)
+	        color1;          //!< Fetched tile line (high bits)
+	bool window;             //!< Fetching from the window tile map
 
-public:
-	//! VSync speed percent (relative to real Gameboy)
-	double percent;
+	int sprites[LINE_SPRITES]; //!< Sprites on the current line (by priority)
+	uint8_t spriteCount;     //!< Number of sprites on the current line
+	uint16_t spritesDone;    //!< Already fetched sprites (bitmask)
+};
 
-	//! Current cycle (in machine cycles)
+/*! \brief GPU state
+ *
+ *  LCD registers, OAM and renderer progress, kept in a plain struct so they
+ *  can be saved and restored with a single copy (see SaveState).
+ *  VRAM banks are saved separately.
+ */
+struct GPUState {
+	//! Current cycle (in CPU cycles, or dots)
 	uint64_t cycleCount;
 
+	//! Frames completed since power on
+	uint64_t frameCount;
+
 	//! Current scanline
 	uint8_t line;
 
@@ -148,20 +169,110 @@ public:
 	//! LCD status flags
 	LCDStatus  lcdStatus;
 
-	//! Video RAM (1 bank on GB, 2 on GBC)
-	std::vector<VRAMBank> VRAM;
 	//! Current VRAM Bank (only changes on GBC)
-	uint8_t VRAMbankId = 0;
+	uint8_t VRAMbankId;
 
 	//! Sprite OAM table
 	OAMBlock sprites[SPRITE_COUNT];
 
+	//! Internal window line counter (only advances on lines showing the window)
+	uint8_t windowLine;
+
+	//! HBlank length of the current line (depends on mode 3 length)
+	uint64_t hblankLength;
+
+	//! Is the pixel FIFO renderer in use? (current line)
+	bool useFifo;
+
+	//! Have drawing registers been written during mode 3? (Render_Auto)
+	bool rasterWrites;
+
+	//! Pixel FIFO renderer state
+	PixelFIFO fifo;
+};
+
+/*! \brief Game boy LCD emulation
+ *
+ *  Emulates the Game boy graphics behavior and LCD blitting
+ *  using cycles to sync up with the rest of the machine (mainly CPU)
+ */
+class GPU : public GPUState {
+private:
+	SDL_Renderer* renderer;
+	SDL_Texture* texture;
+	Scaler scaler;
+
+	uint64_t lastFrameTime;
+
+	void drawLine();
+	void drawScreen();
+
+	//! Set up the pixel FIFO for a new line (start of mode 3)
+	void startFifo();
+
+	//! Advance the pixel FIFO by a single dot
+	void stepFifo();
+
+	/*! \brief Select the sprites of the current line
+	 *
+	 *  Picks the first (up to 10) sprites on the current line in OAM order,
+	 *  then sorts them by priority (lower X first, then lower OAM index).
+	 *
+	 *  \param visible Array of LINE_SPRITES sprite indexes to fill
+	 *  \return Number of selected sprites
+	 */
+	int selectSprites(int* visible) const;
+
+	/*! \brief Fetch the current line of a sprite
+	 *
+	 *  \param sprite Sprite to fetch (must be on the current line)
+	 *  \param color0 Tile line (low bits)
+	 *  \param color1 Tile line (high bits)
+	 */
+	void fetchSpriteRow(const OAMBlock& sprite, uint8_t& color0, uint8_t& color1) const;
+
+	/*! \brief Fetch a tile map row into a line buffer
+	 *
+	 *  Decodes the color ids (0-3, before palette lookup) of a row of tiles
+	 *  into buffer, starting from screen pixel from up to the end of the line.
+	 *
+	 *  \param buffer Line buffer to fill (WIDTH color ids)
+	 *  \param mapOffset VRAM offset of the tile map to read
+	 *  \param mapY Vertical position in the tile map (in pixels)
+	 *  \param mapX Horizontal position in the tile map of the first pixel
+	 *  \param from First screen pixel to fill
+	 */
+	void fetchTiles(uint8_t* buffer, const uint16_t mapOffset, const uint8_t mapY, uint8_t mapX, const int from) const;
+
+	/*! \brief Fetch the sprites of the current line into a line buffer
+	 *
+	 *  Selects the (up to 10) sprites on the current line and writes their
+	 *  pixels into buffer, already resolved by sprite-to-sprite priority.
+	 *  Each pixel is encoded as color id (bits 0-1), palette (bit 2) and
+	 *  BG priority (bit 3), a zero color id means no sprite on that pixel.
+	 *
+	 *  \param buffer Line buffer to fill (WIDTH sprite pixels)
+	 */
+	void fetchSprites(uint8_t* buffer) const;
+
+public:
+	//! Framebuffer (ARGB8888), holds a complete frame from VBlank on
+	uint32_t screen[PIXELS];
+
+	//! VSync speed percent (relative to real Gameboy)
+	double percent;
+
+	//! Scanline rendering method
+	RenderMode renderMode;
+
+	//! Video RAM (1 bank on GB, 2 on GBC)
+	std::vector<VRAMBank> VRAM;
 	/*! \brief Step a number of cycles
 	 *
-	 *  Advances a number of cycles (relative to machine cycles)
+	 *  Advances a number of cycles (relative to CPU cycles, one per dot)
 	 *  and do OAM reading / screen blitting when necessary
 	 *
-	 *  \param cycles Machine cycles that have been passed
+	 *  \param cycles CPU cycles that have been passed
 	 */
 	void Step(const uint64_t cycles);
 
@@ -171,10 +282,21 @@ public:
 	 *  LCD output into it.
 	 *  Most of the blitting is done in a texture, so the
 	 *  renderer is only used to display the texture.
+	 *  Frames are upscaled on the CPU before being uploaded, when
+	 *  an upscaler is given.
 	 *
 	 *  \param _renderer Renderer to blit LCD onto
+	 *  \param scalerType Upscaler to use on presented frames
+	 */
+	void InitScreen(SDL_Renderer* _renderer, const ScalerType scalerType = Scaler_None);
+
+	/*! \brief Notify a write to a drawing register
+	 *
+	 *  Must be called before writing registers that affect how the current
+	 *  scanline is drawn (LCDC, scrolling, palettes, window position).
+	 *  Writes during mode 3 make Render_Auto switch to the pixel FIFO.
 	 */
-	void InitScreen(SDL_Renderer* _renderer);
+	void RasterWrite();
 
 	GPU();
 	~GPU();
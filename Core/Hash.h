@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+const uint64_t
+	HASH_SEED  = 0xcbf29ce484222325ULL, //!< FNV-1a 64 offset basis
+	HASH_PRIME = 0x100000001b3ULL;      //!< FNV-1a 64 prime
+
+/*! \brief Hash a memory block (FNV-1a, 64 bit)
+ *
+ *  Not cryptographic, only meant to tell ROMs and machine states apart.
+ *
+ *  \param data Bytes to hash
+ *  \param size Number of bytes
+ *  \param hash Hash to continue from (to hash several blocks as one)
+ *  \return Hash of the block
+ */
+inline uint64_t HashBytes(const void* data, const size_t size, uint64_t hash = HASH_SEED) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * HASH_PRIME;
+	}
+	return hash;
+}
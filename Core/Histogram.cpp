@@ -0,0 +1,65 @@
+#include "Histogram.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+void OpcodeHistogram::Reset() {
+	memset(counts, 0, sizeof(counts));
+	memset(cycles, 0, sizeof(cycles));
+}
+
+std::vector<OpcodeHistogram::Row> OpcodeHistogram::Rows() const {
+	std::vector<Row> rows;
+	for (int table = 0; table < 2; ++table) {
+		for (int opcode = 0; opcode < 256; ++opcode) {
+			if (counts[table][opcode] > 0) {
+				rows.push_back({ (uint8_t)opcode, table == 1, counts[table][opcode], cycles[table][opcode] });
+			}
+		}
+	}
+
+	std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+		return a.count != b.count ? a.count > b.count : a.cycles > b.cycles;
+	});
+	return rows;
+}
+
+void OpcodeHistogram::Report(std::ostream& out, const size_t count, const Namer& name) const {
+	const std::vector<Row> rows = Rows();
+	uint64_t totalCount = 0, totalCycles = 0, prefixedCount = 0;
+	for (const Row& row : rows) {
+		totalCount += row.count;
+		totalCycles += row.cycles;
+		if (row.prefixed) {
+			prefixedCount += row.count;
+		}
+	}
+
+	const std::ios::fmtflags fmt(out.flags());
+	out << std::fixed << std::setprecision(2);
+	out << "Opcodes: " << totalCount << " instructions, " << totalCycles << " cycles, "
+		<< rows.size() << " distinct, " << (totalCount > 0 ? 100.0 * prefixedCount / totalCount : 0.0) << "% CB-prefixed" << std::endl;
+	out << "Opcode  Mnemonic              Count       %          Cycles       %  Avg" << std::endl;
+
+	for (size_t i = 0; i < rows.size() && i < count; ++i) {
+		const Row& row = rows[i];
+		out << std::hex << std::setfill('0') << (row.prefixed ? "cb " : "   ") << std::setw(2) << (int)row.opcode
+			<< std::dec << std::setfill(' ') << "   " << std::left << std::setw(16) << name(row.opcode, row.prefixed) << std::right
+			<< std::setw(12) << row.count << std::setw(8) << 100.0 * row.count / totalCount
+			<< std::setw(16) << row.cycles << std::setw(8) << 100.0 * row.cycles / totalCycles
+			<< std::setw(5) << std::setprecision(1) << (double)row.cycles / row.count << std::setprecision(2) << std::endl;
+	}
+	out.flags(fmt);
+}
+
+void OpcodeHistogram::WriteCSV(std::ostream& out, const Namer& name) const {
+	const std::ios::fmtflags fmt(out.flags());
+	out << "opcode,prefixed,mnemonic,count,cycles" << std::endl;
+	for (const Row& row : Rows()) {
+		out << std::hex << std::setfill('0') << std::setw(2) << (int)row.opcode << std::dec
+			<< "," << (row.prefixed ? 1 : 0) << ",\"" << name(row.opcode, row.prefixed) << "\","
+			<< row.count << "," << row.cycles << std::endl;
+	}
+	out.flags(fmt);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*! \brief Opcode execution histogram
+ *
+ *  Counts the instructions executed and the cycles they took, per opcode,
+ *  CB-prefixed opcodes apart. Shows which handlers are worth tuning, and
+ *  the instruction mix of a game (to pick benchmark workloads).
+ */
+class OpcodeHistogram final {
+public:
+	//! An opcode's totals
+	struct Row {
+		uint8_t opcode;  //!< Opcode (the one after CB if prefixed)
+		bool prefixed;   //!< CB-prefixed opcode
+		uint64_t count;  //!< Times executed
+		uint64_t cycles; //!< CPU cycles taken
+	};
+
+	//! Gives an opcode's mnemonic
+	using Namer = std::function<std::string(const uint8_t opcode, const bool prefixed)>;
+
+private:
+	uint64_t counts[2][256];  //!< [prefixed][opcode]
+	uint64_t cycles[2][256];
+
+public:
+	OpcodeHistogram() { Reset(); }
+
+	/*! \brief Count an executed instruction
+	 *
+	 *  \param opcode Opcode
+	 *  \param prefixed Opcode after CB (when opcode is CB)
+	 *  \param taken CPU cycles taken
+	 */
+	void Count(const uint8_t opcode, const uint8_t prefixed, const uint64_t taken) {
+		const int table = opcode == 0xcb ? 1 : 0;
+		const uint8_t index = table ? prefixed : opcode;
+		counts[table][index]++;
+		cycles[table][index] += taken;
+	}
+
+	//! Forget everything counted so far
+	void Reset();
+
+	//! Every executed opcode, most executed first
+	std::vector<Row> Rows() const;
+
+	/*! \brief Print the most executed opcodes
+	 *
+	 *  \param out Stream to print to
+	 *  \param count Opcodes to list
+	 *  \param name Gives the mnemonics
+	 */
+	void Report(std::ostream& out, const size_t count, const Namer& name) const;
+
+	/*! \brief Write every executed opcode as CSV
+	 *
+	 *  Columns: opcode, prefixed, mnemonic, count, cycles.
+	 *
+	 *  \param out Stream to write to
+	 *  \param name Gives the mnemonics
+	 */
+	void WriteCSV(std::ostream& out, const Namer& name) const;
+};
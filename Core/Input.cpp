@@ -3,21 +3,42 @@
 
 void setButton(InputData* data, Button button, uint8_t value);
 
-Input::Input() {
-	keyboardBindings[Config::Binding(ButtonB)] = ButtonB;
-	keyboardBindings[Config::Binding(ButtonA)] = ButtonA;
-	keyboardBindings[Config::Binding(ButtonStart)] = ButtonStart;
-	keyboardBindings[Config::Binding(ButtonSelect)] = ButtonSelect;
-	keyboardBindings[Config::Binding(ButtonUp)] = ButtonUp;
-	keyboardBindings[Config::Binding(ButtonDown)] = ButtonDown;
-	keyboardBindings[Config::Binding(ButtonLeft)] = ButtonLeft;
-	keyboardBindings[Config::Binding(ButtonRight)] = ButtonRight;
+// Buttons are active low, packed ones are active high (A, B, Select, Start, Right, Left, Up, Down)
+static uint8_t packButtons(const InputData& data) {
+	return (!data.A) | (!data.B << 1) | (!data.Select << 2) | (!data.Start << 3) |
+		(!data.Right << 4) | (!data.Left << 5) | (!data.Up << 6) | (!data.Down << 7);
+}
+
+static void unpackButtons(InputData* data, const uint8_t buttons) {
+	data->A      = (buttons & 0x01) ? 0 : 1;
+	data->B      = (buttons & 0x02) ? 0 : 1;
+	data->Select = (buttons & 0x04) ? 0 : 1;
+	data->Start  = (buttons & 0x08) ? 0 : 1;
+	data->Right  = (buttons & 0x10) ? 0 : 1;
+	data->Left   = (buttons & 0x20) ? 0 : 1;
+	data->Up     = (buttons & 0x40) ? 0 : 1;
+	data->Down   = (buttons & 0x80) ? 0 : 1;
+}
+
+Input::Input() : Input(Config()) {}
+
+Input::Input(const Config& config) {
+	keyboardBindings[config.Binding(ButtonB)] = ButtonB;
+	keyboardBindings[config.Binding(ButtonA)] = ButtonA;
+	keyboardBindings[config.Binding(ButtonStart)] = ButtonStart;
+	keyboardBindings[config.Binding(ButtonSelect)] = ButtonSelect;
+	keyboardBindings[config.Binding(ButtonUp)] = ButtonUp;
+	keyboardBindings[config.Binding(ButtonDown)] = ButtonDown;
+	keyboardBindings[config.Binding(ButtonLeft)] = ButtonLeft;
+	keyboardBindings[config.Binding(ButtonRight)] = ButtonRight;
 
 	// Set all buttons to "not pressed" (1)
 	data.A = data.B = data.Down = data.Up = data.Left = data.Right = data.Start = data.Select = 1;
+	pending = data;
 
 	// Set interrupt trigger to false
 	buttonPressed = false;
+	pendingEvent = pendingPressed = false;
 }
 
 void Input::HandleInputEvent(SDL_Event event) {
@@ -27,15 +48,50 @@ void Input::HandleInputEvent(SDL_Event event) {
 		auto iter = keyboardBindings.find(event.key.keysym.scancode);
 		if (iter != keyboardBindings.end()) {
 			bool pressed = event.key.state == SDL_PRESSED;
-			setButton(&data, iter->second, pressed ? 0 : 1);
+			setButton(&pending, iter->second, pressed ? 0 : 1);
 
 			// Enable interrupt if button pressed
-			buttonPressed = pressed;
+			pendingEvent = true;
+			pendingPressed = pressed;
 		}
 		break;
 	}
 }
 
+void Input::Latch() {
+	unpackButtons(&data, packButtons(pending));
+
+	if (pendingEvent) {
+		buttonPressed = pendingPressed;
+		pendingEvent = false;
+	}
+}
+
+void Input::DropPending() {
+	pending = data;
+	pendingEvent = pendingPressed = false;
+}
+
+void Input::QueueButtons(const uint8_t buttons) {
+	const uint8_t held = packButtons(pending);
+	if (buttons == held) {
+		return;
+	}
+	unpackButtons(&pending, buttons);
+
+	// Joypad interrupt when a button goes down
+	pendingEvent = true;
+	pendingPressed = (buttons & ~held) != 0;
+}
+
+uint8_t Input::GetButtons() const {
+	return packButtons(data);
+}
+
+void Input::SetButtons(const uint8_t buttons) {
+	unpackButtons(&data, buttons);
+}
+
 void setButton(InputData* data, Button button, uint8_t value) {
 	switch (button) {
 	case ButtonA:
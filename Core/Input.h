@@ -62,10 +62,16 @@ enum Button {
 	ButtonSelect
 };
 
+class Config;
+
 class Input {
 private:
 	std::map<SDL_Keycode, Button> keyboardBindings;
 
+	InputData pending;        //!< Buttons received since the last Latch()
+	bool pendingEvent;        //!< A button event was received since the last Latch()
+	bool pendingPressed;      //!< Last button event was a press
+
 public:
 	InputData data;     //!< Input data for reading
 	bool buttonPressed; //!< Has a button been pressed? (interrupt check)
@@ -78,5 +84,44 @@ public:
 	 */
 	void HandleInputEvent(SDL_Event event);
 
+	/*! \brief Apply the input received since the last call
+	 *
+	 *  Events are only handed to the game once a frame (at VBlank), so
+	 *  each frame sees a single joypad state and input can be replayed
+	 *  on the exact same cycle.
+	 */
+	void Latch();
+
+	/*! \brief Forget the input received since the last Latch()
+	 *
+	 *  Used when the machine state is replaced, so the next frame
+	 *  starts from the restored buttons.
+	 */
+	void DropPending();
+
+	/*! \brief Get the buttons currently held
+	 *
+	 *  \return One bit per held button (A, B, Select, Start, Right, Left, Up, Down from bit 0)
+	 */
+	uint8_t GetButtons() const;
+
+	/*! \brief Set the buttons held, bypassing the pending events
+	 *
+	 *  \param buttons One bit per held button (see GetButtons)
+	 */
+	void SetButtons(const uint8_t buttons);
+
+	/*! \brief Hold buttons from the next frame
+	 *
+	 *  Same as pressing/releasing the bound keys (for scripted input).
+	 *
+	 *  \param buttons One bit per held button (see GetButtons)
+	 */
+	void QueueButtons(const uint8_t buttons);
+
+	//! Create an input manager with the default key bindings
 	Input();
+
+	//! Create an input manager with the key bindings of a configuration
+	explicit Input(const Config& config);
 };
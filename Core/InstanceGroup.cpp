@@ -0,0 +1,111 @@
+#include "InstanceGroup.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <map>
+
+const int InstanceGroup::DEFAULT_MERGE_EVERY;
+
+InstanceGroup::InstanceGroup(const Emulator& base, const size_t count, const int mergeEvery)
+	: slots(count, 0), mergeEvery(mergeEvery) {
+	// Everyone starts on the same machine
+	machines.push_back(base.Fork());
+}
+
+void InstanceGroup::split(const std::vector<uint8_t>& actions) {
+	// Machine running each (machine, buttons) pair this frame
+	std::map<std::pair<size_t, uint8_t>, size_t> targets;
+	std::vector<bool> claimed(machines.size(), false);
+	machineActions.resize(machines.size());
+
+	for (size_t i = 0; i < slots.size(); ++i) {
+		const size_t machine = slots[i];
+		const std::pair<size_t, uint8_t> key(machine, actions[i]);
+		const auto target = targets.find(key);
+		if (target != targets.end()) {
+			slots[i] = target->second;
+			continue;
+		}
+
+		// First buttons seen keep the machine, others get a fork
+		size_t index = machine;
+		if (claimed[machine]) {
+			index = machines.size();
+			machines.push_back(machines[machine]->Fork());
+			machineActions.push_back(0);
+		} else {
+			claimed[machine] = true;
+		}
+		machineActions[index] = actions[i];
+		targets[key] = index;
+		slots[i] = index;
+	}
+}
+
+bool InstanceGroup::identical(const Emulator& a, const Emulator& b) {
+	if (a.running != b.running || memcmp(a.gpu.screen, b.gpu.screen, sizeof(a.gpu.screen)) != 0) {
+		return false;
+	}
+	SaveState::Save(a, first);
+	SaveState::Save(b, second);
+	return first == second;
+}
+
+void InstanceGroup::merge() {
+	std::vector<ChunkHash> chunks;
+	machineHashes.resize(machines.size());
+	for (size_t i = 0; i < machines.size(); ++i) {
+		const Emulator& machine = *machines[i];
+		machineHashes[i] = HashBytes(machine.gpu.screen, sizeof(machine.gpu.screen), SaveState::Hash(machine, chunks));
+	}
+
+	// Where each machine goes: itself or an identical one before it
+	std::vector<size_t> remap(machines.size());
+	std::multimap<uint64_t, size_t> seen;
+	size_t kept = 0;
+	for (size_t i = 0; i < machines.size(); ++i) {
+		remap[i] = SIZE_MAX;
+		const auto range = seen.equal_range(machineHashes[i]);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (identical(*machines[remap[it->second]], *machines[i])) {
+				remap[i] = remap[it->second];
+				break;
+			}
+		}
+		if (remap[i] != SIZE_MAX) {
+			machines[i].reset();
+			continue;
+		}
+		seen.insert(std::make_pair(machineHashes[i], i));
+		remap[i] = kept;
+		if (kept != i) {
+			machines[kept] = std::move(machines[i]);
+		}
+		kept += 1;
+	}
+
+	machines.resize(kept);
+	for (size_t& slot : slots) {
+		slot = remap[slot];
+	}
+}
+
+void InstanceGroup::RunFrame(const std::vector<uint8_t>& actions) {
+	split(actions);
+
+	for (size_t i = 0; i < machines.size(); ++i) {
+		Emulator& machine = *machines[i];
+		machine.input.QueueButtons(machineActions[i]);
+		machine.RunFrame();
+	}
+
+	frames += 1;
+	machineFrames += machines.size();
+	if (mergeEvery > 0 && machines.size() > 1 && frames % mergeEvery == 0) {
+		merge();
+	}
+}
+
+double InstanceGroup::Sharing() const {
+	return machineFrames == 0 ? 1.0 : (double)(frames * slots.size()) / machineFrames;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Emulator.h"
+
+/*! \brief Many instances of a game, emulated together
+ *
+ *  Instances in the exact same state that receive the same input keep
+ *  doing the same thing, so they share one machine and it only runs once
+ *  per frame. An instance gets its own machine (forked, cheap) as soon as
+ *  its input differs from the others on it, and machines that end up in the
+ *  same state again (ie. back to the same menu) are merged.
+ *
+ *  Intro screens, menus and attract modes run once for the whole group.
+ *
+ *  Looking for machines to merge hashes every machine's whole state, which
+ *  costs more than a frame of emulation: it's only done every few frames.
+ */
+class InstanceGroup final {
+public:
+	static const int DEFAULT_MERGE_EVERY = 60; //!< Frames between merge checks (one emulated second)
+
+private:
+	std::vector<std::unique_ptr<Emulator>> machines;
+	std::vector<size_t> slots;           //!< Machine of each instance
+	std::vector<uint8_t> machineActions; //!< Buttons each machine holds this frame
+	std::vector<uint64_t> machineHashes; //!< State + screen hash of each machine (merge)
+	std::vector<uint8_t> first, second;  //!< State buffers (merge check)
+	int mergeEvery;
+	uint64_t frames = 0;                 //!< Frames run by the group
+	uint64_t machineFrames = 0;          //!< Frames actually emulated
+
+	//! Give instances whose input differs from their machine's their own machine
+	void split(const std::vector<uint8_t>& actions);
+
+	//! Share machines that are in the same state
+	void merge();
+
+	//! Are two machines in the exact same state (and showing the same frame)?
+	bool identical(const Emulator& a, const Emulator& b);
+
+public:
+	/*! \brief Start a group of identical instances
+	 *
+	 *  \param base Machine every instance starts from (forked)
+	 *  \param count Number of instances
+	 *  \param mergeEvery Look for machines to merge every N frames (0: never)
+	 */
+	InstanceGroup(const Emulator& base, const size_t count, const int mergeEvery = DEFAULT_MERGE_EVERY);
+
+	InstanceGroup(const InstanceGroup&) = delete;
+	InstanceGroup& operator=(const InstanceGroup&) = delete;
+
+	/*! \brief Run every instance for a frame
+	 *
+	 *  \param actions Buttons each instance holds (see Input::GetButtons)
+	 */
+	void RunFrame(const std::vector<uint8_t>& actions);
+
+	//! Machine an instance is running on (shared with others in the same state)
+	const Emulator& Instance(const size_t index) const { return *machines[slots[index]]; }
+
+	//! Number of instances
+	size_t Count() const { return slots.size(); }
+
+	//! Number of machines currently emulated
+	size_t Machines() const { return machines.size(); }
+
+	//! Instance frames per emulated frame so far (1 when nothing is shared)
+	double Sharing() const;
+};
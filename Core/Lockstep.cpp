@@ -0,0 +1,126 @@
+#include "Lockstep.h"
+#include "Hash.h"
+
+#include <thread>
+
+LockstepChecker::LockstepChecker(const std::string& romfile, EmulatorFlags flags, const Config& config,
+	const uint64_t frames, const int every, const bool compareRenderers)
+	: frames(frames), every(every < 1 ? 1 : every), compareRenderers(compareRenderers) {
+	flags.headless = true;
+	flags.audio = false;
+	flags.rewindEvery = 0;
+	flags.hashEvery = 0;
+	flags.movieRecord.clear();
+
+	for (int i = 0; i < 2; ++i) {
+		instances[i].emulator.reset(new Emulator(romfile, flags, config));
+	}
+	if (compareRenderers) {
+		instances[0].emulator->gpu.renderMode = Render_Scanline;
+		instances[1].emulator->gpu.renderMode = Render_FIFO;
+	}
+}
+
+void LockstepChecker::runInstance(Instance& instance) {
+	Emulator& emulator = *instance.emulator;
+	const uint64_t last = emulator.FrameCount() + frames;
+
+	while (emulator.running && emulator.FrameCount() < last) {
+		emulator.RunFrame();
+
+		if (emulator.FrameCount() % every != 0) {
+			continue;
+		}
+
+		Checkpoint checkpoint;
+		checkpoint.frame = emulator.FrameCount();
+		if (!compareRenderers) {
+			SaveState::Hash(emulator, checkpoint.chunks);
+		}
+		checkpoint.screen = HashBytes(emulator.gpu.screen, sizeof(emulator.gpu.screen));
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping) {
+			break;
+		}
+		instance.checkpoints.push_back(std::move(checkpoint));
+		changed.notify_all();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	instance.done = true;
+	changed.notify_all();
+}
+
+std::string LockstepChecker::compare(const Checkpoint& first, const Checkpoint& second) const {
+	// Comparing renderers leaves the chunks out: their timing differs by design (see class)
+	for (size_t i = 0; i < first.chunks.size(); ++i) {
+		if (first.chunks[i].hash != second.chunks[i].hash) {
+			return first.chunks[i].tag;
+		}
+	}
+	if (first.screen != second.screen) {
+		return "LCD";
+	}
+	return "";
+}
+
+Divergence LockstepChecker::Run() {
+	for (Instance& instance : instances) {
+		if (!instance.emulator->init()) {
+			throw std::runtime_error("Could not start the emulator");
+		}
+	}
+
+	std::thread threads[2] = {
+		std::thread(&LockstepChecker::runInstance, this, std::ref(instances[0])),
+		std::thread(&LockstepChecker::runInstance, this, std::ref(instances[1]))
+	};
+
+	Divergence result = { false, 0, "", 0 };
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		Instance& first = instances[0];
+		Instance& second = instances[1];
+		while (true) {
+			changed.wait(lock, [&] {
+				return (!first.checkpoints.empty() && !second.checkpoints.empty()) ||
+					(first.done && first.checkpoints.empty()) || (second.done && second.checkpoints.empty());
+			});
+
+			// Compare whatever both runs reached
+			while (!first.checkpoints.empty() && !second.checkpoints.empty()) {
+				const Checkpoint& a = first.checkpoints.front();
+				const Checkpoint& b = second.checkpoints.front();
+				result.frame = a.frame;
+				result.subsystem = a.frame != b.frame ? "EMU" : compare(a, b);
+				if (!result.subsystem.empty()) {
+					result.found = true;
+					break;
+				}
+				result.frames = a.frame;
+				first.checkpoints.pop_front();
+				second.checkpoints.pop_front();
+			}
+			if (result.found) {
+				break;
+			}
+
+			// One run stopped (ie. movie over), the other must have too
+			if ((first.done && first.checkpoints.empty()) || (second.done && second.checkpoints.empty())) {
+				changed.wait(lock, [&] { return first.done && second.done; });
+				if (!first.checkpoints.empty() || !second.checkpoints.empty()) {
+					result.found = true;
+					result.frame = result.frames + 1;
+					result.subsystem = "end";
+				}
+				break;
+			}
+		}
+		stopping = true;
+	}
+
+	threads[0].join();
+	threads[1].join();
+	return result;
+}
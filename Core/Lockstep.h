@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Emulator.h"
+
+//! Result of a lockstep run
+struct Divergence {
+	bool found;             //!< The runs diverged
+	uint64_t frame;         //!< First frame whose state differs
+	std::string subsystem;  //!< First differing chunk (CPU, MMU, WRAM...), LCD for the screen, "end" if a run stopped early
+	uint64_t frames;        //!< Frames compared
+};
+
+/*! \brief Determinism checker
+ *
+ *  Runs the same ROM (and movie, if any) on two headless emulators in
+ *  parallel threads, hashing their state every N frames, and stops at the
+ *  first checkpoint where they differ.
+ *
+ *  The second instance can use the pixel FIFO renderer, to compare both
+ *  rendering backends. Only the screens are compared then: the FIFO makes
+ *  mode 3 as long as the pixels it pushed (and HBlank shorter), so STAT
+ *  modes, interrupt timing and everything the game does with them
+ *  (CPU, RAM) can rightly differ between backends.
+ */
+class LockstepChecker final {
+private:
+	//! Machine state at a frame
+	struct Checkpoint {
+		uint64_t frame;
+		std::vector<ChunkHash> chunks;  //!< Empty when comparing renderers
+		uint64_t screen;
+	};
+
+	//! One of the two runs
+	struct Instance {
+		std::unique_ptr<Emulator> emulator;
+		std::deque<Checkpoint> checkpoints;  //!< Not compared yet
+		bool done = false;
+	};
+
+	Instance instances[2];
+	uint64_t frames;
+	int every;
+	bool compareRenderers;
+
+	bool stopping = false;
+	std::mutex mutex;
+	std::condition_variable changed;
+
+	//! Run an instance and queue its checkpoints (instance thread)
+	void runInstance(Instance& instance);
+
+	//! Compare two checkpoints, returns the first differing subsystem (or "")
+	std::string compare(const Checkpoint& first, const Checkpoint& second) const;
+
+public:
+	/*! \brief Prepare two identical runs
+	 *
+	 *  \param romfile ROM to run
+	 *  \param flags Emulator options (ie. movie to play), headless is forced
+	 *  \param config Emulator configuration
+	 *  \param frames Frames to run (or until the movie ends)
+	 *  \param every Compare states every N frames
+	 *  \param compareRenderers Run the second instance with the pixel FIFO renderer, compare screens only
+	 */
+	LockstepChecker(const std::string& romfile, EmulatorFlags flags, const Config& config,
+		const uint64_t frames, const int every = 1, const bool compareRenderers = false);
+
+	LockstepChecker(const LockstepChecker&) = delete;
+	LockstepChecker& operator=(const LockstepChecker&) = delete;
+
+	/*! \brief Run both instances until they diverge or finish
+	 *
+	 *  \return Where the runs diverged, if they did
+	 */
+	Divergence Run();
+};
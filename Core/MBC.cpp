@@ -21,12 +21,15 @@ void MBC::LoadROM(const ROMHeader& _header, const std::vector<uint8_t>& bytes) {
 	}
 
 	// Read banks from buffer
-	banks.reserve(bankCount);
+	std::shared_ptr<std::vector<ROMBank>> romBanks = std::make_shared<std::vector<ROMBank>>();
+	romBanks->reserve(bankCount);
 	for (int i = 0; i < bankCount; i += 1) {
 		ROMBank b;
 		std::copy(bytes.begin() + 16 * 1024 * i, bytes.begin() + 16 * 1024 * (i + 1), b.bytes);
-		banks.push_back(b);
+		romBanks->push_back(b);
 	}
+	romData = romBanks;
+	banks = romData->data();
 
 	// Setup RAM banks
 	int ramcount = 0;
@@ -42,9 +45,6 @@ void MBC::LoadROM(const ROMHeader& _header, const std::vector<uint8_t>& bytes) {
 	case RAM_128KB:
 		ramcount = 16; break;
 	}
-	ram.reserve(ramcount);
-	for (int i = 0; i < ramcount; i++) {
-		RAMBank bank;
-		ram.push_back(bank);
-	}
+	// Zeroed, so runs (and their state hashes) are reproducible
+	ram = PagedMemory(ramcount * sizeof(RAMBank));
 }
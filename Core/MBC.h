@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <cstdint>
 
 #include "ROM.Data.h"
+#include "PagedMemory.h"
 
 //! Single ROM Bank, holding 16KB of code/data
 struct ROMBank {
@@ -15,20 +17,32 @@ struct RAMBank {
 	uint8_t bytes[8 * 1024];
 };
 
-class MBC {
+/*! \brief Memory bank controller state
+ *
+ *  Banking registers, kept in a plain struct so they can be saved and
+ *  restored with a single copy (see SaveState). RAM banks are saved separately.
+ */
+struct MBCState {
+	uint8_t romBankId;          //!< Current ROM bank id
+	uint8_t ramBankId;          //!< Current RAM bank id
+	bool ramEnabled;            //!< RAM Enable flag (MBC1+)
+	bool ramBankingEnable;      //!< Upper bank bits select the RAM bank (MBC1)
+};
+
+class MBC : public MBCState {
+	friend class SaveState;
 protected:
-	std::vector<ROMBank> banks; //!< Switchable bank     (0000-7fff)
-	std::vector<RAMBank> ram;   //!< Switchable RAM bank (a000-bfff)
-	uint8_t romBankId = 0;      //!< Current ROM bank id
-	uint8_t ramBankId = 0;      //!< Current RAM bank id
+	std::shared_ptr<const std::vector<ROMBank>> romData; //!< ROM banks, shared by all clones
+	const ROMBank* banks;       //!< Switchable bank     (0000-7fff)
+	PagedMemory ram;            //!< Switchable RAM bank (a000-bfff), copy-on-write between clones
 
 	bool hasRam = false;        //!< Enabled if the ROM has RAM
 	bool hasBattery = false;    //!< Enabled if the ROM has battery
 
-	bool ramEnabled = false;    //!< RAM Enable flag (MBC1+)
-
 	ROMHeader header;           //!< ROM Header
 
+	MBC() : MBCState(), banks(nullptr) {}
+
 public:
 	virtual ~MBC() {}
 
@@ -38,6 +52,14 @@ public:
 	//! Write to MBC or special registers
 	virtual void Write(const uint16_t, const uint8_t) = 0;
 
+	//! Copy of the controller, sharing the ROM and (until written) the RAM
+	virtual MBC* Clone() const = 0;
+
+	//! Byte of any ROM bank, mapped or not (0xff past the end of the ROM)
+	uint8_t ReadROM(const size_t bank, const uint16_t offset) const {
+		return bank < romData->size() ? (*romData)[bank].bytes[offset & 0x3fff] : 0xff;
+	}
+
 	//! Create the required banks and fill them with ROM data
 	void LoadROM(const ROMHeader& header, const std::vector<uint8_t>& data);
 };
@@ -46,17 +68,16 @@ class NoMBC : public MBC {
 public:
 	uint8_t Read(const uint16_t location) const override;
 	void Write(const uint16_t location, const uint8_t value) override;
+	NoMBC* Clone() const override { return new NoMBC(*this); }
 
 	NoMBC(const ROMType type);
 };
 
 class MBC1 : public MBC {
-private:
-	bool ramBankingEnable = false;
-
 public:
 	uint8_t Read(const uint16_t location) const override;
 	void Write(const uint16_t location, const uint8_t value) override;
+	MBC1* Clone() const override { return new MBC1(*this); }
 
 	MBC1(const ROMType type);
 };
@@ -65,6 +86,7 @@ class MBC3: public MBC {
 public:
 	uint8_t Read(const uint16_t location) const override;
 	void Write(const uint16_t location, const uint8_t value) override;
+	MBC3* Clone() const override { return new MBC3(*this); }
 
 	MBC3(const ROMType type);
 };
@@ -1,4 +1,5 @@
 #include "../MBC.h"
+#include "../Trace.h"
 
 #include <stdexcept>
 
@@ -30,7 +31,7 @@ uint8_t MBC1::Read(const uint16_t location) const {
 				throw std::domain_error("Trying to access inexistant RAM memory (>2k)");
 			}
 
-			return ram[ramBankId].bytes[location - 0xa000];
+			return ram.Read(ramBankId * sizeof(RAMBank) + location - 0xa000);
 		} else {
 			throw std::domain_error("Trying to access inexistent RAM memory (RAM not available)");
 		}
@@ -40,6 +41,8 @@ uint8_t MBC1::Read(const uint16_t location) const {
 }
 
 void MBC1::Write(const uint16_t location, const uint8_t value) {
+	MFEMU_ZONE_FINE("MBC1::Write");
+
 	// RAM Enable flag (true if lower 4 bits are 0xa)
 	if (location < 0x2000) {
 		ramEnabled = (value & 0xf) == 0xa;
@@ -87,7 +90,7 @@ void MBC1::Write(const uint16_t location, const uint8_t value) {
 				throw std::domain_error("Trying to write to inexistant RAM memory (>2k)");
 			}
 
-			ram[ramBankId].bytes[location - 0xa000] = value;
+			ram.Write(ramBankId * sizeof(RAMBank) + location - 0xa000, value);
 			return;
 		} else {
 			throw std::domain_error("Trying to write to inexistent RAM memory (RAM not available)");
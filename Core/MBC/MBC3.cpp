@@ -1,4 +1,5 @@
 #include "../MBC.h"
+#include "../Trace.h"
 
 #include <stdexcept>
 
@@ -24,7 +25,7 @@ uint8_t MBC3::Read(const uint16_t location) const {
 	// External RAM (on cartridge)
 	if (hasRam) {
 		if (location < 0xc000) {
-			return ram[ramBankId].bytes[location - 0xa000];
+			return ram.Read(ramBankId * sizeof(RAMBank) + location - 0xa000);
 		}
 	} else {
 		throw std::domain_error("Trying to access inexistent RAM memory");
@@ -34,5 +35,7 @@ uint8_t MBC3::Read(const uint16_t location) const {
 }
 
 void MBC3::Write(const uint16_t location, const uint8_t value) {
+	MFEMU_ZONE_FINE("MBC3::Write");
+
 	//TODO
 }
@@ -8,10 +8,18 @@ using IOHandlerW = std::function<void(MMU* mmu, uint8_t value)>;
 const static IOHandlerR emptyR = [](MMU*) { return 0; };
 const static IOHandlerW emptyW = [](MMU*, uint8_t) { return; };
 
+// Sound registers are all handled by the APU
+static IOHandlerR apuR(const uint16_t location) {
+	return [location](MMU* mmu) { return mmu->apu->Read(location); };
+}
+static IOHandlerW apuW(const uint16_t location) {
+	return [location](MMU* mmu, uint8_t value) { mmu->apu->Write(location, value); };
+}
+
 const static IOHandlerR getters[] = {
 	[](MMU* mmu) { return mmu->input->data.GetRegister(); }, // ff00 Joypad port
-	emptyR, // ff01 Serial IO data
-	emptyR, // ff02 Serial IO control
+	[](MMU* mmu) { return mmu->serialData;       }, // ff01 Serial IO data
+	[](MMU* mmu) { return (uint8_t)(mmu->serialControl | 0x7e); }, // ff02 Serial IO control
 	emptyR, // ff03 <empty>
 	[](MMU* mmu) { return mmu->divider;          }, // ff04 Divider
 	[](MMU* mmu) { return mmu->timerCounter;     }, // ff05 Timer counter
@@ -25,29 +33,29 @@ const static IOHandlerR getters[] = {
 	emptyR, // ff0d <empty>
 	emptyR, // ff0e <empty>
 	[](MMU* mmu) { return mmu->interruptFlags.raw; }, // ff0f Interrupt flags
-	emptyR, // ff10 Sweep (Sound mode #1)
-	emptyR, // ff11 Sound length / Pattern duty (Sound mode #1)
-	emptyR, // ff12 Control (Sound mode #1)
-	emptyR, // ff13 Frequency low (Sound mode #1)
-	emptyR, // ff14 Frequency high (Sound mode #1)
+	apuR(0xff10), // ff10 Sweep (Sound mode #1)
+	apuR(0xff11), // ff11 Sound length / Pattern duty (Sound mode #1)
+	apuR(0xff12), // ff12 Control (Sound mode #1)
+	apuR(0xff13), // ff13 Frequency low (Sound mode #1)
+	apuR(0xff14), // ff14 Frequency high (Sound mode #1)
 	emptyR, // ff15 <empty>
-	emptyR, // ff16 Sound length / Pattern duty (Sound mode #2)
-	emptyR, // ff17 Control (Sound mode #2)
-	emptyR, // ff18 Frequency low (Sound mode #2)
-	emptyR, // ff19 Frequency high (Sound mode #2)
-	emptyR, // ff1a Control (Sound mode #3)
-	emptyR, // ff1b Sound length (Sound mode #3)
-	emptyR, // ff1c Output level (Sound mode #3)
-	emptyR, // ff1d Frequency low (Sound mode #3)
-	emptyR, // ff1e Frequency high (Sound mode #3)
+	apuR(0xff16), // ff16 Sound length / Pattern duty (Sound mode #2)
+	apuR(0xff17), // ff17 Control (Sound mode #2)
+	apuR(0xff18), // ff18 Frequency low (Sound mode #2)
+	apuR(0xff19), // ff19 Frequency high (Sound mode #2)
+	apuR(0xff1a), // ff1a Control (Sound mode #3)
+	apuR(0xff1b), // ff1b Sound length (Sound mode #3)
+	apuR(0xff1c), // ff1c Output level (Sound mode #3)
+	apuR(0xff1d), // ff1d Frequency low (Sound mode #3)
+	apuR(0xff1e), // ff1e Frequency high (Sound mode #3)
 	emptyR, // ff1f <empty>
-	emptyR, // ff20 Sound length / Pattern duty (Sound mode #4)
-	emptyR, // ff21 Control (Sound mode #4)
-	emptyR, // ff22 Polynomial counter (Sound mode #4)
-	emptyR, // ff23 Frequency high (Sound mode #4)
-	emptyR, // ff24 Channel / Volume control
-	emptyR, // ff25 Sound output terminal selector
-	emptyR, // ff26 Sound ON/OFF
+	apuR(0xff20), // ff20 Sound length / Pattern duty (Sound mode #4)
+	apuR(0xff21), // ff21 Control (Sound mode #4)
+	apuR(0xff22), // ff22 Polynomial counter (Sound mode #4)
+	apuR(0xff23), // ff23 Frequency high (Sound mode #4)
+	apuR(0xff24), // ff24 Channel / Volume control
+	apuR(0xff25), // ff25 Sound output terminal selector
+	apuR(0xff26), // ff26 Sound ON/OFF
 	emptyR, // ff27 <empty>
 	emptyR, // ff28 <empty>
 	emptyR, // ff29 <empty>
@@ -57,22 +65,22 @@ const static IOHandlerR getters[] = {
 	emptyR, // ff2d <empty>
 	emptyR, // ff2e <empty>
 	emptyR, // ff2f <empty>
-	emptyR, // ff30 <empty>
-	emptyR, // ff31 <empty>
-	emptyR, // ff32 <empty>
-	emptyR, // ff33 <empty>
-	emptyR, // ff34 <empty>
-	emptyR, // ff35 <empty>
-	emptyR, // ff36 <empty>
-	emptyR, // ff37 <empty>
-	emptyR, // ff38 <empty>
-	emptyR, // ff39 <empty>
-	emptyR, // ff3a <empty>
-	emptyR, // ff3b <empty>
-	emptyR, // ff3c <empty>
-	emptyR, // ff3d <empty>
-	emptyR, // ff3e <empty>
-	emptyR, // ff3f <empty>
+	apuR(0xff30), // ff30 Wave pattern RAM
+	apuR(0xff31), // ff31 Wave pattern RAM
+	apuR(0xff32), // ff32 Wave pattern RAM
+	apuR(0xff33), // ff33 Wave pattern RAM
+	apuR(0xff34), // ff34 Wave pattern RAM
+	apuR(0xff35), // ff35 Wave pattern RAM
+	apuR(0xff36), // ff36 Wave pattern RAM
+	apuR(0xff37), // ff37 Wave pattern RAM
+	apuR(0xff38), // ff38 Wave pattern RAM
+	apuR(0xff39), // ff39 Wave pattern RAM
+	apuR(0xff3a), // ff3a Wave pattern RAM
+	apuR(0xff3b), // ff3b Wave pattern RAM
+	apuR(0xff3c), // ff3c Wave pattern RAM
+	apuR(0xff3d), // ff3d Wave pattern RAM
+	apuR(0xff3e), // ff3e Wave pattern RAM
+	apuR(0xff3f), // ff3f Wave pattern RAM
 	[](MMU* mmu) { return mmu->gpu->lcdControl.raw; },     // ff40 LCD Control
 	[](MMU* mmu) { return mmu->gpu->lcdStatus.raw;  },     // ff41 LCD Status
 	[](MMU* mmu) { return mmu->gpu->bgScrollY; },          // ff42 Background vertical scrolling
@@ -141,8 +149,19 @@ const static IOHandlerR getters[] = {
 
 const static IOHandlerW setters[] = {
 	[](MMU* mmu, uint8_t value) { mmu->input->data.SetRegister(value); }, // ff00 Joypad port
-	emptyW, // ff01 Serial IO data
-	emptyW, // ff02 Serial IO control
+	[](MMU* mmu, uint8_t value) { mmu->serialData = value; }, // ff01 Serial IO data
+	[](MMU* mmu, uint8_t value) {                             // ff02 Serial IO control
+		mmu->serialControl = value;
+		// Transfer with the internal clock: done at once, with no partner
+		if ((value & 0x81) == 0x81) {
+			if (mmu->serialOutput) {
+				mmu->serialOutput(mmu->serialData);
+			}
+			mmu->serialData = 0xff;
+			mmu->serialControl &= 0x7f;
+			mmu->SetInterrupt(IntEndSerialIO);
+		}
+	},
 	emptyW, // ff03 <empty>
 	[](MMU* mmu, uint8_t)       { mmu->divider = 0;              }, // ff04 Divider
 	[](MMU* mmu, uint8_t value) { mmu->timerCounter = value;     }, // ff05 Timer counter
@@ -156,29 +175,29 @@ const static IOHandlerW setters[] = {
 	emptyW, // ff0d <empty>
 	emptyW, // ff0e <empty>
 	[](MMU* mmu, uint8_t value) { mmu->interruptFlags.raw = value; }, // ff0f Interrupt flags
-	emptyW, // ff10 Sweep (Sound mode #1)
-	emptyW, // ff11 Sound length / Pattern duty (Sound mode #1)
-	emptyW, // ff12 Control (Sound mode #1)
-	emptyW, // ff13 Frequency low (Sound mode #1)
-	emptyW, // ff14 Frequency high (Sound mode #1)
+	apuW(0xff10), // ff10 Sweep (Sound mode #1)
+	apuW(0xff11), // ff11 Sound length / Pattern duty (Sound mode #1)
+	apuW(0xff12), // ff12 Control (Sound mode #1)
+	apuW(0xff13), // ff13 Frequency low (Sound mode #1)
+	apuW(0xff14), // ff14 Frequency high (Sound mode #1)
 	emptyW, // ff15 <empty>
-	emptyW, // ff16 Sound length / Pattern duty (Sound mode #2)
-	emptyW, // ff17 Control (Sound mode #2)
-	emptyW, // ff18 Frequency low (Sound mode #2)
-	emptyW, // ff19 Frequency high (Sound mode #2)
-	emptyW, // ff1a Control (Sound mode #3)
-	emptyW, // ff1b Sound length (Sound mode #3)
-	emptyW, // ff1c Output level (Sound mode #3)
-	emptyW, // ff1d Frequency low (Sound mode #3)
-	emptyW, // ff1e Frequency high (Sound mode #3)
+	apuW(0xff16), // ff16 Sound length / Pattern duty (Sound mode #2)
+	apuW(0xff17), // ff17 Control (Sound mode #2)
+	apuW(0xff18), // ff18 Frequency low (Sound mode #2)
+	apuW(0xff19), // ff19 Frequency high (Sound mode #2)
+	apuW(0xff1a), // ff1a Control (Sound mode #3)
+	apuW(0xff1b), // ff1b Sound length (Sound mode #3)
+	apuW(0xff1c), // ff1c Output level (Sound mode #3)
+	apuW(0xff1d), // ff1d Frequency low (Sound mode #3)
+	apuW(0xff1e), // ff1e Frequency high (Sound mode #3)
 	emptyW, // ff1f <empty>
-	emptyW, // ff20 Sound length / Pattern duty (Sound mode #4)
-	emptyW, // ff21 Control (Sound mode #4)
-	emptyW, // ff22 Polynomial counter (Sound mode #4)
-	emptyW, // ff23 Frequency high (Sound mode #4)
-	emptyW, // ff24 Channel / Volume control
-	emptyW, // ff25 Sound output terminal selector
-	emptyW, // ff26 Sound ON/OFF
+	apuW(0xff20), // ff20 Sound length / Pattern duty (Sound mode #4)
+	apuW(0xff21), // ff21 Control (Sound mode #4)
+	apuW(0xff22), // ff22 Polynomial counter (Sound mode #4)
+	apuW(0xff23), // ff23 Frequency high (Sound mode #4)
+	apuW(0xff24), // ff24 Channel / Volume control
+	apuW(0xff25), // ff25 Sound output terminal selector
+	apuW(0xff26), // ff26 Sound ON/OFF
 	emptyW, // ff27 <empty>
 	emptyW, // ff28 <empty>
 	emptyW, // ff29 <empty>
@@ -188,34 +207,39 @@ const static IOHandlerW setters[] = {
 	emptyW, // ff2d <empty>
 	emptyW, // ff2e <empty>
 	emptyW, // ff2f <empty>
-	emptyW, // ff30 <empty>
-	emptyW, // ff31 <empty>
-	emptyW, // ff32 <empty>
-	emptyW, // ff33 <empty>
-	emptyW, // ff34 <empty>
-	emptyW, // ff35 <empty>
-	emptyW, // ff36 <empty>
-	emptyW, // ff37 <empty>
-	emptyW, // ff38 <empty>
-	emptyW, // ff39 <empty>
-	emptyW, // ff3a <empty>
-	emptyW, // ff3b <empty>
-	emptyW, // ff3c <empty>
-	emptyW, // ff3d <empty>
-	emptyW, // ff3e <empty>
-	emptyW, // ff3f <empty>
-	[](MMU* mmu, uint8_t value) { mmu->gpu->lcdControl.raw = value; },     // ff40 LCD Control
-	[](MMU* mmu, uint8_t value) { mmu->gpu->lcdStatus.raw = value;  },     // ff41 LCD Status
-	[](MMU* mmu, uint8_t value) { mmu->gpu->bgScrollY = value; },          // ff42 Background vertical scrolling
-	[](MMU* mmu, uint8_t value) { mmu->gpu->bgScrollX = value; },          // ff43 Background horizontal scrolling
-	[](MMU* mmu, uint8_t)       { mmu->gpu->line = 0; },                   // ff44 Current scanline (reset on set)
-	[](MMU* mmu, uint8_t value) { mmu->gpu->coincidence = value; },        // ff45 Scanline comparison
-	emptyW, // ff46 DMA transfer control
-	[](MMU* mmu, uint8_t value) { mmu->gpu->bgPalette.raw = value; },      // ff47 Background palette
-	[](MMU* mmu, uint8_t value) { mmu->gpu->spritePalette1.raw = value; }, // ff48 Sprite palette #0
-	[](MMU* mmu, uint8_t value) { mmu->gpu->spritePalette2.raw = value; }, // ff49 Sprite palette #1
-	[](MMU* mmu, uint8_t value) { mmu->gpu->winScrollY = value; },         // ff4a Window Y position
-	[](MMU* mmu, uint8_t value) { mmu->gpu->winScrollX = value; },         // ff4b Window X position
+	apuW(0xff30), // ff30 Wave pattern RAM
+	apuW(0xff31), // ff31 Wave pattern RAM
+	apuW(0xff32), // ff32 Wave pattern RAM
+	apuW(0xff33), // ff33 Wave pattern RAM
+	apuW(0xff34), // ff34 Wave pattern RAM
+	apuW(0xff35), // ff35 Wave pattern RAM
+	apuW(0xff36), // ff36 Wave pattern RAM
+	apuW(0xff37), // ff37 Wave pattern RAM
+	apuW(0xff38), // ff38 Wave pattern RAM
+	apuW(0xff39), // ff39 Wave pattern RAM
+	apuW(0xff3a), // ff3a Wave pattern RAM
+	apuW(0xff3b), // ff3b Wave pattern RAM
+	apuW(0xff3c), // ff3c Wave pattern RAM
+	apuW(0xff3d), // ff3d Wave pattern RAM
+	apuW(0xff3e), // ff3e Wave pattern RAM
+	apuW(0xff3f), // ff3f Wave pattern RAM
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->lcdControl.raw = value; },     // ff40 LCD Control
+	[](MMU* mmu, uint8_t value) { mmu->gpu->lcdStatus.raw = value;  },                              // ff41 LCD Status
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->bgScrollY = value; },          // ff42 Background vertical scrolling
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->bgScrollX = value; },          // ff43 Background horizontal scrolling
+	[](MMU* mmu, uint8_t)       { mmu->gpu->line = 0; },                                            // ff44 Current scanline (reset on set)
+	[](MMU* mmu, uint8_t value) { mmu->gpu->coincidence = value; },                                 // ff45 Scanline comparison
+	[](MMU* mmu, uint8_t value) {                                                                   // ff46 DMA transfer control
+		// Copy 160 bytes from XX00-XX9F to OAM (instantly)
+		for (uint16_t i = 0; i < 0xa0; ++i) {
+			mmu->Write(0xfe00 + i, mmu->Read((value << 8) | i));
+		}
+	},
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->bgPalette.raw = value; },      // ff47 Background palette
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->spritePalette1.raw = value; }, // ff48 Sprite palette #0
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->spritePalette2.raw = value; }, // ff49 Sprite palette #1
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->winScrollY = value; },         // ff4a Window Y position
+	[](MMU* mmu, uint8_t value) { mmu->gpu->RasterWrite(); mmu->gpu->winScrollX = value; },         // ff4b Window X position
 	emptyW, // ff4c <empty>
 	emptyW, // ff4d <empty>
 	emptyW, // ff4e <empty>
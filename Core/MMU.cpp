@@ -1,5 +1,8 @@
 #include "MMU.h"
 
+#include <cstring>
+#include <stdexcept>
+
 // Gameboy bootstrap ROM
 const uint8_t bootstrap[] = {
 	0x31, 0xFE, 0xFF, 0xAF, 0x21, 0xFF, 0x9F, 0x32, 0xCB, 0x7C, 0x20, 0xFB, 0x21,
@@ -27,49 +30,59 @@ const uint8_t bootstrap[] = {
 uint8_t MMU::Read(const uint16_t location) {
 	// 0000 - 0100 => Bootstrap ROM (only if turned on)
 	if (usingBootstrap && location < 0x0100) {
+		countRead(Region_ROM0);
 		return bootstrap[location];
 	}
 
 	if (location < 0x8000) {
+		countRead(location < 0x4000 ? Region_ROM0 : Region_ROMX);
 		return rom->controller->Read(location);
 	}
 
 	// 8000 - 9fff => VRAM bank (switchable in GBC)
 	if (location < 0xa000) {
+		countRead(Region_VRAM);
 		return gpu->VRAM[gpu->VRAMbankId].bytes[location - 0x8000];
 	}
 
 	// a000 - bfff => External RAM (switchable)
 	if (location < 0xc000) {
+		countRead(Region_ExtRAM);
 		return rom->controller->Read(location);
 	}
 
 	// c000 - cfff => Work RAM fixed bank
 	if (location < 0xd000) {
+		countRead(Region_WRAM0);
 		return WRAM.bytes[location - 0xc000];
 	}
 
 	// d000 - dfff => Switchable Work RAM bank
 	if (location < 0xe000) {
+		countRead(Region_WRAMX);
 		return WRAMbanks[WRAMbankId].bytes[location - 0xd000];
 	}
 
 	// e000 - fdff => Mirror of c000 - ddff
 	if (location < 0xfe00) {
-		return Read(location - 0x2000);
+		countRead(Region_Echo);
+		const uint16_t mirrored = location - 0x2000;
+		return mirrored < 0xd000 ? WRAM.bytes[mirrored - 0xc000] : WRAMbanks[WRAMbankId].bytes[mirrored - 0xd000];
 	}
 
 	// fe00 - fe9f => Sprite attribute table
 	if (location < 0xfea0) {
+		countRead(Region_OAM);
+
 		// Get OAM item
-		uint8_t index = location / 4;
+		uint8_t index = (location - 0xfe00) / 4;
 		OAMBlock block = gpu->sprites[index];
 
 		// Get requested byte
 		uint8_t offset = location % 4;
 		switch (offset) {
-			case 0: return block.x;
-			case 1: return block.y;
+			case 0: return block.y;
+			case 1: return block.x;
 			case 2: return block.pattern;
 			case 3: return block.flags.raw;
 			default: throw std::logic_error("Bad OAM offset");
@@ -78,71 +91,85 @@ uint8_t MMU::Read(const uint16_t location) {
 
 	// fea0 - feff => Not usable
 	if (location < 0xff00) {
+		countRead(Region_Unusable);
 		return 0;
 	}
 
 	// ff00 - ff7f => I/O Registers
 	if (location < 0xff80) {
+		countRead(Region_IO);
 		return readIO(location - 0xff00);
 	}
 
 	// ff80 - fffe => High RAM (HRAM)
 	if (location < 0xffff) {
+		countRead(Region_HRAM);
 		return ZRAM.bytes[location - 0xff80];
 	}
 
 	// ffff => Interrupt mask
+	countRead(Region_IE);
 	return interruptEnable.raw;
 }
 
 void MMU::Write(const uint16_t location, const uint8_t value) {
 	// 0000 - 7fff => ROM (Not writable)
 	if (location < 0x8000) {
-		rom->controller->Write(location, value);
+		countWrite(location < 0x4000 ? Region_ROM0 : Region_ROMX);
+		writeController(location, value);
 		return;
 	}
 
 	// 8000 - 9fff => VRAM bank (switchable in GBC)
 	if (location < 0xa000) {
+		countWrite(Region_VRAM);
 		gpu->VRAM[gpu->VRAMbankId].bytes[location - 0x8000] = value;
 		return;
 	}
 
 	// a000 - bfff => External RAM (switchable)
 	if (location < 0xc000) {
-		rom->controller->Write(location, value);
+		countWrite(Region_ExtRAM);
+		writeController(location, value);
 		return;
 	}
 
 	// c000 - cfff => Work RAM fixed bank
 	if (location < 0xd000) {
+		countWrite(Region_WRAM0);
 		WRAM.bytes[location - 0xc000] = value;
 		return;
 	}
 
 	// d000 - dfff => Switchable Work RAM bank
 	if (location < 0xe000) {
+		countWrite(Region_WRAMX);
 		WRAMbanks[WRAMbankId].bytes[location - 0xd000] = value;
 		return;
 	}
 
 	// e000 - fdff => Mirror of c000 - ddff (Not writable)
-	if (location < 0xfe00) { return; }
+	if (location < 0xfe00) {
+		countWrite(Region_Echo);
+		return;
+	}
 
 	// fe00 - fe9f => Sprite attribute table
 	if (location < 0xfea0) {
+		countWrite(Region_OAM);
+
 		// Get OAM item
-		uint8_t index = location / 4;
+		uint8_t index = (location - 0xfe00) / 4;
 		OAMBlock* block = &(gpu->sprites[index]);
 
 		// Get requested byte
 		uint8_t offset = location % 4;
 		switch (offset) {
 			case 0:
-				block->x = value;
+				block->y = value;
 				return;
 			case 1:
-				block->y = value;
+				block->x = value;
 				return;
 			case 2:
 				block->pattern = value;
@@ -156,24 +183,83 @@ void MMU::Write(const uint16_t location, const uint8_t value) {
 	}
 
 	// fea0 - feff => Not usable
-	if (location < 0xff00) { return; }
+	if (location < 0xff00) {
+		countWrite(Region_Unusable);
+		return;
+	}
 
 	// ff00 - ff7f => I/O Registers
 	if (location < 0xff80) {
+		countWrite(Region_IO);
 		writeIO(location - 0xff00, value);
 		return;
 	}
 
 	// ff80 - fffe => High RAM (HRAM)
 	if (location < 0xffff) {
+		countWrite(Region_HRAM);
 		ZRAM.bytes[location - 0xff80] = value;
 		return;
 	}
 
 	// ffff => Interrupt mask
+	countWrite(Region_IE);
 	interruptEnable.raw = value;
 }
 
+void MMU::writeController(const uint16_t location, const uint8_t value) {
+	if (counters == nullptr) {
+		rom->controller->Write(location, value);
+		return;
+	}
+
+	const uint8_t romBank = rom->controller->romBankId;
+	const uint8_t ramBank = rom->controller->ramBankId;
+	rom->controller->Write(location, value);
+	if (rom->controller->romBankId != romBank || rom->controller->ramBankId != ramBank) {
+		counters->bankSwitches++;
+	}
+}
+
+uint8_t MMU::Peek(const uint16_t location) {
+	PerfCounters* const counting = counters;
+	counters = nullptr;
+	uint8_t value;
+	try {
+		value = Read(location);
+	} catch (const std::exception&) {
+		value = 0xff;
+	}
+	counters = counting;
+	return value;
+}
+
+const uint8_t* MMU::Region(const uint16_t location, const size_t size) const {
+	const size_t end = location + size;
+
+	// 8000 - 9fff => VRAM bank (switchable in GBC)
+	if (location >= 0x8000 && end <= 0xa000) {
+		return gpu->VRAM[gpu->VRAMbankId].bytes + (location - 0x8000);
+	}
+
+	// c000 - cfff => Work RAM fixed bank
+	if (location >= 0xc000 && end <= 0xd000) {
+		return WRAM.bytes + (location - 0xc000);
+	}
+
+	// d000 - dfff => Switchable Work RAM bank
+	if (location >= 0xd000 && end <= 0xe000) {
+		return WRAMbanks[WRAMbankId].bytes + (location - 0xd000);
+	}
+
+	// ff80 - fffe => Zero page RAM
+	if (location >= 0xff80 && end <= 0xffff) {
+		return ZRAM.bytes + (location - 0xff80);
+	}
+
+	return nullptr;
+}
+
 void MMU::UpdateTimers(CycleCount delta) {
 	// Update divider (one increment every 256 clocks), include past extra clocks (dividerRest)
 	divider += (uint8_t) ((delta.cpu + dividerRest) / 256);
@@ -229,11 +315,16 @@ void MMU::UpdateTimers(CycleCount delta) {
 	}
 }
 
-MMU::MMU(ROM* romData, GPU* _gpu, Input* _input) {
+MMU::MMU(ROM* romData, GPU* _gpu, Input* _input, APU* _apu, PerfCounters* _counters) {
+	// Clear RAM and registers (WRAM would be random on hardware, but runs must be reproducible)
+	memset(static_cast<MMUState*>(this), 0, sizeof(MMUState));
+
 	// Setup variables
 	rom = romData;
 	gpu = _gpu;
 	input = _input;
+	apu = _apu;
+	counters = _counters;
 	usingBootstrap = true;
 
 	// Reset timers
@@ -245,8 +336,7 @@ MMU::MMU(ROM* romData, GPU* _gpu, Input* _input) {
 	interruptsEnabled = true;
 
 	// Push at least one WRAM bank (GB classic)
-	WRAMBank wbank1;
-	WRAMbanks.push_back(wbank1);
+	WRAMbanks.push_back({});
 }
 
 void MMU::SetInterrupt(InterruptType type) {
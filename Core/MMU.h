@@ -4,7 +4,9 @@
 
 #include "ROM.h"
 #include "GPU.h"
+#include "APU.h"
 #include "Input.h"
+#include "Counters.h"
 
 /*! \brief Cycle count
  *
@@ -80,23 +82,63 @@ enum InterruptType : uint8_t {
 	IntInput = 4
 };
 
+/*! \brief MMU state
+ *
+ *  Internal RAM, timers and interrupt registers, kept in a plain struct so
+ *  they can be saved and restored with a single copy (see SaveState).
+ *  Extra WRAM banks are saved separately.
+ */
+struct MMUState {
+	WRAMBank WRAM;                 //!< Internal RAM (bank 0)
+	ZRAMBank ZRAM;                 //!< Zero page RAM (128 bytes)
+	uint8_t WRAMbankId;            //!< Internal RAM current bank id
+
+	uint8_t dividerRest;           //!< Extra cycles for the divider timer
+	uint16_t counterRest;          //!< Extra cycles for the controllable timer
+
+	bool usingBootstrap;           //!< Redirects 0x000-0x100 to the Bootstrap ROM
+
+	uint8_t divider,               //!< Divider timer
+		timerCounter,              //!< Controllable timer
+		timerModulo;               //!< Timer modulo (increases with each timer overflow)
+
+	TimerControl timerControl;     //!< Timer control register
+
+	bool interruptsEnabled;        //!< Are interrupts enabled? (IME)
+	InterruptFlag interruptFlags;  //!< Which interrupts have happened
+	InterruptFlag interruptEnable; //!< Which interrupts are enabled
+
+	uint8_t serialData;            //!< Serial transfer data (SB)
+	uint8_t serialControl;         //!< Serial transfer control (SC)
+};
+
 /*! \brief Memory management unit
  *
  *  MMU manages memory and access to it, it keeps track of the timers and
  *  parses 16 bit memory locations to where they are (ROM/RAM/VRAM/etc).
  */
-class MMU {
+class MMU : public MMUState {
+	friend class SaveState;
 private:
 	ROM* rom;                        //!< ROM instance
 
-	WRAMBank WRAM;                   //!< Internal RAM (bank 0)
 	std::vector<WRAMBank> WRAMbanks; //!< Internal RAM extra banks
-	uint8_t WRAMbankId = 0;          //!< Internal RAM currnet bank id
 
-	ZRAMBank ZRAM;                   //!< Zero page RAM (128 bytes)
+	PerfCounters* counters;          //!< Access counters (null if not counting)
+
+	void countRead(const MemoryRegion region) {
+		if (counters != nullptr) {
+			counters->reads[region]++;
+		}
+	}
+	void countWrite(const MemoryRegion region) {
+		if (counters != nullptr) {
+			counters->writes[region]++;
+		}
+	}
 
-	uint8_t dividerRest;             //!< Extra cycles for the divider timer
-	uint16_t counterRest;            //!< Extra cycles for the controllable timer
+	//! Write to the cartridge, counting bank changes
+	void writeController(const uint16_t location, const uint8_t value);
 
 	uint8_t readIO(const uint16_t location);
 	void writeIO(const uint16_t location, const uint8_t value);
@@ -105,20 +147,12 @@ private:
 public:
 	GPU* gpu;                  //!< GPU instance (for accessing VRAM)
 	Input* input;              //!< Input instance (for joypad IO register)
+	APU* apu;                  //!< APU instance (for sound IO registers)
 
-	bool usingBootstrap;       //!< Redirects 0x000-0x100 to the Bootstrap ROM
+	//! Receives every byte sent on the link port (nothing is connected, 0xff comes back)
+	std::function<void(uint8_t)> serialOutput;
 
-	uint8_t divider,           //!< Divider timer
-		timerCounter,          //!< Controllable timer
-		timerModulo;           //!< Timer modulo (increases with each timer overflow)
-
-	TimerControl timerControl; //!< Timer control register
-
-	bool interruptsEnabled;        //!< Are interrupts enabled? (IME)
-	InterruptFlag interruptFlags;  //!< Which interrupts have happened
-	InterruptFlag interruptEnable; //!< Which interrupts are enabled
-
-	MMU(ROM* romData, GPU* _gpu, Input* _input);
+	MMU(ROM* romData, GPU* _gpu, Input* _input, APU* _apu, PerfCounters* _counters = nullptr);
 
 	/*! \brief Reads from memory
 	 *
@@ -130,6 +164,16 @@ public:
 	 */
 	uint8_t Read(const uint16_t location);
 
+	/*! \brief Reads from memory, for debuggers and reports
+	 *
+	 *  Like Read(), but the access isn't counted and memory that isn't there
+	 *  (ie. missing or disabled cartridge RAM) reads 0xff instead of throwing.
+	 *
+	 *  \param location 16 bit memory address of memory to locate
+	 *  \return Value in memory (8 bit)
+	 */
+	uint8_t Peek(const uint16_t location);
+
 	/*! \brief Writes to memory
 	 *
 	 *  Issues a write to memory given a 16 bit address and a 8 bit value to write,
@@ -141,6 +185,18 @@ public:
 	 */
 	void Write(const uint16_t location, const uint8_t value);
 
+	/*! \brief Direct access to a memory range
+	 *
+	 *  Points into the RAM backing a range of addresses (VRAM, WRAM or zero page),
+	 *  to read it without going through Read(). The pointer follows the bank
+	 *  mapped right now, and stays valid for the life of the machine.
+	 *
+	 *  \param location First address of the range
+	 *  \param size Length of the range
+	 *  \return Range data, nullptr if it's not backed by a single block of RAM
+	 */
+	const uint8_t* Region(const uint16_t location, const size_t size) const;
+
 	/*! \brief Updates internal timers
 	 *
 	 *  Updates the internal timers (Divider and Controller timer) based on the
@@ -0,0 +1,75 @@
+#include "Movie.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const char MAGIC[8] = { 'M', 'F', 'E', 'M', 'U', 'M', 'O', 'V' };
+
+//! Movie file header, followed by the initial state and the frames
+struct MovieHeader {
+	char magic[8];       //!< "MFEMUMOV"
+	uint32_t version;    //!< Movie::FORMAT_VERSION
+	uint32_t stateSize;  //!< Size of the initial save state
+	uint64_t romHash;    //!< ROM::hash
+	uint64_t frames;     //!< Number of frames
+};
+
+bool Movie::Save(const std::string& path) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.good()) {
+		return false;
+	}
+
+	MovieHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = FORMAT_VERSION;
+	header.stateSize = (uint32_t)initialState.size();
+	header.romHash = romHash;
+	header.frames = frames.size();
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(initialState.data()), initialState.size());
+	file.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(MovieFrame));
+	return file.good();
+}
+
+Movie Movie::Load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good()) {
+		throw std::runtime_error("Could not open movie " + path);
+	}
+
+	MovieHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		throw std::runtime_error("Movie is truncated");
+	}
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		throw std::runtime_error("Not a movie");
+	}
+	if (header.version != FORMAT_VERSION) {
+		throw std::runtime_error("Unsupported movie version " + std::to_string(header.version));
+	}
+
+	// Check the sizes against the file before allocating anything
+	const std::streampos start = file.tellg();
+	file.seekg(0, std::ios::end);
+	const uint64_t remaining = (uint64_t)(file.tellg() - start);
+	file.seekg(start);
+	if (header.frames > remaining / sizeof(MovieFrame) ||
+		header.stateSize + header.frames * sizeof(MovieFrame) != remaining) {
+		throw std::runtime_error("Movie is truncated");
+	}
+
+	Movie movie;
+	movie.romHash = header.romHash;
+	movie.initialState.resize(header.stateSize);
+	movie.frames.resize(header.frames);
+	file.read(reinterpret_cast<char*>(movie.initialState.data()), movie.initialState.size());
+	file.read(reinterpret_cast<char*>(movie.frames.data()), movie.frames.size() * sizeof(MovieFrame));
+	if (!file) {
+		throw std::runtime_error("Movie is truncated");
+	}
+	return movie;
+}
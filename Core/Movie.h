@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! Joypad state for one frame of a movie
+struct MovieFrame {
+	uint8_t buttons;    //!< Held buttons (see Input::GetButtons)
+	uint8_t pressed;    //!< Joypad interrupt requested (Input::buttonPressed)
+};
+
+/*! \brief Input movie
+ *
+ *  Joypad state of every frame since a starting save state. Input is
+ *  latched once a frame (see Input::Latch), so feeding the same frames
+ *  back from the same state replays the session exactly.
+ *
+ *  Movies are bound to the ROM (by hash) and to the save state format.
+ */
+class Movie final {
+public:
+	static const uint32_t FORMAT_VERSION = 1;
+
+	uint64_t romHash = 0;               //!< ROM::hash of the recorded ROM
+	std::vector<uint8_t> initialState;  //!< Save state the movie starts from
+	std::vector<MovieFrame> frames;     //!< Input of each frame
+
+	/*! \brief Write the movie to a file
+	 *
+	 *  \param path Movie file
+	 *  \return false on I/O errors
+	 */
+	bool Save(const std::string& path) const;
+
+	/*! \brief Read a movie from a file
+	 *
+	 *  Throws std::runtime_error if the file is missing or not a valid movie.
+	 *
+	 *  \param path Movie file
+	 *  \return Loaded movie
+	 */
+	static Movie Load(const std::string& path);
+};
@@ -0,0 +1,105 @@
+#include "PNG.h"
+
+#include <algorithm>
+#include <fstream>
+
+// CRC-32 lookup table (as used by PNG chunks)
+static const std::vector<uint32_t> crcTable = [] {
+	std::vector<uint32_t> table(256);
+	for (uint32_t n = 0; n < 256; ++n) {
+		uint32_t c = n;
+		for (int k = 0; k < 8; ++k) {
+			c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		}
+		table[n] = c;
+	}
+	return table;
+}();
+
+static uint32_t crc32(const uint8_t* data, const size_t length) {
+	uint32_t c = 0xffffffff;
+	for (size_t i = 0; i < length; ++i) {
+		c = crcTable[(c ^ data[i]) & 0xff] ^ (c >> 8);
+	}
+	return c ^ 0xffffffff;
+}
+
+static uint32_t adler32(const uint8_t* data, const size_t length) {
+	uint32_t a = 1, b = 0;
+	for (size_t i = 0; i < length; ++i) {
+		a = (a + data[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+static void putBE32(std::vector<uint8_t>& out, const uint32_t value) {
+	out.push_back((uint8_t)(value >> 24));
+	out.push_back((uint8_t)(value >> 16));
+	out.push_back((uint8_t)(value >> 8));
+	out.push_back((uint8_t)value);
+}
+
+// Append a chunk (length, type, data, CRC of type + data)
+static void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+	putBE32(out, (uint32_t)data.size());
+	const size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	putBE32(out, crc32(&out[start], out.size() - start));
+}
+
+std::vector<uint8_t> PNG::Encode(const uint32_t* pixels, const int width, const int height) {
+	std::vector<uint8_t> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	// Header: size, 8 bit depth, RGB, no interlacing
+	std::vector<uint8_t> header;
+	putBE32(header, width);
+	putBE32(header, height);
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+	putChunk(out, "IHDR", header);
+
+	// Raw scanlines, each prefixed by its filter type (0: none)
+	std::vector<uint8_t> raw;
+	raw.reserve(height * (1 + width * 3));
+	for (int y = 0; y < height; ++y) {
+		raw.push_back(0);
+		for (int x = 0; x < width; ++x) {
+			const uint32_t pixel = pixels[y * width + x];
+			raw.push_back((uint8_t)(pixel >> 16));
+			raw.push_back((uint8_t)(pixel >> 8));
+			raw.push_back((uint8_t)pixel);
+		}
+	}
+
+	// zlib stream made of stored deflate blocks (up to 65535 bytes each)
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	size_t offset = 0;
+	do {
+		const size_t length = std::min<size_t>(raw.size() - offset, 0xffff);
+		const bool last = offset + length == raw.size();
+		zlib.push_back(last ? 1 : 0);
+		zlib.push_back((uint8_t)length);
+		zlib.push_back((uint8_t)(length >> 8));
+		zlib.push_back((uint8_t)~length);
+		zlib.push_back((uint8_t)(~length >> 8));
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+		offset += length;
+	} while (offset < raw.size());
+	putBE32(zlib, adler32(raw.data(), raw.size()));
+	putChunk(out, "IDAT", zlib);
+
+	putChunk(out, "IEND", std::vector<uint8_t>());
+	return out;
+}
+
+bool PNG::Write(const std::string& path, const uint32_t* pixels, const int width, const int height) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.good()) {
+		return false;
+	}
+
+	const std::vector<uint8_t> data = Encode(pixels, width, height);
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return file.good();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace PNG {
+
+/*! \brief Encode an image as PNG
+ *
+ *  Encodes an ARGB8888 image as a 24 bit RGB PNG. Image data is stored
+ *  in uncompressed deflate blocks, so no compression library is needed.
+ *
+ *  \param pixels Image pixels (ARGB8888, row by row)
+ *  \param width Image width
+ *  \param height Image height
+ *  \return PNG file contents
+ */
+std::vector<uint8_t> Encode(const uint32_t* pixels, const int width, const int height);
+
+/*! \brief Write an image to a PNG file
+ *
+ *  \param path Output file path
+ *  \param pixels Image pixels (ARGB8888, row by row)
+ *  \param width Image width
+ *  \param height Image height
+ *  \return true if the file has been written
+ */
+bool Write(const std::string& path, const uint32_t* pixels, const int width, const int height);
+
+} // end namespace PNG
@@ -0,0 +1,14 @@
+#include "PagedMemory.h"
+
+PagedMemory::PagedMemory(const size_t size) {
+	const size_t count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	pages.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		// Value initialized: zeroed
+		pages.push_back(std::make_shared<Page>());
+	}
+}
+
+void PagedMemory::detach(const size_t index) {
+	pages[index] = std::make_shared<Page>(*pages[index]);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*! \brief Copy-on-write memory
+ *
+ *  Memory split in 4KB pages that copies of the object share until they
+ *  write to them: a copy only duplicates the page table, a page is only
+ *  duplicated on the first write to it while it's shared.
+ *
+ *  Sharing is thread safe (each copy can be used from its own thread),
+ *  a single copy is not. A page is only written in place once every other
+ *  copy has dropped it, which is ordered after their last reads of it.
+ */
+class PagedMemory final {
+public:
+	static const size_t PAGE_BITS = 12;
+	static const size_t PAGE_SIZE = 1 << PAGE_BITS;  //!< Page size (4KB)
+
+private:
+	struct Page {
+		uint8_t bytes[PAGE_SIZE];
+	};
+
+	std::vector<std::shared_ptr<Page>> pages;
+
+	//! Give a page its own copy of the data
+	void detach(const size_t index);
+
+public:
+	PagedMemory() {}
+
+	/*! \brief Allocate zeroed memory
+	 *
+	 *  \param size Size in bytes (rounded up to whole pages)
+	 */
+	explicit PagedMemory(const size_t size);
+
+	//! Read a byte
+	uint8_t Read(const size_t address) const {
+		return pages[address >> PAGE_BITS]->bytes[address & (PAGE_SIZE - 1)];
+	}
+
+	//! Write a byte (copies the page first if it's shared)
+	void Write(const size_t address, const uint8_t value) {
+		WritablePage(address >> PAGE_BITS)[address & (PAGE_SIZE - 1)] = value;
+	}
+
+	//! Size in bytes
+	size_t Size() const { return pages.size() * PAGE_SIZE; }
+
+	//! Number of pages
+	size_t Pages() const { return pages.size(); }
+
+	//! Read access to a page
+	const uint8_t* PageData(const size_t index) const { return pages[index]->bytes; }
+
+	//! Write access to a page (copies it first if it's shared)
+	uint8_t* WritablePage(const size_t index) {
+		if (pages[index].use_count() != 1) {
+			detach(index);
+		} else {
+			// The other owner may have just let go of the page from its own thread:
+			// its reads happened before the count dropped (release), keep our writes after
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		return pages[index]->bytes;
+	}
+};
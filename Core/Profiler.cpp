@@ -0,0 +1,83 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+PCProfiler::PCProfiler(const uint32_t interval)
+	: interval(interval > 0 ? interval : 1) {
+	Reset();
+}
+
+void PCProfiler::Reset() {
+	fixed.assign(0x10000, { 0, 0 });
+	banked.clear();
+	countdown = interval;
+	totalSamples = totalCycles = haltCycles = 0;
+}
+
+void PCProfiler::Record(const uint8_t bank, const uint16_t pc, const uint64_t cycles, const bool halted) {
+	const uint64_t weighted = cycles * interval;
+	totalSamples++;
+	totalCycles += weighted;
+	if (halted) {
+		haltCycles += weighted;
+		return;
+	}
+
+	Entry* entry;
+	if (pc >= 0x4000 && pc < 0x8000) {
+		if (bank >= banked.size()) {
+			banked.resize(bank + 1);
+		}
+		if (banked[bank].empty()) {
+			banked[bank].assign(0x4000, { 0, 0 });
+		}
+		entry = &banked[bank][pc - 0x4000];
+	} else {
+		entry = &fixed[pc];
+	}
+	entry->samples++;
+	entry->cycles += weighted;
+}
+
+std::vector<PCProfiler::Hotspot> PCProfiler::Hotspots() const {
+	std::vector<Hotspot> hotspots;
+	for (size_t pc = 0; pc < fixed.size(); ++pc) {
+		if (fixed[pc].samples > 0) {
+			hotspots.push_back({ 0, (uint16_t)pc, fixed[pc].samples, fixed[pc].cycles });
+		}
+	}
+	for (size_t bank = 0; bank < banked.size(); ++bank) {
+		for (size_t offset = 0; offset < banked[bank].size(); ++offset) {
+			const Entry& entry = banked[bank][offset];
+			if (entry.samples > 0) {
+				hotspots.push_back({ (uint8_t)bank, (uint16_t)(0x4000 + offset), entry.samples, entry.cycles });
+			}
+		}
+	}
+
+	std::sort(hotspots.begin(), hotspots.end(), [](const Hotspot& a, const Hotspot& b) {
+		return a.cycles != b.cycles ? a.cycles > b.cycles : a.samples > b.samples;
+	});
+	return hotspots;
+}
+
+void PCProfiler::Report(std::ostream& out, const size_t count, const Disassembler& disassemble) const {
+	const std::ios::fmtflags fmt(out.flags());
+	const std::vector<Hotspot> hotspots = Hotspots();
+
+	out << std::fixed << std::setprecision(2);
+	out << "Guest profile: " << totalSamples << " samples (one every " << interval << " instructions), "
+		<< totalCycles << " cycles, " << (totalCycles > 0 ? 100.0 * haltCycles / totalCycles : 0.0) << "% halted" << std::endl;
+	out << "Bank:PC       Samples          Cycles       %  Instruction" << std::endl;
+
+	for (size_t i = 0; i < hotspots.size() && i < count; ++i) {
+		const Hotspot& spot = hotspots[i];
+		out << std::hex << std::setfill('0') << std::setw(2) << (int)spot.bank << ":" << std::setw(4) << spot.pc
+			<< std::dec << std::setfill(' ')
+			<< std::setw(14) << spot.samples << std::setw(16) << spot.cycles
+			<< std::setw(8) << 100.0 * spot.cycles / totalCycles << "  ";
+		disassemble(out, spot.bank, spot.pc);
+	}
+	out.flags(fmt);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+/*! \brief Guest PC profiler
+ *
+ *  Samples the instruction about to run one time in N (N = 1 counts every
+ *  instruction) and charges its cycles to (ROM bank, PC), to find the guest
+ *  routines the emulator spends its time in. The bank is only kept for the
+ *  switchable ROM area (4000-7fff), everything else is bank 0.
+ *
+ *  Cycles are estimates when sampling: each sample stands for N instructions.
+ */
+class PCProfiler final {
+public:
+	//! A profiled instruction
+	struct Hotspot {
+		uint8_t bank;     //!< ROM bank (0 outside 4000-7fff)
+		uint16_t pc;      //!< Address
+		uint64_t samples; //!< Times sampled
+		uint64_t cycles;  //!< Estimated CPU cycles spent
+	};
+
+	//! Prints one instruction (and the line break) as it is in the given bank
+	using Disassembler = std::function<void(std::ostream& out, const uint8_t bank, const uint16_t pc)>;
+
+private:
+	struct Entry {
+		uint64_t samples, cycles;
+	};
+
+	std::vector<Entry> fixed;               //!< Everything outside 4000-7fff, by address
+	std::vector<std::vector<Entry>> banked; //!< 4000-7fff, per ROM bank (allocated on first hit)
+
+	uint32_t interval;
+	uint32_t countdown;
+	uint64_t totalSamples, totalCycles, haltCycles;
+
+public:
+	/*! \brief Create a profiler
+	 *
+	 *  \param interval Sample one instruction every N (1: all of them)
+	 */
+	explicit PCProfiler(const uint32_t interval = 1);
+
+	//! Should the coming instruction be sampled?
+	bool Due() {
+		if (--countdown != 0) {
+			return false;
+		}
+		countdown = interval;
+		return true;
+	}
+
+	/*! \brief Charge a sampled step
+	 *
+	 *  \param bank ROM bank mapped at 4000-7fff
+	 *  \param pc Address of the instruction
+	 *  \param cycles CPU cycles the step took
+	 *  \param halted The CPU was halted (the cycles are idle time, not the instruction's)
+	 */
+	void Record(const uint8_t bank, const uint16_t pc, const uint64_t cycles, const bool halted);
+
+	//! Forget everything sampled so far
+	void Reset();
+
+	//! Sampling interval
+	uint32_t Interval() const { return interval; }
+
+	//! Every sampled instruction, most cycles first
+	std::vector<Hotspot> Hotspots() const;
+
+	/*! \brief Print the hottest instructions
+	 *
+	 *  \param out Stream to print to
+	 *  \param count Instructions to list
+	 *  \param disassemble Prints an instruction (see Disassembler)
+	 */
+	void Report(std::ostream& out, const size_t count, const Disassembler& disassemble) const;
+};
@@ -1,4 +1,5 @@
 #include "ROM.h"
+#include "Hash.h"
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -60,6 +61,9 @@ ROM::ROM(const std::vector<uint8_t>& bytes) {
 	// Load content to ROM banks
 	controller->LoadROM(header, bytes);
 
+	// Identify the exact ROM (movies, state hashes)
+	hash = HashBytes(bytes.data(), bytes.size());
+
 	//TODO load from .sav to RAM
 
 	// The title can be either 15 or 13 characters, depending on target console
@@ -73,6 +77,9 @@ ROM::ROM(const std::vector<uint8_t>& bytes) {
 	std::cout << "Loaded ROM: " << title << std::endl;
 }
 
+ROM::ROM(const ROM& other)
+	: header(other.header), controller(other.controller->Clone()), hash(other.hash) {}
+
 ROM::~ROM() {
 	delete controller;
 }
@@ -14,6 +14,7 @@ class ROM {
 public:
 	ROMHeader header; //!< ROM Header, extracted from the opened ROM
 	MBC* controller;  //!< ROM Controller, used for IO access
+	uint64_t hash;    //!< Hash of the whole ROM file (see HashBytes)
 
 	//! Load ROM from file
 	static ROM FromFile(const std::string& filename);
@@ -21,6 +22,11 @@ public:
 	//! Load ROM from memory
 	explicit ROM(const std::vector<uint8_t>& bytes);
 
+	//! Copy a ROM, sharing its data (see MBC::Clone)
+	ROM(const ROM& other);
+
+	ROM& operator=(const ROM&) = delete;
+
 	//! Print ROM data (for debugging)
 	void debugPrintData() const;
 
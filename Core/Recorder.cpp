@@ -0,0 +1,108 @@
+#include "Recorder.h"
+#include "GPU.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+Recorder::Recorder(const std::string& path, const int _every, const ScalerType scalerType, const size_t queueSize)
+	: file(path, std::ios::binary), every(_every < 1 ? 1 : _every), scaler(scalerType) {
+	if (!file.good()) {
+		throw std::runtime_error("Could not open recording file: " + path);
+	}
+
+	const std::string extension = ".y4m";
+	format = path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0
+		? Record_Y4M : Record_Raw;
+
+	if (format == Record_Y4M) {
+		// Frame rate is 4194304 Hz / 70224 cycles per frame (~59.73 fps)
+		std::stringstream header;
+		header << "YUV4MPEG2 W" << scaler.Width() << " H" << scaler.Height()
+			<< " F4194304:" << 70224 * every << " Ip A1:1 C444\n";
+		file << header.str();
+	}
+
+	slots.resize(queueSize < 1 ? 1 : queueSize, std::vector<uint32_t>(PIXELS));
+	writer = std::thread(&Recorder::writeLoop, this);
+}
+
+Recorder::~Recorder() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	notEmpty.notify_one();
+	writer.join();
+}
+
+void Recorder::PushFrame(const uint32_t* screen) {
+	if (frameIndex++ % every != 0) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	notFull.wait(lock, [this] { return count < slots.size(); });
+	memcpy(slots[(head + count) % slots.size()].data(), screen, PIXELS * sizeof(uint32_t));
+	count++;
+	lock.unlock();
+	notEmpty.notify_one();
+}
+
+uint64_t Recorder::Written() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return written;
+}
+
+void Recorder::writeLoop() {
+	for (;;) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return count > 0 || stopping; });
+		if (count == 0) {
+			// Stopping and nothing left to write
+			break;
+		}
+
+		// The head slot is not touched by the producer until it's released
+		const uint32_t* frame = slots[head].data();
+		lock.unlock();
+
+		writeFrame(frame);
+
+		lock.lock();
+		head = (head + 1) % slots.size();
+		count--;
+		written++;
+		lock.unlock();
+		notFull.notify_one();
+	}
+
+	file.flush();
+}
+
+void Recorder::writeFrame(const uint32_t* frame) {
+	const uint32_t* scaled = scaler.Scale(frame);
+	const size_t pixels = scaler.Width() * scaler.Height();
+
+	if (format == Record_Raw) {
+		file.write(reinterpret_cast<const char*>(scaled), pixels * sizeof(uint32_t));
+		return;
+	}
+
+	// Convert to planar YUV (BT.601, studio range), reusing the buffer
+	planes.resize(pixels * 3);
+	uint8_t* y = planes.data();
+	uint8_t* u = y + pixels;
+	uint8_t* v = u + pixels;
+	for (size_t i = 0; i < pixels; ++i) {
+		const int r = (scaled[i] >> 16) & 0xff;
+		const int g = (scaled[i] >> 8) & 0xff;
+		const int b = scaled[i] & 0xff;
+		y[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		u[i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		v[i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+
+	file << "FRAME\n";
+	file.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+}
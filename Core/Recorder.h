@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Scaler.h"
+
+//! Video stream format
+enum RecordFormat : uint8_t {
+	Record_Y4M = 0, //!< YUV4MPEG2 stream (4:4:4)
+	Record_Raw = 1  //!< Headerless ARGB8888 frames
+};
+
+/*! \brief Video recorder
+ *
+ *  Writes frames to a Y4M or raw video stream. Frames are copied into
+ *  a bounded queue and converted/written by a background thread, so the
+ *  emulation thread only pays for a copy of the framebuffer.
+ *  When the queue is full, pushing a frame waits for the writer.
+ */
+class Recorder final {
+private:
+	std::ofstream file;
+	RecordFormat format;
+	int every;                                 //!< Record one frame every N
+	uint64_t frameIndex = 0;                   //!< Frames pushed so far
+	uint64_t written = 0;                      //!< Frames written so far
+	Scaler scaler;
+	std::vector<uint8_t> planes;               //!< YUV frame being written (writer thread only)
+
+	std::vector<std::vector<uint32_t>> slots;  //!< Queued frames (ring)
+	size_t head = 0;                           //!< First queued frame
+	size_t count = 0;                          //!< Queued frames
+	bool stopping = false;                     //!< Writer must quit when done
+	std::mutex mutex;
+	std::condition_variable notEmpty, notFull;
+	std::thread writer;
+
+	void writeLoop();
+	void writeFrame(const uint32_t* frame);
+
+public:
+	/*! \brief Start recording
+	 *
+	 *  Opens the output file and starts the writer thread. The format is
+	 *  picked from the extension (.y4m for Y4M, raw otherwise).
+	 *
+	 *  \param path Output file path
+	 *  \param every Record one frame every N frames
+	 *  \param scalerType Upscaler to apply to recorded frames
+	 *  \param queueSize Max frames waiting to be written
+	 */
+	explicit Recorder(const std::string& path, const int every = 1, const ScalerType scalerType = Scaler_None, const size_t queueSize = 16);
+
+	//! Stops recording, after all queued frames have been written
+	~Recorder();
+
+	Recorder(const Recorder&) = delete;
+	Recorder& operator=(const Recorder&) = delete;
+
+	/*! \brief Push a frame
+	 *
+	 *  Queues a complete frame (WIDTH x HEIGHT, ARGB8888) for writing,
+	 *  frames not matching the recording rate are skipped.
+	 *
+	 *  \param screen Framebuffer to record
+	 */
+	void PushFrame(const uint32_t* screen);
+
+	//! Number of frames written to the stream
+	uint64_t Written();
+};
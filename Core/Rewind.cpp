@@ -0,0 +1,165 @@
+#include "Rewind.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Shortest run of identical bytes worth ending a literal for
+static const size_t MIN_RUN = 4;
+
+RewindBuffer::RewindBuffer(const size_t capacity) {
+	ring.resize(capacity);
+}
+
+void RewindBuffer::Push(const std::vector<uint8_t>& state) {
+	// First state (or the layout changed): nothing to delta against
+	if (!hasHead || head.size() != state.size()) {
+		Clear();
+		head = state;
+		hasHead = true;
+		return;
+	}
+
+	encodeDelta(state);
+
+	// Doesn't fit at all: the history can't go further back than now
+	if (scratch.size() > ring.size()) {
+		Clear();
+		head = state;
+		hasHead = true;
+		return;
+	}
+
+	// Make room by dropping the oldest deltas
+	while (used + scratch.size() > ring.size()) {
+		used -= entries.front().size;
+		entries.pop_front();
+	}
+
+	const Entry entry = { writePos, scratch.size() };
+	write(entry);
+	entries.push_back(entry);
+	writePos = (writePos + entry.size) % ring.size();
+	used += entry.size;
+
+	memcpy(head.data(), state.data(), state.size());
+}
+
+bool RewindBuffer::Pop(std::vector<uint8_t>& out) {
+	if (!hasHead) {
+		return false;
+	}
+
+	out = head;
+
+	if (entries.empty()) {
+		hasHead = false;
+		return true;
+	}
+
+	// Rebuild the previous state from the newest delta
+	const Entry entry = entries.back();
+	entries.pop_back();
+	read(entry);
+	applyDelta();
+	writePos = entry.start;
+	used -= entry.size;
+	return true;
+}
+
+void RewindBuffer::Clear() {
+	entries.clear();
+	writePos = 0;
+	used = 0;
+	hasHead = false;
+}
+
+void RewindBuffer::encodeDelta(const std::vector<uint8_t>& state) {
+	// Sequence of (unchanged bytes, changed bytes, XORed changed bytes)
+	scratch.clear();
+	const uint8_t* current = state.data();
+	const uint8_t* previous = head.data();
+	const size_t size = state.size();
+
+	size_t i = 0;
+	while (i < size) {
+		// Unchanged run, 8 bytes at a time
+		const size_t skipStart = i;
+		while (i + 8 <= size && memcmp(current + i, previous + i, 8) == 0) {
+			i += 8;
+		}
+		while (i < size && current[i] == previous[i]) {
+			++i;
+		}
+		putVarint(i - skipStart);
+
+		// Changed bytes, until a long enough unchanged run
+		const size_t literalStart = i;
+		while (i < size) {
+			if (current[i] != previous[i]) {
+				++i;
+				continue;
+			}
+			size_t run = i;
+			while (run < size && run - i < MIN_RUN && current[run] == previous[run]) {
+				++run;
+			}
+			if (run - i >= MIN_RUN || run == size) {
+				break;
+			}
+			i = run;
+		}
+		putVarint(i - literalStart);
+		for (size_t j = literalStart; j < i; ++j) {
+			scratch.push_back(current[j] ^ previous[j]);
+		}
+	}
+}
+
+void RewindBuffer::applyDelta() {
+	const uint8_t* data = scratch.data();
+	const uint8_t* end = data + scratch.size();
+	size_t i = 0;
+	while (data < end) {
+		i += getVarint(data);
+		const size_t literal = getVarint(data);
+		for (size_t j = 0; j < literal; ++j) {
+			head[i + j] ^= data[j];
+		}
+		data += literal;
+		i += literal;
+	}
+}
+
+void RewindBuffer::putVarint(size_t value) {
+	while (value >= 0x80) {
+		scratch.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	scratch.push_back((uint8_t)value);
+}
+
+size_t RewindBuffer::getVarint(const uint8_t*& data) {
+	size_t value = 0;
+	int shift = 0;
+	uint8_t byte;
+	do {
+		byte = *data++;
+		value |= (size_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+void RewindBuffer::write(const Entry& entry) {
+	// Copy in up to two pieces (before and after wrapping)
+	const size_t first = std::min(entry.size, ring.size() - entry.start);
+	memcpy(&ring[entry.start], scratch.data(), first);
+	memcpy(&ring[0], scratch.data() + first, entry.size - first);
+}
+
+void RewindBuffer::read(const Entry& entry) {
+	scratch.resize(entry.size);
+	const size_t first = std::min(entry.size, ring.size() - entry.start);
+	memcpy(scratch.data(), &ring[entry.start], first);
+	memcpy(scratch.data() + first, &ring[0], entry.size - first);
+}
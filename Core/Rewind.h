@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/*! \brief Rewind history
+ *
+ *  Keeps the latest save state in full and every older one as the XOR delta
+ *  against the state that followed it, run-length encoded (consecutive states
+ *  mostly differ in a few hundred bytes, the rest XORs to zeroes).
+ *  Deltas live in a fixed-size byte ring: the oldest are dropped to make room.
+ *
+ *  Going back one step is taking the full state and XORing the newest delta
+ *  into it to get the previous one.
+ */
+class RewindBuffer final {
+private:
+	//! Delta stored in the ring
+	struct Entry {
+		size_t start;              //!< Offset in the ring
+		size_t size;               //!< Encoded size
+	};
+
+	std::vector<uint8_t> ring;     //!< Encoded deltas
+	std::deque<Entry> entries;     //!< Deltas, oldest first
+	size_t writePos = 0;           //!< Ring offset of the next delta
+	size_t used = 0;               //!< Bytes used in the ring
+
+	std::vector<uint8_t> head;     //!< Newest state, in full
+	bool hasHead = false;
+
+	std::vector<uint8_t> scratch;  //!< Encoding/decoding buffer
+
+	//! RLE encode (state XOR head) into scratch
+	void encodeDelta(const std::vector<uint8_t>& state);
+
+	//! XOR the delta in scratch into head
+	void applyDelta();
+
+	void putVarint(size_t value);
+	static size_t getVarint(const uint8_t*& data);
+
+	void write(const Entry& entry);
+	void read(const Entry& entry);
+
+public:
+	/*! \brief Create an empty history
+	 *
+	 *  \param capacity Memory for the deltas, in bytes
+	 */
+	explicit RewindBuffer(const size_t capacity);
+
+	RewindBuffer(const RewindBuffer&) = delete;
+	RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+	/*! \brief Add a state to the history
+	 *
+	 *  \param state Save state (see SaveState::Save)
+	 */
+	void Push(const std::vector<uint8_t>& state);
+
+	/*! \brief Take the newest state out of the history
+	 *
+	 *  \param out Buffer to write the state to
+	 *  \return false if the history is empty
+	 */
+	bool Pop(std::vector<uint8_t>& out);
+
+	//! Drop all states
+	void Clear();
+
+	//! States in the history
+	size_t Count() const { return hasHead ? entries.size() + 1 : 0; }
+
+	//! Memory used by the deltas, in bytes
+	size_t Used() const { return used; }
+};
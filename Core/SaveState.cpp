@@ -0,0 +1,272 @@
+#include "SaveState.h"
+#include "Emulator.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+static const char MAGIC[8] = { 'M', 'F', 'E', 'M', 'U', 'S', 'T', 'A' };
+
+//! State file header
+struct StateHeader {
+	char magic[8];       //!< "MFEMUSTA"
+	uint32_t version;    //!< SaveState::FORMAT_VERSION
+	uint32_t chunks;     //!< Number of chunks following the header
+	uint16_t checksum;   //!< Global checksum of the ROM
+	uint8_t _unused[6];
+};
+
+//! Chunk header, followed by size bytes of data
+struct ChunkHeader {
+	char tag[4];
+	uint32_t size;
+};
+
+//! Emulator loop and joypad state (not part of any subsystem struct)
+struct SaveState::EmulatorState {
+	uint64_t frameCycles;
+	uint64_t frameCount;
+	InputData input;
+	bool buttonPressed;
+	uint8_t _unused[5];
+};
+
+//! Memory block making up a chunk
+struct SaveState::Chunk {
+	const char* tag;
+	void* data;           //!< Contiguous data (null if paged)
+	size_t size;
+	PagedMemory* paged;   //!< Paged data (null if contiguous)
+
+	//! Copy the data out
+	void Read(uint8_t* out) const {
+		if (paged == nullptr) {
+			memcpy(out, data, size);
+			return;
+		}
+		for (size_t page = 0; page < paged->Pages(); ++page) {
+			memcpy(out + page * PagedMemory::PAGE_SIZE, paged->PageData(page), PagedMemory::PAGE_SIZE);
+		}
+	}
+
+	//! Overwrite the data
+	void Write(const uint8_t* in) const {
+		if (paged == nullptr) {
+			memcpy(data, in, size);
+			return;
+		}
+		for (size_t page = 0; page < paged->Pages(); ++page) {
+			memcpy(paged->WritablePage(page), in + page * PagedMemory::PAGE_SIZE, PagedMemory::PAGE_SIZE);
+		}
+	}
+
+	//! Copy the data from the same chunk of another machine (pages are shared, not copied)
+	void CopyFrom(const Chunk& other) const {
+		if (paged == nullptr) {
+			memcpy(data, other.data, size);
+		} else {
+			*paged = *other.paged;
+		}
+	}
+
+	//! Hash the data
+	uint64_t Hash() const {
+		if (paged == nullptr) {
+			return HashBytes(data, size);
+		}
+		uint64_t hash = HASH_SEED;
+		for (size_t page = 0; page < paged->Pages(); ++page) {
+			hash = HashBytes(paged->PageData(page), PagedMemory::PAGE_SIZE, hash);
+		}
+		return hash;
+	}
+};
+
+static uint16_t romChecksum(const Emulator& emulator) {
+	return (emulator.rom.header.globalChecksum[0] << 8) | emulator.rom.header.globalChecksum[1];
+}
+
+std::vector<SaveState::Chunk> SaveState::listChunks(Emulator& emulator, EmulatorState& extra) {
+	MMU& mmu = emulator.mmu;
+	MBC& mbc = *emulator.rom.controller;
+
+	// Tags are 4 characters
+	return {
+		{ "CPU ", static_cast<CPUState*>(&emulator.cpu), sizeof(CPUState),                            nullptr },
+		{ "MMU ", static_cast<MMUState*>(&mmu),          sizeof(MMUState),                            nullptr },
+		{ "WRAM", mmu.WRAMbanks.data(),                  mmu.WRAMbanks.size() * sizeof(WRAMBank),     nullptr },
+		{ "GPU ", static_cast<GPUState*>(&emulator.gpu), sizeof(GPUState),                            nullptr },
+		{ "VRAM", emulator.gpu.VRAM.data(),              emulator.gpu.VRAM.size() * sizeof(VRAMBank), nullptr },
+		{ "APU ", static_cast<APUState*>(&emulator.apu), sizeof(APUState),                            nullptr },
+		{ "MBC ", static_cast<MBCState*>(&mbc),          sizeof(MBCState),                            nullptr },
+		{ "CRAM", nullptr,                               mbc.ram.Size(),                              &mbc.ram },
+		{ "EMU ", &extra,                                sizeof(EmulatorState),                       nullptr }
+	};
+}
+
+void SaveState::captureExtra(const Emulator& emulator, EmulatorState& extra) {
+	memset(&extra, 0, sizeof(extra));
+	extra.frameCycles = emulator.frameCycles;
+	extra.frameCount = emulator.frameCount;
+	extra.input = emulator.input.data;
+	extra.buttonPressed = emulator.input.buttonPressed;
+}
+
+void SaveState::Save(const Emulator& constEmulator, std::vector<uint8_t>& out) {
+	// Chunks are only read from
+	Emulator& emulator = const_cast<Emulator&>(constEmulator);
+
+	EmulatorState extra;
+	captureExtra(emulator, extra);
+
+	const std::vector<Chunk> chunks = listChunks(emulator, extra);
+
+	size_t total = sizeof(StateHeader);
+	for (const Chunk& chunk : chunks) {
+		total += sizeof(ChunkHeader) + chunk.size;
+	}
+	out.resize(total);
+
+	StateHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = FORMAT_VERSION;
+	header.chunks = (uint32_t)chunks.size();
+	header.checksum = romChecksum(emulator);
+
+	uint8_t* cursor = out.data();
+	memcpy(cursor, &header, sizeof(header));
+	cursor += sizeof(header);
+
+	for (const Chunk& chunk : chunks) {
+		ChunkHeader chunkHeader;
+		memcpy(chunkHeader.tag, chunk.tag, 4);
+		chunkHeader.size = (uint32_t)chunk.size;
+		memcpy(cursor, &chunkHeader, sizeof(chunkHeader));
+		cursor += sizeof(chunkHeader);
+		chunk.Read(cursor);
+		cursor += chunk.size;
+	}
+}
+
+uint64_t SaveState::Hash(const Emulator& constEmulator, std::vector<ChunkHash>& out) {
+	Emulator& emulator = const_cast<Emulator&>(constEmulator);
+
+	EmulatorState extra;
+	captureExtra(emulator, extra);
+
+	const std::vector<Chunk> chunks = listChunks(emulator, extra);
+	out.resize(chunks.size());
+
+	uint64_t total = HASH_SEED;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		// Tag without padding, for reports
+		memcpy(out[i].tag, chunks[i].tag, 5);
+		for (int c = 3; c > 0 && out[i].tag[c] == ' '; --c) {
+			out[i].tag[c] = '\0';
+		}
+		out[i].hash = chunks[i].Hash();
+		total = HashBytes(&out[i].hash, sizeof(out[i].hash), total);
+	}
+	return total;
+}
+
+void SaveState::Load(Emulator& emulator, const uint8_t* data, const size_t size) {
+	StateHeader header;
+	if (size < sizeof(header)) {
+		throw std::runtime_error("Save state is truncated");
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		throw std::runtime_error("Not a save state");
+	}
+	if (header.version != FORMAT_VERSION) {
+		throw std::runtime_error("Unsupported save state version " + std::to_string(header.version));
+	}
+	if (header.checksum != romChecksum(emulator)) {
+		throw std::runtime_error("Save state was made with a different ROM");
+	}
+
+	EmulatorState extra;
+	const std::vector<Chunk> chunks = listChunks(emulator, extra);
+	if (header.chunks != chunks.size()) {
+		throw std::runtime_error("Save state has an unexpected number of chunks");
+	}
+
+	// Validate every chunk before touching the machine
+	std::vector<const uint8_t*> sources;
+	size_t offset = sizeof(header);
+	for (const Chunk& chunk : chunks) {
+		ChunkHeader chunkHeader;
+		if (size - offset < sizeof(chunkHeader)) {
+			throw std::runtime_error("Save state is truncated");
+		}
+		memcpy(&chunkHeader, data + offset, sizeof(chunkHeader));
+		offset += sizeof(chunkHeader);
+
+		if (memcmp(chunkHeader.tag, chunk.tag, 4) != 0) {
+			throw std::runtime_error(std::string("Save state is missing chunk ") + chunk.tag);
+		}
+		if (chunkHeader.size != chunk.size || size - offset < chunk.size) {
+			throw std::runtime_error(std::string("Save state chunk ") + chunk.tag + " doesn't match this machine");
+		}
+		sources.push_back(data + offset);
+		offset += chunk.size;
+	}
+
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		chunks[i].Write(sources[i]);
+	}
+
+	emulator.frameCycles = extra.frameCycles;
+	emulator.frameCount = extra.frameCount;
+	emulator.input.data = extra.input;
+	emulator.input.buttonPressed = extra.buttonPressed;
+}
+
+void SaveState::Copy(const Emulator& from, Emulator& to) {
+	EmulatorState extra;
+	captureExtra(from, extra);
+
+	const std::vector<Chunk> source = listChunks(const_cast<Emulator&>(from), extra);
+	EmulatorState unused;
+	const std::vector<Chunk> destination = listChunks(to, unused);
+	for (size_t i = 0; i < source.size(); ++i) {
+		if (source[i].size != destination[i].size) {
+			throw std::logic_error(std::string("Can't copy state between different machines (chunk ") + source[i].tag + ")");
+		}
+	}
+
+	for (size_t i = 0; i < source.size(); ++i) {
+		destination[i].CopyFrom(source[i]);
+	}
+	to.frameCycles = extra.frameCycles;
+	to.frameCount = extra.frameCount;
+	to.input.data = extra.input;
+	to.input.buttonPressed = extra.buttonPressed;
+	to.input.DropPending();
+}
+
+bool SaveState::SaveToFile(const Emulator& emulator, const std::string& path) {
+	std::vector<uint8_t> data;
+	Save(emulator, data);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.good()) {
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return file.good();
+}
+
+void SaveState::LoadFromFile(Emulator& emulator, const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good()) {
+		throw std::runtime_error("Could not open save state " + path);
+	}
+
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Load(emulator, data.data(), data.size());
+}
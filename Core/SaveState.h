@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Emulator;
+
+//! Hash of one save state chunk (see SaveState::Hash)
+struct ChunkHash {
+	char tag[5];        //!< Chunk tag without padding (ie. "CPU", "WRAM")
+	uint64_t hash;      //!< Hash of the chunk data
+};
+
+/*! \brief Machine snapshots
+ *
+ *  A save state is a versioned header followed by one chunk per subsystem
+ *  (tag, size, data). Every chunk is the bulk copy of a contiguous state
+ *  struct (CPUState, MMUState, GPUState, APUState, MBCState) or of a RAM
+ *  bank array, so saving and loading are mostly memcpy.
+ *
+ *  States are bound to the ROM they were made with and to the layout of the
+ *  state structs (any change to them must bump FORMAT_VERSION). They're meant for
+ *  the machine and build that made them, not for exchange between platforms.
+ */
+class SaveState final {
+private:
+	struct Chunk;
+	struct EmulatorState;
+
+	//! Lists the memory blocks making up the state of an emulator
+	static std::vector<Chunk> listChunks(Emulator& emulator, EmulatorState& extra);
+
+	//! Copy the emulator loop and joypad state (the "EMU " chunk)
+	static void captureExtra(const Emulator& emulator, EmulatorState& extra);
+
+public:
+	static const uint32_t FORMAT_VERSION = 2;
+
+	SaveState() = delete;
+
+	/*! \brief Snapshot the machine
+	 *
+	 *  \param emulator Emulator to save
+	 *  \param out Buffer to write the state to (reused, resized as needed)
+	 */
+	static void Save(const Emulator& emulator, std::vector<uint8_t>& out);
+
+	/*! \brief Restore a snapshot
+	 *
+	 *  Throws std::runtime_error if the state is not valid for this
+	 *  emulator (wrong ROM, version or layout), leaving it untouched.
+	 *
+	 *  \param emulator Emulator to restore
+	 *  \param data State to load
+	 *  \param size Size of the state
+	 */
+	static void Load(Emulator& emulator, const uint8_t* data, const size_t size);
+
+	/*! \brief Hash the machine state, chunk by chunk
+	 *
+	 *  Hashes the same data Save() would write, without copying it.
+	 *
+	 *  \param emulator Emulator to hash
+	 *  \param out Hash of each chunk, in save order (reused)
+	 *  \return Hash of the whole state
+	 */
+	static uint64_t Hash(const Emulator& emulator, std::vector<ChunkHash>& out);
+
+	/*! \brief Copy the machine state between emulators
+	 *
+	 *  Same as Save() then Load() without the intermediate buffer, and with
+	 *  paged memory (cartridge RAM) shared instead of copied.
+	 *  Input not latched yet by the target is dropped.
+	 *  Both emulators must be running the same ROM.
+	 *
+	 *  \param from Emulator to copy from
+	 *  \param to Emulator to copy to
+	 */
+	static void Copy(const Emulator& from, Emulator& to);
+
+	//! Save the machine to a file, returns false on I/O errors
+	static bool SaveToFile(const Emulator& emulator, const std::string& path);
+
+	//! Load the machine from a file, throws std::runtime_error on errors
+	static void LoadFromFile(Emulator& emulator, const std::string& path);
+};
@@ -0,0 +1,244 @@
+#include "Scaler.h"
+#include "GPU.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCALER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/* The kernels below follow the AdvanceMAME Scale2x/Scale3x rules, with
+ * pixels around E named as:
+ *   A B C
+ *   D E F
+ *   G H I
+ * Sources are padded by one pixel on each side, so neighbours can always
+ * be read without bound checks.
+ */
+
+// Scale2x on pixels [from, width) of a single line
+static inline void scale2xLine(const uint32_t* up, const uint32_t* center, const uint32_t* down,
+                               uint32_t* out0, uint32_t* out1, const int from, const int width) {
+	for (int x = from; x < width; ++x) {
+		const uint32_t B = up[x], D = center[x - 1], E = center[x], F = center[x + 1], H = down[x];
+		if (B != H && D != F) {
+			out0[x * 2]     = D == B ? D : E;
+			out0[x * 2 + 1] = B == F ? F : E;
+			out1[x * 2]     = D == H ? D : E;
+			out1[x * 2 + 1] = H == F ? F : E;
+		} else {
+			out0[x * 2] = out0[x * 2 + 1] = out1[x * 2] = out1[x * 2 + 1] = E;
+		}
+	}
+}
+
+// Scale3x on pixels [from, width) of a single line
+static inline void scale3xLine(const uint32_t* up, const uint32_t* center, const uint32_t* down,
+                               uint32_t* out0, uint32_t* out1, uint32_t* out2, const int from, const int width) {
+	uint32_t* o0 = out0 + from * 3;
+	uint32_t* o1 = out1 + from * 3;
+	uint32_t* o2 = out2 + from * 3;
+	for (int x = from; x < width; ++x, o0 += 3, o1 += 3, o2 += 3) {
+		const uint32_t A = up[x - 1],     B = up[x],     C = up[x + 1],
+		               D = center[x - 1], E = center[x], F = center[x + 1],
+		               G = down[x - 1],   H = down[x],   I = down[x + 1];
+		if (B != H && D != F) {
+			o0[0] = D == B ? D : E;
+			o0[1] = (D == B && E != C) || (B == F && E != A) ? B : E;
+			o0[2] = B == F ? F : E;
+			o1[0] = (D == B && E != G) || (D == H && E != A) ? D : E;
+			o1[1] = E;
+			o1[2] = (B == F && E != I) || (H == F && E != C) ? F : E;
+			o2[0] = D == H ? D : E;
+			o2[1] = (D == H && E != I) || (H == F && E != G) ? H : E;
+			o2[2] = H == F ? F : E;
+		} else {
+			o0[0] = o0[1] = o0[2] = o1[0] = o1[1] = o1[2] = o2[0] = o2[1] = o2[2] = E;
+		}
+	}
+}
+
+#ifdef SCALER_SSE2
+// Picks a where mask is set, b elsewhere
+static inline __m128i select(const __m128i mask, const __m128i a, const __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i load(const uint32_t* p) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static inline void store(uint32_t* p, const __m128i v) {
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+#endif
+
+// Scale2x of a padded source (width + 2 pixels per line) into dest (width * 2 pixels per line)
+static void scale2x(const uint32_t* source, uint32_t* dest, const int width, const int height) {
+	const int pitch = width + 2;
+	for (int y = 0; y < height; ++y) {
+		const uint32_t* center = source + (y + 1) * pitch + 1;
+		const uint32_t* up = center - pitch;
+		const uint32_t* down = center + pitch;
+		uint32_t* out0 = dest + (y * 2) * (width * 2);
+		uint32_t* out1 = out0 + width * 2;
+
+		int x = 0;
+#ifdef SCALER_SSE2
+		for (; x + 4 <= width; x += 4) {
+			const __m128i B = load(up + x), D = load(center + x - 1), E = load(center + x),
+			              F = load(center + x + 1), H = load(down + x);
+
+			// Only pixels where B != H and D != F get interpolated
+			const __m128i guard = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(B, H), _mm_cmpeq_epi32(D, F)), _mm_set1_epi32(-1));
+
+			const __m128i E0 = select(_mm_and_si128(guard, _mm_cmpeq_epi32(D, B)), D, E);
+			const __m128i E1 = select(_mm_and_si128(guard, _mm_cmpeq_epi32(B, F)), F, E);
+			const __m128i E2 = select(_mm_and_si128(guard, _mm_cmpeq_epi32(D, H)), D, E);
+			const __m128i E3 = select(_mm_and_si128(guard, _mm_cmpeq_epi32(H, F)), F, E);
+
+			// Interleave left/right output pixels
+			store(out0 + x * 2,     _mm_unpacklo_epi32(E0, E1));
+			store(out0 + x * 2 + 4, _mm_unpackhi_epi32(E0, E1));
+			store(out1 + x * 2,     _mm_unpacklo_epi32(E2, E3));
+			store(out1 + x * 2 + 4, _mm_unpackhi_epi32(E2, E3));
+		}
+#endif
+		scale2xLine(up, center, down, out0, out1, x, width);
+	}
+}
+
+// Scale3x of a padded source (width + 2 pixels per line) into dest (width * 3 pixels per line)
+static void scale3x(const uint32_t* source, uint32_t* dest, const int width, const int height) {
+	const int pitch = width + 2;
+	for (int y = 0; y < height; ++y) {
+		const uint32_t* center = source + (y + 1) * pitch + 1;
+		const uint32_t* up = center - pitch;
+		const uint32_t* down = center + pitch;
+		uint32_t* out0 = dest + (y * 3) * (width * 3);
+		uint32_t* out1 = out0 + width * 3;
+		uint32_t* out2 = out1 + width * 3;
+
+		int x = 0;
+#ifdef SCALER_SSE2
+		const __m128i ones = _mm_set1_epi32(-1);
+		for (; x + 4 <= width; x += 4) {
+			const __m128i A = load(up + x - 1),     B = load(up + x),     C = load(up + x + 1),
+			              D = load(center + x - 1), E = load(center + x), F = load(center + x + 1),
+			              G = load(down + x - 1),   H = load(down + x),   I = load(down + x + 1);
+
+			const __m128i guard = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(B, H), _mm_cmpeq_epi32(D, F)), ones);
+			const __m128i DB = _mm_and_si128(guard, _mm_cmpeq_epi32(D, B));
+			const __m128i BF = _mm_and_si128(guard, _mm_cmpeq_epi32(B, F));
+			const __m128i DH = _mm_and_si128(guard, _mm_cmpeq_epi32(D, H));
+			const __m128i HF = _mm_and_si128(guard, _mm_cmpeq_epi32(H, F));
+			const __m128i nEA = _mm_andnot_si128(_mm_cmpeq_epi32(E, A), ones);
+			const __m128i nEC = _mm_andnot_si128(_mm_cmpeq_epi32(E, C), ones);
+			const __m128i nEG = _mm_andnot_si128(_mm_cmpeq_epi32(E, G), ones);
+			const __m128i nEI = _mm_andnot_si128(_mm_cmpeq_epi32(E, I), ones);
+
+			uint32_t E9[9][4];
+			store(E9[0], select(DB, D, E));
+			store(E9[1], select(_mm_or_si128(_mm_and_si128(DB, nEC), _mm_and_si128(BF, nEA)), B, E));
+			store(E9[2], select(BF, F, E));
+			store(E9[3], select(_mm_or_si128(_mm_and_si128(DB, nEG), _mm_and_si128(DH, nEA)), D, E));
+			store(E9[4], E);
+			store(E9[5], select(_mm_or_si128(_mm_and_si128(BF, nEI), _mm_and_si128(HF, nEC)), F, E));
+			store(E9[6], select(DH, D, E));
+			store(E9[7], select(_mm_or_si128(_mm_and_si128(DH, nEI), _mm_and_si128(HF, nEG)), H, E));
+			store(E9[8], select(HF, F, E));
+
+			// Spread each 3x3 block over the output lines
+			for (int i = 0; i < 4; ++i) {
+				uint32_t* o0 = out0 + (x + i) * 3;
+				uint32_t* o1 = out1 + (x + i) * 3;
+				uint32_t* o2 = out2 + (x + i) * 3;
+				o0[0] = E9[0][i]; o0[1] = E9[1][i]; o0[2] = E9[2][i];
+				o1[0] = E9[3][i]; o1[1] = E9[4][i]; o1[2] = E9[5][i];
+				o2[0] = E9[6][i]; o2[1] = E9[7][i]; o2[2] = E9[8][i];
+			}
+		}
+#endif
+		scale3xLine(up, center, down, out0, out1, out2, x, width);
+	}
+}
+
+Scaler::Scaler(const ScalerType _type) : type(_type) {
+	if (type != Scaler_None) {
+		output.resize(Width() * Height());
+	}
+}
+
+int Scaler::Factor(const ScalerType type) {
+	switch (type) {
+	case Scaler_Scale2x: return 2;
+	case Scaler_Scale3x: return 3;
+	case Scaler_Scale4x: return 4;
+	case Scaler_None: default: return 1;
+	}
+}
+
+int Scaler::Width() const {
+	return WIDTH * Factor();
+}
+
+int Scaler::Height() const {
+	return HEIGHT * Factor();
+}
+
+void Scaler::pad(const uint32_t* source, const int width, const int height) {
+	const int pitch = width + 2;
+	padded.resize(pitch * (height + 2));
+
+	for (int y = 0; y < height; ++y) {
+		uint32_t* line = &padded[(y + 1) * pitch];
+		memcpy(line + 1, source + y * width, width * sizeof(uint32_t));
+		line[0] = line[1];
+		line[width + 1] = line[width];
+	}
+
+	// Repeat first and last line
+	memcpy(&padded[0], &padded[pitch], pitch * sizeof(uint32_t));
+	memcpy(&padded[(height + 1) * pitch], &padded[height * pitch], pitch * sizeof(uint32_t));
+}
+
+const uint32_t* Scaler::Scale(const uint32_t* screen) {
+	switch (type) {
+	case Scaler_Scale2x:
+		pad(screen, WIDTH, HEIGHT);
+		scale2x(padded.data(), output.data(), WIDTH, HEIGHT);
+		break;
+	case Scaler_Scale3x:
+		pad(screen, WIDTH, HEIGHT);
+		scale3x(padded.data(), output.data(), WIDTH, HEIGHT);
+		break;
+	case Scaler_Scale4x:
+		middle.resize(WIDTH * 2 * HEIGHT * 2);
+		pad(screen, WIDTH, HEIGHT);
+		scale2x(padded.data(), middle.data(), WIDTH, HEIGHT);
+		pad(middle.data(), WIDTH * 2, HEIGHT * 2);
+		scale2x(padded.data(), output.data(), WIDTH * 2, HEIGHT * 2);
+		break;
+	case Scaler_None:
+	default:
+		return screen;
+	}
+
+	return output.data();
+}
+
+bool Scaler::FromName(const std::string& name, ScalerType& type) {
+	if (name == "none") {
+		type = Scaler_None;
+	} else if (name == "scale2x") {
+		type = Scaler_Scale2x;
+	} else if (name == "scale3x") {
+		type = Scaler_Scale3x;
+	} else if (name == "scale4x") {
+		type = Scaler_Scale4x;
+	} else {
+		return false;
+	}
+	return true;
+}
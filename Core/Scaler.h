@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! Available pixel-art upscalers
+enum ScalerType : uint8_t {
+	Scaler_None    = 0, //!< No scaling (1x)
+	Scaler_Scale2x = 1, //!< Scale2x / EPX (2x)
+	Scaler_Scale3x = 2, //!< Scale3x (3x)
+	Scaler_Scale4x = 3  //!< Scale2x applied twice (4x)
+};
+
+/*! \brief Framebuffer upscaler
+ *
+ *  Upscales a Game boy framebuffer (ARGB8888, WIDTH x HEIGHT) with
+ *  a pixel-art scaling algorithm. Each instance owns its output buffer, so
+ *  the screen, recordings and screenshots can each have their own.
+ *  Kernels process 4 pixels at a time with SSE2 when available.
+ */
+class Scaler {
+private:
+	ScalerType type;
+	std::vector<uint32_t> padded; //!< Source with a 1 pixel clamped border
+	std::vector<uint32_t> middle; //!< Intermediate 2x buffer (Scale4x)
+	std::vector<uint32_t> output; //!< Scaled output
+
+	//! Copy source into the padded buffer, repeating the edge pixels
+	void pad(const uint32_t* source, const int width, const int height);
+
+public:
+	/*! \brief Create an upscaler
+	 *
+	 *  \param type Scaling algorithm to use
+	 */
+	explicit Scaler(const ScalerType type = Scaler_None);
+
+	//! Scale factor of the current algorithm
+	int Factor() const { return Factor(type); }
+
+	//! Scale factor of an algorithm
+	static int Factor(const ScalerType type);
+
+	//! Scaled output width
+	int Width() const;
+
+	//! Scaled output height
+	int Height() const;
+
+	//! Current scaling algorithm
+	ScalerType Type() const { return type; }
+
+	/*! \brief Upscale a frame
+	 *
+	 *  \param screen Framebuffer to scale (WIDTH x HEIGHT)
+	 *  \return Scaled frame (Width() x Height()), valid until the next call
+	 *          (the source itself when not scaling)
+	 */
+	const uint32_t* Scale(const uint32_t* screen);
+
+	/*! \brief Gets a scaler from its name
+	 *
+	 *  \param name Scaler name (none, scale2x, scale3x, scale4x)
+	 *  \param type Scaler type to set
+	 *  \return true if the name is valid
+	 */
+	static bool FromName(const std::string& name, ScalerType& type);
+};
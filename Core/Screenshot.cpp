@@ -0,0 +1,54 @@
+#include "Screenshot.h"
+#include "GPU.h"
+#include "PNG.h"
+
+#include <iostream>
+
+ScreenshotWriter::ScreenshotWriter(const ScalerType scalerType, const size_t _maxQueued)
+	: scaler(scalerType), maxQueued(_maxQueued < 1 ? 1 : _maxQueued) {
+	writer = std::thread(&ScreenshotWriter::writeLoop, this);
+}
+
+ScreenshotWriter::~ScreenshotWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	notEmpty.notify_one();
+	writer.join();
+}
+
+void ScreenshotWriter::Save(const std::string& path, const uint32_t* screen) {
+	Job job;
+	job.path = path;
+	job.pixels.assign(screen, screen + PIXELS);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	notFull.wait(lock, [this] { return jobs.size() < maxQueued; });
+	jobs.push_back(std::move(job));
+	lock.unlock();
+	notEmpty.notify_one();
+}
+
+void ScreenshotWriter::writeLoop() {
+	for (;;) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return !jobs.empty() || stopping; });
+		if (jobs.empty()) {
+			// Stopping and nothing left to write
+			break;
+		}
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		lock.unlock();
+		notFull.notify_one();
+
+		const uint32_t* pixels = scaler.Scale(job.pixels.data());
+		if (PNG::Write(job.path, pixels, scaler.Width(), scaler.Height())) {
+			std::clog << "[INFO] Saved frame to " << job.path << std::endl;
+		} else {
+			std::cerr << "[WARNING] Could not write " << job.path << std::endl;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Scaler.h"
+
+/*! \brief Screenshot writer
+ *
+ *  Saves frames to PNG files from a background thread, so taking
+ *  screenshots or dumping frame ranges doesn't stall the emulation.
+ *  Queueing waits when too many frames are still waiting to be written.
+ */
+class ScreenshotWriter final {
+private:
+	//! Frame waiting to be written
+	struct Job {
+		std::string path;
+		std::vector<uint32_t> pixels;
+	};
+
+	Scaler scaler;
+	size_t maxQueued;
+
+	std::deque<Job> jobs;
+	bool stopping = false;
+	std::mutex mutex;
+	std::condition_variable notEmpty, notFull;
+	std::thread writer;
+
+	void writeLoop();
+
+public:
+	/*! \brief Start the writer thread
+	 *
+	 *  \param scalerType Upscaler to apply to saved frames
+	 *  \param maxQueued Max frames waiting to be written
+	 */
+	explicit ScreenshotWriter(const ScalerType scalerType = Scaler_None, const size_t maxQueued = 32);
+
+	//! Stops the writer, after all queued frames have been written
+	~ScreenshotWriter();
+
+	ScreenshotWriter(const ScreenshotWriter&) = delete;
+	ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+
+	/*! \brief Queue a frame to be saved
+	 *
+	 *  \param path PNG file to write
+	 *  \param screen Framebuffer to save (WIDTH x HEIGHT, ARGB8888)
+	 */
+	void Save(const std::string& path, const uint32_t* screen);
+};
@@ -0,0 +1,99 @@
+#include "SharedExport.h"
+#include "Emulator.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+SharedExport::SharedExport(const std::string& name) : name(name), shared(nullptr) {
+	throw std::runtime_error("Shared memory export is only available on POSIX systems");
+}
+
+SharedExport::~SharedExport() {}
+
+#else
+
+SharedExport::SharedExport(const std::string& name) : name(name), shared(nullptr) {
+	// Never take over a segment: it may belong to another instance
+	const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0 && errno == EEXIST) {
+		throw std::runtime_error("Shared memory segment " + name + " already exists (in use, or left by a crashed run: remove it)");
+	}
+	if (fd < 0) {
+		throw std::runtime_error("Could not create shared memory segment: " + name);
+	}
+	void* memory = MAP_FAILED;
+	if (ftruncate(fd, sizeof(SharedFrame)) == 0) {
+		memory = mmap(nullptr, sizeof(SharedFrame), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (memory == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Could not map shared memory segment: " + name);
+	}
+
+	shared = static_cast<SharedFrame*>(memory);
+	memcpy(shared->magic, "MFEMUSHM", sizeof(shared->magic));
+	shared->version = LAYOUT_VERSION;
+	shared->width = WIDTH;
+	shared->height = HEIGHT;
+	shared->reserved = 0;
+	shared->frame = 0;
+	shared->buttons = 0;
+
+	// No frame yet
+	shared->sequence.store(0, std::memory_order_release);
+}
+
+SharedExport::~SharedExport() {
+	munmap(shared, sizeof(SharedFrame));
+	shm_unlink(name.c_str());
+}
+
+#endif
+
+void SharedExport::Publish(const Emulator& emulator) {
+	const uint64_t sequence = shared->sequence.load(std::memory_order_relaxed);
+	shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	shared->frame = emulator.FrameCount();
+	shared->buttons = emulator.input.GetButtons();
+	memcpy(shared->screen, emulator.gpu.screen, sizeof(shared->screen));
+	memcpy(shared->wram, emulator.mmu.Region(0xc000, 0x1000), 0x1000);
+	memcpy(shared->wram + 0x1000, emulator.mmu.Region(0xd000, 0x1000), 0x1000);
+	memcpy(shared->hram, emulator.mmu.Region(0xff80, sizeof(shared->hram)), sizeof(shared->hram));
+
+	shared->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool SharedExport::Read(const SharedFrame& shared, SharedFrameCopy& out) {
+	while (true) {
+		const uint64_t before = shared.sequence.load(std::memory_order_acquire);
+		if (before == 0) {
+			return false;
+		}
+		if (before & 1) {
+			continue;
+		}
+
+		out.frame = shared.frame;
+		out.buttons = shared.buttons;
+		memcpy(out.screen, shared.screen, sizeof(out.screen));
+		memcpy(out.wram, shared.wram, sizeof(out.wram));
+		memcpy(out.hram, shared.hram, sizeof(out.hram));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (shared.sequence.load(std::memory_order_relaxed) == before) {
+			return true;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "GPU.h"
+
+class Emulator;
+
+/*! \brief Shared memory layout
+ *
+ *  What other processes see in the segment. Frames are published with a
+ *  sequence lock: the sequence is odd while a frame is being written, so
+ *  a reader copies what it needs between two reads of an even, unchanged
+ *  sequence (see SharedExport::Read). Readers never block the emulator.
+ *
+ *  Readers in other languages can rely on this layout: no implicit padding,
+ *  host byte order, byte offsets below.
+ */
+struct SharedFrame {
+	char magic[8];                   //!< 0:     "MFEMUSHM"
+	uint32_t version;                //!< 8:     Layout version (SharedExport::LAYOUT_VERSION)
+	uint32_t width, height;          //!< 12/16: Screen size in pixels
+	uint32_t reserved;               //!< 20:    Keeps sequence 8 byte aligned
+	std::atomic<uint64_t> sequence;  //!< 24:    Odd while a frame is being written (plain u64 in memory)
+	uint64_t frame;                  //!< 32:    Frames since power on
+	uint8_t buttons;                 //!< 40:    Buttons held (see Input::GetButtons)
+	uint8_t padding[7];              //!< 41:    Keeps screen 8 byte aligned
+	uint32_t screen[PIXELS];         //!< 48:    Last complete frame (ARGB8888)
+	uint8_t wram[8 * 1024];          //!< 92208: Work RAM as mapped at c000-dfff
+	uint8_t hram[127];               //!< 100400: Zero page RAM (ff80-fffe)
+	uint8_t tail;                    //!< 100527: Unused, rounds the size to 100528 bytes
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == 8, "The shared sequence must be a plain 64 bit word");
+static_assert(sizeof(SharedFrame) == 100528, "Shared memory layout changed, bump SharedExport::LAYOUT_VERSION");
+
+//! Copy of a published frame (reader side)
+struct SharedFrameCopy {
+	uint64_t frame;
+	uint8_t buttons;
+	uint32_t screen[PIXELS];
+	uint8_t wram[8 * 1024];
+	uint8_t hram[127];
+};
+
+/*! \brief Screen and RAM export
+ *
+ *  Publishes the screen, work RAM and zero page to a named POSIX shared
+ *  memory segment once per frame, for viewers, bots or loggers running on
+ *  the same host. They map the segment and read it directly, no IPC.
+ *  The segment is removed when the export is destroyed.
+ *
+ *  Creating a segment that already exists fails: another instance is using
+ *  the name, or a crashed run left it behind (remove it from /dev/shm).
+ */
+class SharedExport final {
+private:
+	std::string name;
+	SharedFrame* shared;
+
+public:
+	static const uint32_t LAYOUT_VERSION = 2;
+
+	/*! \brief Create the segment
+	 *
+	 *  Throws std::runtime_error if it can't be created, or already exists.
+	 *
+	 *  \param name Segment name (ie. "/mfemu")
+	 */
+	explicit SharedExport(const std::string& name);
+
+	~SharedExport();
+
+	SharedExport(const SharedExport&) = delete;
+	SharedExport& operator=(const SharedExport&) = delete;
+
+	//! Publish the current frame of an emulator
+	void Publish(const Emulator& emulator);
+
+	/*! \brief Read a consistent frame from a mapped segment
+	 *
+	 *  \param shared Mapped segment (as written by Publish)
+	 *  \param out Copy of the last published frame
+	 *  \return false if no frame was published yet
+	 */
+	static bool Read(const SharedFrame& shared, SharedFrameCopy& out);
+};
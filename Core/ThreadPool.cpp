@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+
+// Worker running on this thread (to keep resubmitted tasks local)
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t threads) : queued(0), pending(0), next(0) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+		if (threads == 0) {
+			threads = 1;
+		}
+	}
+
+	for (size_t i = 0; i < threads; ++i) {
+		queues.emplace_back(new Queue());
+	}
+	for (size_t i = 0; i < threads; ++i) {
+		workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::Submit(Task task) {
+	pending.fetch_add(1);
+	if (currentPool == this) {
+		push(currentWorker, std::move(task));
+	} else {
+		push(next.fetch_add(1) % queues.size(), std::move(task));
+	}
+}
+
+void ThreadPool::Wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return pending.load() == 0; });
+}
+
+void ThreadPool::push(const size_t index, Task task) {
+	{
+		// Sleeping workers check the count with the pool mutex held. Count the task
+		// before it can be taken, or take() would decrement first and wrap the count
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.fetch_add(1);
+
+		std::lock_guard<std::mutex> queueLock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	wake.notify_one();
+}
+
+bool ThreadPool::take(const size_t index, Task& task) {
+	// Newest task of our own queue
+	{
+		Queue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// Oldest task of someone else's
+	for (size_t i = 1; i < queues.size(); ++i) {
+		Queue& other = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.tasks.empty()) {
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::work(const size_t index) {
+	currentPool = this;
+	currentWorker = index;
+
+	Task task;
+	while (true) {
+		if (!take(index, task)) {
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+			if (stopping && queued.load() == 0) {
+				return;
+			}
+			continue;
+		}
+
+		task();
+		task = nullptr;
+
+		if (pending.fetch_sub(1) == 1) {
+			std::lock_guard<std::mutex> lock(mutex);
+			idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! \brief Work-stealing thread pool
+ *
+ *  Every worker has its own task queue: it takes its newest task first
+ *  (cache friendly for tasks that resubmit themselves), and when it runs
+ *  out, steals the oldest task of another worker.
+ *  Tasks submitted from outside are spread over the queues.
+ */
+class ThreadPool final {
+public:
+	using Task = std::function<void()>;
+
+private:
+	//! Task queue of a worker
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;                    //!< Guards sleeping/waking and completion
+	std::condition_variable wake, idle;
+	std::atomic<size_t> queued;          //!< Tasks waiting in the queues
+	std::atomic<size_t> pending;         //!< Tasks submitted and not finished
+	std::atomic<size_t> next;            //!< Queue for the next outside submission
+	bool stopping = false;
+
+	//! Worker loop
+	void work(const size_t index);
+
+	//! Take a task, from the own queue first then from the others
+	bool take(const size_t index, Task& task);
+
+	//! Add a task to a queue
+	void push(const size_t index, Task task);
+
+public:
+	/*! \brief Start the workers
+	 *
+	 *  \param threads Number of workers (0: one per hardware thread)
+	 */
+	explicit ThreadPool(size_t threads = 0);
+
+	//! Finish all tasks and stop the workers
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/*! \brief Queue a task
+	 *
+	 *  From a worker, the task goes to that worker's queue.
+	 *
+	 *  \param task Task to run
+	 */
+	void Submit(Task task);
+
+	//! Wait until every submitted task (and the tasks they submitted) is done
+	void Wait();
+
+	//! Number of workers
+	size_t Size() const { return workers.size(); }
+};
@@ -0,0 +1,101 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+// Every ring ever created (only locked when a thread records its first zone, and on export)
+static std::mutex& registryMutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+
+static std::vector<std::unique_ptr<TraceRing>>& registry() {
+	static std::vector<std::unique_ptr<TraceRing>> rings;
+	return rings;
+}
+
+static thread_local TraceRing* localRing = nullptr;
+
+static TraceRing* registerThread() {
+	std::lock_guard<std::mutex> lock(registryMutex());
+	std::vector<std::unique_ptr<TraceRing>>& rings = registry();
+	rings.emplace_back(new TraceRing((unsigned)rings.size() + 1));
+	return rings.back().get();
+}
+
+uint64_t Trace::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::Record(const char* name, const uint64_t start, const uint64_t end) {
+	if (localRing == nullptr) {
+		localRing = registerThread();
+	}
+	const TraceEvent event = { name, start, end };
+	localRing->Push(event);
+}
+
+// Zone names are literals from the source, only quotes and backslashes need escaping
+static void writeName(std::ostream& out, const char* name) {
+	out << '"';
+	for (const char* c = name; *c != '\0'; ++c) {
+		if (*c == '"' || *c == '\\') {
+			out << '\\';
+		}
+		out << *c;
+	}
+	out << '"';
+}
+
+long long Trace::Export(const std::string& path) {
+	std::ofstream out(path, std::ios::binary);
+	if (!out) {
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	// Take what every ring has right now
+	struct Snapshot {
+		unsigned thread;
+		std::vector<TraceEvent> events;
+	};
+	std::vector<Snapshot> snapshots;
+	uint64_t origin = UINT64_MAX;
+	for (const std::unique_ptr<TraceRing>& ring : registry()) {
+		const uint64_t head = ring->head.load(std::memory_order_acquire);
+		const uint64_t first = head > TraceRing::CAPACITY ? head - TraceRing::CAPACITY : 0;
+		Snapshot snapshot;
+		snapshot.thread = ring->thread;
+		snapshot.events.reserve((size_t)(head - first));
+		for (uint64_t i = first; i < head; ++i) {
+			const TraceEvent& event = ring->events[i & (TraceRing::CAPACITY - 1)];
+			snapshot.events.push_back(event);
+			if (event.start < origin) {
+				origin = event.start;
+			}
+		}
+		snapshots.push_back(std::move(snapshot));
+	}
+
+	// Complete ("X") events, times in microseconds from the first zone
+	long long count = 0;
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	out << std::fixed << std::setprecision(3);
+	for (const Snapshot& snapshot : snapshots) {
+		for (const TraceEvent& event : snapshot.events) {
+			out << (count == 0 ? "\n" : ",\n") << "{\"name\":";
+			writeName(out, event.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << snapshot.thread
+				<< ",\"ts\":" << (event.start - origin) / 1000.0
+				<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			count++;
+		}
+	}
+	out << "\n]}\n";
+
+	return out.good() ? count : -1;
+}
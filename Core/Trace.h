@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! \brief Instrumentation zones
+ *
+ *  MFEMU_ZONE("name") times the rest of the enclosing scope and records it
+ *  on the calling thread's ring. Zones only exist in builds configured with
+ *  MFEMU_TRACE (cmake -DMFEMU_TRACE=ON), otherwise the macro expands to
+ *  nothing and costs nothing.
+ *
+ *  MFEMU_ZONE_FINE is for zones run per instruction or memory access: they
+ *  fill a ring in well under a second, overwriting the frame level zones,
+ *  so they're only compiled in at trace level 2 (-DMFEMU_TRACE_LEVEL=2).
+ *
+ *  Names must be string literals (only the pointer is kept).
+ */
+#ifdef MFEMU_TRACE
+#define MFEMU_ZONE_CONCAT2(a, b) a##b
+#define MFEMU_ZONE_CONCAT(a, b) MFEMU_ZONE_CONCAT2(a, b)
+#define MFEMU_ZONE(name) const TraceZone MFEMU_ZONE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define MFEMU_ZONE(name) ((void)0)
+#endif
+
+#if defined(MFEMU_TRACE) && MFEMU_TRACE >= 2
+#define MFEMU_ZONE_FINE(name) MFEMU_ZONE(name)
+#else
+#define MFEMU_ZONE_FINE(name) ((void)0)
+#endif
+
+//! Zones kept per thread (cmake -DMFEMU_TRACE_EVENTS=N), about 24 bytes each
+#ifndef MFEMU_TRACE_EVENTS
+#define MFEMU_TRACE_EVENTS (1 << 20)
+#endif
+
+//! A finished zone
+struct TraceEvent {
+	const char* name; //!< Zone name (string literal)
+	uint64_t start;   //!< Nanoseconds (steady clock)
+	uint64_t end;     //!< Nanoseconds (steady clock)
+};
+
+/*! \brief Per-thread event ring
+ *
+ *  Written by its thread only, without locks: the newest CAPACITY events are
+ *  kept and older ones are overwritten. Readers take the published head and
+ *  copy what's behind it.
+ */
+struct TraceRing {
+	static const size_t CAPACITY = MFEMU_TRACE_EVENTS;
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "MFEMU_TRACE_EVENTS must be a power of two");
+
+	std::vector<TraceEvent> events;
+	std::atomic<uint64_t> head;     //!< Events ever written
+	unsigned thread;                //!< Thread number in the trace
+
+	explicit TraceRing(const unsigned thread) : events(CAPACITY), head(0), thread(thread) {}
+
+	void Push(const TraceEvent& event) {
+		const uint64_t index = head.load(std::memory_order_relaxed);
+		events[index & (CAPACITY - 1)] = event;
+		head.store(index + 1, std::memory_order_release);
+	}
+};
+
+/*! \brief Zone recording and export
+ *
+ *  Every thread gets its ring the first time it records a zone. Rings live
+ *  until the program exits, so zones of finished threads can still be exported.
+ */
+class Trace final {
+public:
+	//! Were zones compiled in?
+	static bool Enabled() {
+#ifdef MFEMU_TRACE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	//! Current time (nanoseconds, steady clock)
+	static uint64_t Now();
+
+	//! Record a finished zone on the calling thread's ring
+	static void Record(const char* name, const uint64_t start, const uint64_t end);
+
+	/*! \brief Write every ring to a Chrome trace
+	 *
+	 *  Writes the JSON trace event format (complete events), to open in
+	 *  chrome://tracing or Perfetto. Best called once the threads are idle:
+	 *  zones recorded meanwhile might be missed.
+	 *
+	 *  \param path JSON file to write
+	 *  \return Number of events written, -1 if the file could not be written
+	 */
+	static long long Export(const std::string& path);
+};
+
+#ifdef MFEMU_TRACE
+//! Scope timer (see MFEMU_ZONE)
+class TraceZone final {
+private:
+	const char* name;
+	uint64_t start;
+
+public:
+	explicit TraceZone(const char* name) : name(name), start(Trace::Now()) {}
+	~TraceZone() { Trace::Record(name, start, Trace::Now()); }
+
+	TraceZone(const TraceZone&) = delete;
+	TraceZone& operator=(const TraceZone&) = delete;
+};
+#endif
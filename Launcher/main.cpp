@@ -3,6 +3,8 @@
 #include <Core/Emulator.h>
 #include <Core/Debugger.h>
 #include <Core/Config.h>
+#include <Core/Lockstep.h>
+#include <Core/ControlServer.h>
 
 enum MainFlags : uint8_t {
 	F_DEFAULT = 1,
@@ -20,6 +22,8 @@ int main(int argc, char **argv) {
 
 	EmulatorFlags emulatorFlags;
 	int queueSize = 10;
+	long long lockstepFrames = 0;
+	std::string controlSocket;
 
 	std::string confFile = Config::DEFAULT_FILE;
 
@@ -46,6 +50,27 @@ int main(int argc, char **argv) {
 				case 'b':
 					emulatorFlags.useBootrom = false;
 					break;
+				case 'f':
+					emulatorFlags.forceFifo = true;
+					break;
+				case 'm':
+					emulatorFlags.audio = false;
+					break;
+				case 'a': {
+					const std::string mode = i + 1 < argc ? argv[i + 1] : "";
+					if (mode == "video") {
+						emulatorFlags.sync = Sync_Video;
+					} else if (mode == "audio") {
+						emulatorFlags.sync = Sync_Audio;
+					} else if (mode == "dynamic") {
+						emulatorFlags.sync = Sync_Dynamic;
+					} else {
+						std::cout << "Invalid sync mode provided (use video, audio or dynamic)" << std::endl;
+						return 1;
+					}
+					i += 1;
+					break;
+				}
 				case 's': {
 					int scale = atoi(argv[i + 1]);
 					if (scale < 1) {
@@ -56,6 +81,175 @@ int main(int argc, char **argv) {
 					i += 1;
 					break;
 				}
+				case 'x':
+					if (i + 1 >= argc || !Scaler::FromName(argv[i + 1], emulatorFlags.scaler)) {
+						std::cout << "Invalid upscaler provided (use none, scale2x, scale3x or scale4x)" << std::endl;
+						return 1;
+					}
+					i += 1;
+					break;
+				case 'r':
+					if (i + 1 >= argc) {
+						std::cout << "No recording file provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.recordFile = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'e': {
+					int every = atoi(argv[i + 1]);
+					if (every < 1) {
+						std::cout << "Invalid frame interval provided (not an integer or less than 1)" << std::endl;
+						return 1;
+					}
+					emulatorFlags.recordEvery = every;
+					i += 1;
+					break;
+				}
+				case 'p': {
+					// Frame N or range N:M
+					const char* range = i + 1 < argc ? argv[i + 1] : "";
+					char* end = nullptr;
+					const long long first = strtoll(range, &end, 10);
+					long long last = first;
+					if (end != range && *end == ':') {
+						const char* next = end + 1;
+						last = strtoll(next, &end, 10);
+						if (end == next) {
+							end = nullptr;
+						}
+					}
+					if (end == nullptr || end == range || *end != '\0' || first < 0 || last < first) {
+						std::cout << "Invalid frame range provided (use N or N:M)" << std::endl;
+						return 1;
+					}
+					emulatorFlags.dumpFirst = first;
+					emulatorFlags.dumpLast = last;
+					i += 1;
+					break;
+				}
+				case 'l':
+					if (i + 1 >= argc) {
+						std::cout << "No save state file provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.stateFile = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'w': {
+					const int every = i + 1 < argc ? atoi(argv[i + 1]) : -1;
+					if (every < 0) {
+						std::cout << "Invalid rewind interval provided (not an integer or negative)" << std::endl;
+						return 1;
+					}
+					emulatorFlags.rewindEvery = every;
+					i += 1;
+					break;
+				}
+				case 'R':
+					if (i + 1 >= argc) {
+						std::cout << "No movie file provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.movieRecord = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'P':
+					if (i + 1 >= argc) {
+						std::cout << "No movie file provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.moviePlay = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'H':
+					emulatorFlags.headless = true;
+					break;
+				case 'D': {
+					const int every = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+					if (every < 1) {
+						std::cout << "Invalid hash interval provided (not an integer or less than 1)" << std::endl;
+						return 1;
+					}
+					emulatorFlags.hashEvery = every;
+					i += 1;
+					break;
+				}
+				case 'T': {
+					const int every = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+					if (every < 1) {
+						std::cout << "Invalid stats interval provided (not an integer or less than 1)" << std::endl;
+						return 1;
+					}
+					emulatorFlags.statsEvery = every;
+					i += 1;
+					break;
+				}
+				case 'k':
+					emulatorFlags.timing = true;
+					break;
+				case 'O': {
+					const int every = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+					if (every < 1) {
+						std::cout << "Invalid profiling interval provided (not an integer or less than 1)" << std::endl;
+						return 1;
+					}
+					emulatorFlags.profileEvery = every;
+					i += 1;
+					break;
+				}
+				case 'G':
+					if (i + 1 >= argc) {
+						std::cout << "No call stack file provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.callGraphFile = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'I':
+					if (i + 1 >= argc) {
+						std::cout << "No opcode histogram file provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.opcodeFile = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'Z':
+					if (i + 1 >= argc) {
+						std::cout << "No trace file provided" << std::endl;
+						return 1;
+					}
+					if (!Trace::Enabled()) {
+						std::cout << "[WARNING] Built without MFEMU_TRACE, there will be no zones to trace" << std::endl;
+					}
+					emulatorFlags.traceFile = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'S':
+					if (i + 1 >= argc) {
+						std::cout << "No shared memory name provided" << std::endl;
+						return 1;
+					}
+					emulatorFlags.sharedName = std::string(argv[i + 1]);
+					i += 1;
+					break;
+				case 'C':
+					if (i + 1 >= argc) {
+						std::cout << "No control socket path provided" << std::endl;
+						return 1;
+					}
+					controlSocket = std::string(argv[i + 1]);
+					emulatorFlags.headless = true;
+					i += 1;
+					break;
+				case 'L':
+					lockstepFrames = i + 1 < argc ? atoll(argv[i + 1]) : 0;
+					if (lockstepFrames < 1) {
+						std::cout << "Invalid frame count provided (not an integer or less than 1)" << std::endl;
+						return 1;
+					}
+					i += 1;
+					break;
 				case 'q': {
 					int size = atoi(argv[i + 1]);
 					if (size < 1) {
@@ -80,7 +274,30 @@ int main(int argc, char **argv) {
 						<< "\t-t   : start with code printing enabled (requires -d)\r\n"
 						<< "\t-n   : don't start the emulation right away (implies -d)\r\n"
 						<< "\t-s X : scale window X times the Game Boy resolution\r\n"
+						<< "\t-x X : upscale frames with X (scale2x, scale3x, scale4x)\r\n"
+						<< "\t-r X : record video to file X (.y4m for Y4M, raw ARGB8888 otherwise)\r\n"
+						<< "\t-e X : record one frame every X frames (requires -r)\r\n"
+						<< "\t-p X : dump frame X (or frames N to M with N:M) to frame-<n>.png\r\n"
+						<< "\t-l X : load save state X at startup (F5/F9 save/load <file.gb>.state)\r\n"
+						<< "\t-w X : capture a rewind state every X frames, 0 disables (default: 2, hold F2 to rewind)\r\n"
+						<< "\t-R X : record input to movie file X\r\n"
+						<< "\t-P X : replay the input of movie file X\r\n"
+						<< "\t-H   : headless: no window nor sound, unthrottled (quits when the movie ends)\r\n"
+						<< "\t-D X : log a hash of the machine state every X frames\r\n"
+						<< "\t-T X : print performance counters every X frames\r\n"
+						<< "\t-k   : time each subsystem (CPU, PPU, APU, timers, frontend) for -T and the debugger\r\n"
+						<< "\t-O X : profile the guest PC every X instructions, hot spots written to <file.gb>.profile on exit\r\n"
+						<< "\t-G X : trace guest calls, write the call stacks to X on exit (folded, for flamegraph.pl)\r\n"
+						<< "\t-I X : count executed opcodes, write the table to X on exit (CSV if X ends in .csv)\r\n"
+						<< "\t-Z X : write instrumentation zones to Chrome trace X on exit (needs -DMFEMU_TRACE=ON)\r\n"
+						<< "\t-L X : run the ROM (and -P movie) twice for X frames and report the first divergence\r\n"
+						<< "\t       (compares states every -D frames, -f runs the second with the FIFO renderer and compares screens only)\r\n"
+						<< "\t-S X : export screen, WRAM and HRAM to POSIX shared memory X (ie. /mfemu) every frame\r\n"
+						<< "\t-C X : run headless, driven by commands on Unix socket X (see ControlServer.h)\r\n"
 						<< "\t-q X : save up to X elements in the instruction history (required -d)\r\n"
+						<< "\t-f   : use the pixel FIFO renderer (for mid-scanline effects)\r\n"
+						<< "\t-m   : mute (don't open the audio device)\r\n"
+						<< "\t-a X : sync to X: video (vsync), audio or dynamic (vsync + audio rate control, default)\r\n"
 						<< "\t-b   : skip the DMG boot rom [experimental]\r\n" << std::endl;
 					return 0;
 				}
@@ -102,13 +319,45 @@ int main(int argc, char **argv) {
 	}
 
 	// Load config
-	if (Config::LoadFromFile(confFile)) {
+	Config config;
+	if (config.LoadFromFile(confFile)) {
 		std::cout << "[INFO] Loaded conf from " << confFile << "\r\n\r\n";
 	} else {
 		std::cout << "[WARNING] No valid conf found in " << confFile << ": using default conf.\r\n\r\n";
 	}
 
-	Emulator emulator(romFile, emulatorFlags);
+	// Make the window at least as big as the upscaled frames
+	const int scalerFactor = Scaler::Factor(emulatorFlags.scaler);
+	if (emulatorFlags.scale < scalerFactor) {
+		emulatorFlags.scale = scalerFactor;
+	}
+
+	// Determinism check: run twice and compare
+	if (lockstepFrames > 0) {
+		const bool compareRenderers = emulatorFlags.forceFifo;
+		emulatorFlags.forceFifo = false;
+		LockstepChecker checker(romFile, emulatorFlags, config, lockstepFrames, emulatorFlags.hashEvery, compareRenderers);
+		const Divergence divergence = checker.Run();
+		if (divergence.found) {
+			std::cout << "[WARNING] Runs diverged at frame " << divergence.frame << " in " << divergence.subsystem << std::endl;
+			return 2;
+		}
+		std::cout << "[INFO] Runs identical up to frame " << divergence.frames << std::endl;
+		return 0;
+	}
+
+	Emulator emulator(romFile, emulatorFlags, config);
+
+	// Remote controlled: only run when told to
+	if (!controlSocket.empty()) {
+		if (!emulator.Start()) {
+			return 1;
+		}
+		ControlServer server(controlSocket);
+		std::cout << "[INFO] Listening on " << controlSocket << std::endl;
+		server.Serve(emulator);
+		return 0;
+	}
 
 	if (flags & F_DEBUG) {
 		uint8_t debuggerFlags = Debug::DBG_INTERACTIVE;
@@ -0,0 +1,36 @@
+#include "Unit.h"
+
+#include <cstring>
+#include <Core/AudioRing.h>
+
+UNIT_TEST(audioring) {
+	AudioRing ring(7);
+	CHECK(ring.Capacity() == 8);
+
+	const int16_t first[] = { 1, 2, 3, 4, 5, 6 };
+	CHECK(ring.Push(first, 6) == 6);
+	int16_t out[8] = {};
+	CHECK(ring.Pop(out, 4) == 4);
+	CHECK(out[0] == 1 && out[3] == 4);
+
+	// Wraps around the end of the buffer
+	const int16_t second[] = { 7, 8, 9, 10, 11, 12 };
+	CHECK(ring.Push(second, 6) == 6);
+	CHECK(ring.Size() == 8);
+
+	// Full: dropped, counted as an overrun
+	const int16_t third[] = { 13, 14 };
+	CHECK(ring.Push(third, 2) == 0);
+	CHECK(ring.Overruns() == 1);
+
+	CHECK(ring.Pop(out, 8) == 8);
+	const int16_t expected[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+	CHECK(memcmp(out, expected, sizeof(expected)) == 0);
+	CHECK(ring.Underruns() == 0);
+
+	// Empty: the last frame is held, counted as an underrun
+	CHECK(ring.Pop(out, 4) == 0);
+	CHECK(out[0] == 11 && out[1] == 12 && out[2] == 11 && out[3] == 12);
+	CHECK(ring.Underruns() == 1);
+	CHECK(ring.Size() == 0);
+}
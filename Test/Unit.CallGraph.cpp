@@ -0,0 +1,47 @@
+#include "Unit.h"
+
+#include <vector>
+#include <Core/CallGraph.h>
+#include <Core/MBC.h>
+
+UNIT_TEST(callgraph) {
+	MBCState banking = {};
+	banking.romBankId = 3;
+	CallGraph graph(&banking, 0);
+
+	// root -> 0200 -> 4100 (bank 3), then 0300 calling itself
+	graph.Enter(0x0200, 0xfffc, 10);
+	graph.Enter(0x4100, 0xfffa, 20);
+	CHECK(graph.Depth() == 2);
+	graph.Leave(0xfffa, 50);
+	graph.Leave(0xfffc, 60);
+	CHECK(graph.Depth() == 0);
+	graph.Enter(0x0300, 0xfffc, 100);
+	graph.Enter(0x0300, 0xfffa, 110);
+	graph.Leave(0xfffa, 120);
+	graph.Leave(0xfffc, 130);
+
+	const std::vector<CallGraph::Function> functions = graph.Functions(200);
+	CHECK(functions.size() == 4);
+	for (const CallGraph::Function& function : functions) {
+		if (function.root) {
+			CHECK(function.inclusive == 200 && function.exclusive == 120);
+		} else if (function.address == 0x0200) {
+			CHECK(function.bank == 0 && function.calls == 1);
+			CHECK(function.inclusive == 50 && function.exclusive == 20);
+		} else if (function.address == 0x4100) {
+			CHECK(function.bank == 3 && function.calls == 1);
+			CHECK(function.inclusive == 30 && function.exclusive == 30);
+		} else {
+			// Recursive calls are only counted once in the inclusive cycles
+			CHECK(function.address == 0x0300 && function.calls == 2);
+			CHECK(function.inclusive == 30 && function.exclusive == 30);
+		}
+	}
+	CHECK(!functions.empty() && functions[0].root);
+
+	// Overwritten return address (no RET): the frame is dropped on the next call
+	graph.Enter(0x0400, 0xfffc, 300);
+	graph.Enter(0x0500, 0xfffc, 310);
+	CHECK(graph.Depth() == 1);
+}
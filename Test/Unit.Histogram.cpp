@@ -0,0 +1,30 @@
+#include "Unit.h"
+
+#include <vector>
+#include <Core/Histogram.h>
+
+UNIT_TEST(histogram) {
+	OpcodeHistogram histogram;
+	CHECK(histogram.Rows().empty());
+
+	histogram.Count(0x00, 0, 4);
+	histogram.Count(0x00, 0, 4);
+	histogram.Count(0x00, 0, 4);
+	histogram.Count(0xcb, 0x7c, 8);
+	histogram.Count(0xcb, 0x7c, 8);
+	histogram.Count(0xcb, 0x00, 8);
+	histogram.Count(0x7c, 0, 4);
+
+	// Most executed first, CB opcodes apart from the plain ones
+	const std::vector<OpcodeHistogram::Row> rows = histogram.Rows();
+	CHECK(rows.size() == 4);
+	if (rows.size() == 4) {
+		CHECK(rows[0].opcode == 0x00 && !rows[0].prefixed && rows[0].count == 3 && rows[0].cycles == 12);
+		CHECK(rows[1].opcode == 0x7c && rows[1].prefixed && rows[1].count == 2 && rows[1].cycles == 16);
+		CHECK(rows[2].opcode == 0x00 && rows[2].prefixed && rows[2].count == 1 && rows[2].cycles == 8);
+		CHECK(rows[3].opcode == 0x7c && !rows[3].prefixed && rows[3].count == 1 && rows[3].cycles == 4);
+	}
+
+	histogram.Reset();
+	CHECK(histogram.Rows().empty());
+}
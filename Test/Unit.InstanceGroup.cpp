@@ -0,0 +1,75 @@
+#include "Unit.h"
+
+#include <cstring>
+#include <vector>
+#include <Core/InstanceGroup.h>
+
+/*! \brief 32KB ROM only cartridge running a program from 0150
+ *
+ *  Made to run without the boot rom, interrupts are never enabled.
+ */
+static std::vector<uint8_t> tinyROM(const std::vector<uint8_t>& code) {
+	std::vector<uint8_t> image(32 * 1024, 0);
+	const uint8_t entry[] = { 0x00, 0xc3, 0x50, 0x01 }; // nop, jp $0150
+	memcpy(&image[0x100], entry, sizeof(entry));
+	memcpy(&image[0x134], "MFEMUUNIT", 9);
+	memcpy(&image[0x150], code.data(), code.size());
+
+	uint8_t checksum = 0;
+	for (size_t i = 0x134; i < 0x14d; ++i) {
+		checksum = checksum - image[i] - 1;
+	}
+	image[0x14d] = checksum;
+	return image;
+}
+
+UNIT_TEST(instancegroup) {
+	// Keeps copying the action buttons to c000
+	const std::vector<uint8_t> code = {
+		0x3e, 0x91,             // ld a,$91
+		0xe0, 0x40,             // ldh (LCDC),a  ; LCD on, so frames go by
+		0x3e, 0x10,             // loop: ld a,$10
+		0xe0, 0x00,             //       ldh (P1),a  ; action buttons
+		0xf0, 0x00,             //       ldh a,(P1)
+		0xea, 0x00, 0xc0,       //       ld ($c000),a
+		0xaf,                   //       xor a
+		0xe0, 0x0f,             //       ldh (IF),a
+		0x18, 0xf2,             //       jr loop
+	};
+
+	EmulatorFlags flags;
+	flags.headless = true;
+	flags.audio = false;
+	flags.rewindEvery = 0;
+	flags.useBootrom = false;
+	Emulator base(ROM(tinyROM(code)), "mfemu-unit.gb", flags);
+	CHECK(base.Start());
+
+	InstanceGroup group(base, 4, 1);
+	group.RunFrame({ 0, 0, 0, 0 });
+	CHECK(group.Machines() == 1);
+
+	// A, nothing, A, B: three different machines, same input the same machine
+	group.RunFrame({ 1, 0, 1, 2 });
+	CHECK(group.Machines() == 3);
+	CHECK(&group.Instance(0) == &group.Instance(2));
+	CHECK(&group.Instance(0) != &group.Instance(1) && &group.Instance(0) != &group.Instance(3));
+
+	// Buttons are latched at VBlank: the game sees them during the next frame
+	group.RunFrame({ 0, 0, 0, 0 });
+	CHECK(group.Machines() == 3);
+	CHECK(group.Instance(0).mmu.Region(0xc000, 1)[0] != group.Instance(1).mmu.Region(0xc000, 1)[0]);
+
+	// Buttons released everywhere: everyone is back in the same state
+	group.RunFrame({ 0, 0, 0, 0 });
+	CHECK(group.Machines() == 1);
+	CHECK(group.Count() == 4);
+	CHECK(group.Sharing() > 1.0);
+
+	// No merging: machines stay apart
+	InstanceGroup apart(base, 2, 0);
+	apart.RunFrame({ 1, 0 });
+	apart.RunFrame({ 0, 0 });
+	apart.RunFrame({ 0, 0 });
+	CHECK(apart.Machines() == 2);
+}
@@ -0,0 +1,73 @@
+#include "Unit.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Core/PNG.h>
+
+static uint32_t readBE32(const uint8_t* data) {
+	return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+//! Reference CRC-32 (bit by bit)
+static uint32_t crc32(const uint8_t* data, const size_t length) {
+	uint32_t c = 0xffffffff;
+	for (size_t i = 0; i < length; ++i) {
+		c ^= data[i];
+		for (int k = 0; k < 8; ++k) {
+			c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		}
+	}
+	return c ^ 0xffffffff;
+}
+
+UNIT_TEST(png) {
+	// 3x2 image, with a different value in each channel
+	const uint32_t pixels[] = { 0xff102030, 0xff405060, 0xff708090, 0xffa0b0c0, 0xffd0e0f0, 0xff010203 };
+	const std::vector<uint8_t> png = PNG::Encode(pixels, 3, 2);
+
+	const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	CHECK(png.size() > sizeof(signature) && memcmp(png.data(), signature, sizeof(signature)) == 0);
+
+	// Walk the chunks, checking their CRCs
+	std::vector<std::string> types;
+	std::vector<uint8_t> header, zlib;
+	size_t offset = sizeof(signature);
+	while (offset + 12 <= png.size()) {
+		const uint32_t length = readBE32(&png[offset]);
+		if (offset + 12 + length > png.size()) {
+			break;
+		}
+		const uint8_t* chunk = &png[offset + 4];
+		const std::string type((const char*)chunk, 4);
+		types.push_back(type);
+		CHECK(readBE32(chunk + 4 + length) == crc32(chunk, 4 + length));
+		if (type == "IHDR") {
+			header.assign(chunk + 4, chunk + 4 + length);
+		} else if (type == "IDAT") {
+			zlib.insert(zlib.end(), chunk + 4, chunk + 4 + length);
+		}
+		offset += 12 + length;
+	}
+	CHECK(offset == png.size());
+	CHECK((types == std::vector<std::string>{ "IHDR", "IDAT", "IEND" }));
+
+	// 3x2, 8 bit RGB
+	CHECK(header.size() == 13);
+	if (header.size() == 13) {
+		CHECK(readBE32(&header[0]) == 3 && readBE32(&header[4]) == 2);
+		CHECK(header[8] == 8 && header[9] == 2);
+	}
+
+	// A single stored block: filter byte then RGB for each line
+	const uint8_t raw[] = {
+		0, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80, 0x90,
+		0, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0, 0x01, 0x02, 0x03
+	};
+	CHECK(zlib.size() == 2 + 5 + sizeof(raw) + 4);
+	if (zlib.size() == 2 + 5 + sizeof(raw) + 4) {
+		CHECK(zlib[2] == 1 && zlib[3] == sizeof(raw) && zlib[4] == 0);
+		CHECK(memcmp(&zlib[7], raw, sizeof(raw)) == 0);
+	}
+}
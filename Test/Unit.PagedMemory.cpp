@@ -0,0 +1,29 @@
+#include "Unit.h"
+
+#include <Core/PagedMemory.h>
+
+UNIT_TEST(pagedmemory) {
+	const size_t PAGE = PagedMemory::PAGE_SIZE;
+	PagedMemory original(2 * PAGE);
+	CHECK(original.Pages() == 2 && original.Size() == 2 * PAGE);
+	CHECK(original.Read(0) == 0 && original.Read(2 * PAGE - 1) == 0);
+	original.Write(0, 1);
+	original.Write(PAGE, 2);
+
+	// Copies share their pages until written to
+	PagedMemory copy(original);
+	CHECK(copy.PageData(0) == original.PageData(0) && copy.PageData(1) == original.PageData(1));
+
+	copy.Write(1, 9);
+	CHECK(copy.PageData(0) != original.PageData(0));
+	CHECK(copy.PageData(1) == original.PageData(1));
+	CHECK(copy.Read(0) == 1 && copy.Read(1) == 9);
+	CHECK(original.Read(0) == 1 && original.Read(1) == 0);
+
+	// The original is now the only user of its page: written in place
+	const uint8_t* page = original.PageData(0);
+	original.Write(2, 3);
+	CHECK(original.PageData(0) == page);
+	CHECK(copy.Read(2) == 0);
+	CHECK(original.Read(PAGE) == 2 && copy.Read(PAGE) == 2);
+}
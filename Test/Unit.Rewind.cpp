@@ -0,0 +1,43 @@
+#include "Unit.h"
+
+#include <vector>
+#include <Core/Rewind.h>
+
+UNIT_TEST(rewind) {
+	CHECK(RewindBuffer(1024).Count() == 0);
+
+	// States differing in a few bytes, as consecutive frames do
+	std::vector<std::vector<uint8_t>> states;
+	std::vector<uint8_t> state(4096, 0);
+	for (int i = 0; i < 40; ++i) {
+		state[(i * 97) % state.size()] += (uint8_t)(i + 1);
+		state[(i * 31 + 7) % state.size()] ^= 0x5a;
+		states.push_back(state);
+	}
+
+	// Everything fits: states come back newest first
+	RewindBuffer buffer(64 * 1024);
+	for (const std::vector<uint8_t>& pushed : states) {
+		buffer.Push(pushed);
+	}
+	CHECK(buffer.Count() == states.size());
+	std::vector<uint8_t> out;
+	for (size_t i = states.size(); i-- > 0; ) {
+		CHECK(buffer.Pop(out) && out == states[i]);
+	}
+	CHECK(buffer.Count() == 0 && buffer.Used() == 0);
+	CHECK(!buffer.Pop(out));
+
+	// Small ring: the oldest are dropped, deltas wrap around the ring
+	RewindBuffer small(100);
+	for (const std::vector<uint8_t>& pushed : states) {
+		small.Push(pushed);
+	}
+	const size_t kept = small.Count();
+	CHECK(kept > 1 && kept < states.size());
+	CHECK(small.Used() <= 100);
+	for (size_t i = 0; i < kept; ++i) {
+		CHECK(small.Pop(out) && out == states[states.size() - 1 - i]);
+	}
+	CHECK(!small.Pop(out));
+}
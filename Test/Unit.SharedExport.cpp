@@ -0,0 +1,52 @@
+#include "Unit.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <Core/SharedExport.h>
+
+UNIT_TEST(sharedframe) {
+	std::unique_ptr<SharedFrame> shared(new SharedFrame());
+	std::unique_ptr<SharedFrameCopy> copy(new SharedFrameCopy());
+
+	// Nothing published yet
+	shared->sequence.store(0);
+	CHECK(!SharedExport::Read(*shared, *copy));
+
+	// Writer following SharedExport::Publish, every pixel set to the frame number
+	const uint64_t FRAMES = 2000;
+	std::thread writer([&shared, FRAMES] {
+		for (uint64_t frame = 1; frame <= FRAMES; ++frame) {
+			const uint64_t sequence = shared->sequence.load(std::memory_order_relaxed);
+			shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			shared->frame = frame;
+			for (uint32_t& pixel : shared->screen) {
+				pixel = (uint32_t)frame;
+			}
+			memset(shared->wram, (uint8_t)frame, sizeof(shared->wram));
+
+			shared->sequence.store(sequence + 2, std::memory_order_release);
+		}
+	});
+
+	// Copies are never torn, and frames never go back
+	uint64_t last = 0;
+	bool consistent = true;
+	while (last < FRAMES) {
+		if (!SharedExport::Read(*shared, *copy)) {
+			continue;
+		}
+		consistent = consistent && copy->frame >= last;
+		for (const uint32_t pixel : copy->screen) {
+			consistent = consistent && pixel == (uint32_t)copy->frame;
+		}
+		consistent = consistent && copy->wram[0] == (uint8_t)copy->frame && copy->wram[sizeof(copy->wram) - 1] == (uint8_t)copy->frame;
+		last = copy->frame;
+	}
+	writer.join();
+	CHECK(consistent);
+	CHECK(shared->sequence.load() == 2 * FRAMES);
+}
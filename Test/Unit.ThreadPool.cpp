@@ -0,0 +1,23 @@
+#include "Unit.h"
+
+#include <atomic>
+#include <Core/ThreadPool.h>
+
+UNIT_TEST(threadpool) {
+	// Tasks submitting tasks, many times over (the pool must go idle and wake up again)
+	ThreadPool pool(4);
+	CHECK(pool.Size() == 4);
+	for (int round = 0; round < 50; ++round) {
+		std::atomic<int> done(0);
+		for (int i = 0; i < 20; ++i) {
+			pool.Submit([&pool, &done] {
+				for (int j = 0; j < 10; ++j) {
+					pool.Submit([&done] { done++; });
+				}
+				done++;
+			});
+		}
+		pool.Wait();
+		CHECK(done.load() == 220);
+	}
+}
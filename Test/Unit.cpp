@@ -0,0 +1,71 @@
+#include "Unit.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//! A registered test
+struct UnitTest {
+	const char* name;
+	void (*run)();
+};
+
+//! Every registered test (built on first use: tests register from static initializers)
+static std::vector<UnitTest>& unitTests() {
+	static std::vector<UnitTest> tests;
+	return tests;
+}
+
+//! Failed checks of the test being run
+static std::vector<std::string> failures;
+
+bool RegisterUnitTest(const char* name, void (*run)()) {
+	unitTests().push_back({ name, run });
+	return true;
+}
+
+void CheckUnit(const bool passed, const char* condition, const char* file, const int line) {
+	if (!passed) {
+		// File name only
+		const char* name = file;
+		for (const char* c = file; *c != 0; ++c) {
+			if (*c == '/' || *c == '\\') {
+				name = c + 1;
+			}
+		}
+		std::ostringstream failure;
+		failure << name << ":" << line << ": " << condition;
+		failures.push_back(failure.str());
+	}
+}
+
+int RunUnitTests() {
+	// Same order whatever the link order
+	std::vector<UnitTest> tests = unitTests();
+	std::sort(tests.begin(), tests.end(), [](const UnitTest& a, const UnitTest& b) {
+		return strcmp(a.name, b.name) < 0;
+	});
+
+	int failed = 0;
+	for (const UnitTest& test : tests) {
+		failures.clear();
+		try {
+			test.run();
+		} catch (const std::exception& error) {
+			failures.push_back(std::string("exception: ") + error.what());
+		}
+
+		std::cout << (failures.empty() ? "[PASS] unit/" : "[FAIL] unit/") << test.name << std::endl;
+		for (const std::string& failure : failures) {
+			std::cout << "\t" << failure << std::endl;
+		}
+		failed += failures.empty() ? 0 : 1;
+	}
+
+	std::cout << std::endl << tests.size() - failed << "/" << tests.size() << " unit tests passed" << std::endl;
+	return failed;
+}
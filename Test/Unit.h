@@ -0,0 +1,29 @@
+#pragma once
+
+/*! \brief Run the built-in unit tests
+ *
+ *  Checks the core building blocks (encoders, rings, thread pool,
+ *  profilers...) on their own, without any test ROM.
+ *
+ *  \return Number of failed tests
+ */
+int RunUnitTests();
+
+/*! \brief Add a test to the ones RunUnitTests runs
+ *
+ *  \param name Name shown in the report (unit/<name>)
+ *  \param run Test body, reports failures with CHECK
+ *  \return true (to register from a static initializer, see UNIT_TEST)
+ */
+bool RegisterUnitTest(const char* name, void (*run)());
+
+//! Record a failed check of the running test
+void CheckUnit(const bool passed, const char* condition, const char* file, const int line);
+
+#define CHECK(condition) CheckUnit((condition), #condition, __FILE__, __LINE__)
+
+//! Define a unit test (name is a plain identifier)
+#define UNIT_TEST(name) \
+	static void unitTest_##name(); \
+	static const bool unitTestRegistered_##name = RegisterUnitTest(#name, unitTest_##name); \
+	static void unitTest_##name()
@@ -1,3 +1,347 @@
-int main() {
-	return 0;
-}
\ No newline at end of file
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <Core/Emulator.h>
+#include <Core/Hash.h>
+#include <Core/ThreadPool.h>
+#include "Unit.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+//! Game Boy frames per second (4194304 Hz / 70224 cycles)
+static const double FRAME_RATE = 4194304.0 / 70224.0;
+
+//! Runner options
+struct TestOptions {
+	uint64_t timeoutFrames = (uint64_t)(120 * FRAME_RATE); //!< Give up after this many emulated frames
+	bool useBootrom = true;
+	bool recordGolden = false;   //!< Write <rom>.hash for ROMs without a result
+};
+
+//! Outcome of a test ROM
+struct TestResult {
+	std::string path;
+	bool passed = false;
+	std::string reason;          //!< How the result was detected (or why it failed)
+	std::string serial;          //!< Bytes sent on the link port
+	uint64_t frames = 0;         //!< Emulated frames
+	double seconds = 0;          //!< Wall time
+};
+
+//! Screen expected at a given frame (<rom>.hash: "<frame> <hex hash>")
+struct GoldenFrame {
+	bool present = false;
+	uint64_t frame = 0;
+	uint64_t hash = 0;
+};
+
+static bool isROM(const std::string& path) {
+	const size_t dot = path.rfind('.');
+	if (dot == std::string::npos) {
+		return false;
+	}
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension == "gb" || extension == "gbc";
+}
+
+//! Add a ROM, or every ROM under a directory
+static void listROMs(const std::string& path, std::vector<std::string>& out) {
+#ifndef _WIN32
+	struct stat info;
+	if (stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+		DIR* directory = opendir(path.c_str());
+		if (directory == nullptr) {
+			return;
+		}
+		std::vector<std::string> entries;
+		while (dirent* entry = readdir(directory)) {
+			if (entry->d_name[0] != '.') {
+				entries.push_back(path + "/" + entry->d_name);
+			}
+		}
+		closedir(directory);
+
+		std::sort(entries.begin(), entries.end());
+		for (const std::string& entry : entries) {
+			if (stat(entry.c_str(), &info) == 0 && (S_ISDIR(info.st_mode) || isROM(entry))) {
+				listROMs(entry, out);
+			}
+		}
+		return;
+	}
+#endif
+	out.push_back(path);
+}
+
+static GoldenFrame loadGolden(const std::string& path) {
+	GoldenFrame golden;
+	std::ifstream file(path);
+	if (file >> golden.frame >> std::hex >> golden.hash) {
+		golden.present = true;
+	}
+	return golden;
+}
+
+//! Mooneye tests end with LD B,B, with these registers on success (all 0x42 on failure)
+static bool mooneyeResult(const CPU& cpu, bool& passed) {
+	const uint8_t registers[] = {
+		cpu.BC.Single.B, cpu.BC.Single.C, cpu.DE.Single.D, cpu.DE.Single.E, cpu.HL.Single.H, cpu.HL.Single.L
+	};
+	const uint8_t fibonacci[] = { 3, 5, 8, 13, 21, 34 };
+	const uint8_t failure[] = { 0x42, 0x42, 0x42, 0x42, 0x42, 0x42 };
+	if (memcmp(registers, fibonacci, sizeof(registers)) == 0) {
+		passed = true;
+		return true;
+	}
+	if (memcmp(registers, failure, sizeof(registers)) == 0) {
+		passed = false;
+		return true;
+	}
+	return false;
+}
+
+static TestResult runTest(const std::string& path, const TestOptions& options) {
+	TestResult result;
+	result.path = path;
+	const auto start = std::chrono::steady_clock::now();
+
+	EmulatorFlags flags;
+	flags.headless = true;
+	flags.audio = false;
+	flags.rewindEvery = 0;
+	flags.useBootrom = options.useBootrom;
+
+	const std::string goldenFile = path + ".hash";
+	const GoldenFrame golden = loadGolden(goldenFile);
+
+	try {
+		Emulator emulator(path, flags);
+		if (!emulator.Start()) {
+			throw std::runtime_error("Could not start the emulator");
+		}
+		emulator.mmu.serialOutput = [&result](uint8_t value) { result.serial.push_back((char)value); };
+
+		// Frames don't advance with the LCD off, time out on cycles
+		const uint64_t last = golden.present ? golden.frame : options.timeoutFrames;
+		const uint64_t cycleLimit = options.timeoutFrames * 70224;
+		bool done = false;
+		while (!done && emulator.running && emulator.FrameCount() < last && emulator.cpu.cycles.cpu < cycleLimit) {
+			// LD B,B: mooneye breakpoint
+			if (emulator.cpu.running && emulator.mmu.Peek(emulator.cpu.PC) == 0x40 &&
+				mooneyeResult(emulator.cpu, result.passed)) {
+				result.reason = result.passed ? "mooneye registers" : "mooneye failure registers";
+				break;
+			}
+
+			const size_t received = result.serial.size();
+			emulator.CheckUpdate();
+			emulator.Step();
+			if (result.serial.size() == received) {
+				continue;
+			}
+
+			// Blargg tests print their result on the link port
+			if (result.serial.find("Passed") != std::string::npos) {
+				result.passed = done = true;
+				result.reason = "serial output";
+			} else if (result.serial.find("Failed") != std::string::npos) {
+				done = true;
+				result.reason = "serial output";
+			}
+		}
+		result.frames = emulator.FrameCount();
+
+		if (!result.reason.empty()) {
+			// Detected above
+		} else if (!emulator.running) {
+			result.reason = "CPU locked up";
+		} else if (golden.present && emulator.FrameCount() == golden.frame) {
+			const uint64_t hash = HashBytes(emulator.gpu.screen, sizeof(emulator.gpu.screen));
+			result.passed = hash == golden.hash;
+			result.reason = result.passed ? "golden frame" : "frame differs from " + goldenFile;
+		} else if (options.recordGolden) {
+			std::ofstream file(goldenFile);
+			file << emulator.FrameCount() << " " << std::hex << std::setw(16) << std::setfill('0')
+				<< HashBytes(emulator.gpu.screen, sizeof(emulator.gpu.screen)) << std::endl;
+			result.passed = (bool)file;
+			result.reason = result.passed ? "golden frame recorded" : "could not write " + goldenFile;
+		} else {
+			std::stringstream reason;
+			reason << "timed out after " << std::fixed << std::setprecision(1) << emulator.cpu.cycles.cpu / 4194304.0 << "s";
+			result.reason = reason.str();
+		}
+	} catch (const std::exception& error) {
+		result.reason = error.what();
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+static std::string escapeXML(const std::string& text) {
+	std::string out;
+	for (const char c : text) {
+		switch (c) {
+		case '&':  out += "&amp;";  break;
+		case '<':  out += "&lt;";   break;
+		case '>':  out += "&gt;";   break;
+		case '"':  out += "&quot;"; break;
+		case '\'': out += "&apos;"; break;
+		default:
+			// Only text and line breaks are allowed
+			if ((unsigned char)c >= 0x20 || c == '\n' || c == '\t') {
+				out += c;
+			}
+		}
+	}
+	return out;
+}
+
+static bool writeJUnit(const std::string& path, const std::vector<TestResult>& results, const double seconds) {
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	size_t failures = 0;
+	for (const TestResult& result : results) {
+		failures += result.passed ? 0 : 1;
+	}
+
+	file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<testsuites>\n"
+		<< "  <testsuite name=\"mfemu\" tests=\"" << results.size() << "\" failures=\"" << failures
+		<< "\" errors=\"0\" time=\"" << seconds << "\">\n";
+	for (const TestResult& result : results) {
+		const size_t slash = result.path.rfind('/');
+		const std::string directory = slash == std::string::npos ? "." : result.path.substr(0, slash);
+		const std::string name = slash == std::string::npos ? result.path : result.path.substr(slash + 1);
+
+		file << "    <testcase classname=\"" << escapeXML(directory) << "\" name=\"" << escapeXML(name)
+			<< "\" time=\"" << result.seconds << "\">\n";
+		if (!result.passed) {
+			file << "      <failure message=\"" << escapeXML(result.reason) << "\"/>\n";
+		}
+		if (!result.serial.empty()) {
+			file << "      <system-out>" << escapeXML(result.serial) << "</system-out>\n";
+		}
+		file << "    </testcase>\n";
+	}
+	file << "  </testsuite>\n"
+		<< "</testsuites>\n";
+	return (bool)file;
+}
+
+int main(int argc, char **argv) {
+	std::cout << "mfemu_test v." << VERSION << " rev." << COMMIT << std::endl << std::endl;
+
+	TestOptions options;
+	std::vector<std::string> paths;
+	std::string reportFile = "mfemu-test.xml";
+	int threads = 0;
+
+	for (int i = 1; i < argc; i += 1) {
+		if (argv[i][0] == '-') {
+			switch (argv[i][1]) {
+			case 'j':
+				threads = i + 1 < argc ? atoi(argv[i + 1]) : -1;
+				if (threads < 0) {
+					std::cout << "Invalid thread count provided (not an integer or negative)" << std::endl;
+					return 1;
+				}
+				i += 1;
+				break;
+			case 't': {
+				const double seconds = i + 1 < argc ? atof(argv[i + 1]) : 0;
+				if (seconds <= 0) {
+					std::cout << "Invalid timeout provided (not a number or not positive)" << std::endl;
+					return 1;
+				}
+				options.timeoutFrames = (uint64_t)(seconds * FRAME_RATE);
+				i += 1;
+				break;
+			}
+			case 'o':
+				if (i + 1 >= argc) {
+					std::cout << "No report file provided" << std::endl;
+					return 1;
+				}
+				reportFile = std::string(argv[i + 1]);
+				i += 1;
+				break;
+			case 'g':
+				options.recordGolden = true;
+				break;
+			case 'b':
+				options.useBootrom = false;
+				break;
+			case 'u':
+				return RunUnitTests() == 0 ? 0 : 1;
+			default:
+				std::cout << "Usage: " << argv[0] << " [flags] <rom or directory>...\r\n"
+					<< "\r\nRuns test ROMs headless and reports which passed. A ROM passes when it prints\r\n"
+					<< "\"Passed\" on the link port (blargg), reaches LD B,B with B/C/D/E/H/L = 3/5/8/13/21/34\r\n"
+					<< "(mooneye), or shows the frame recorded in <rom>.hash (\"<frame> <hex hash>\").\r\n"
+					<< "\r\nOptions are listed below:\r\n"
+					<< "\t-h   : get this help\r\n"
+					<< "\t-j X : use X threads, 0 for one per core (default: 0)\r\n"
+					<< "\t-t X : fail ROMs with no result after X emulated seconds (default: 120)\r\n"
+					<< "\t-o X : write the JUnit report to X (default: mfemu-test.xml)\r\n"
+					<< "\t-g   : record <rom>.hash for ROMs with no result, from their last frame\r\n"
+					<< "\t-b   : skip the DMG boot rom [experimental]\r\n"
+					<< "\t-u   : run the built-in unit tests (no ROM needed) and exit\r\n" << std::endl;
+				return 0;
+			}
+		} else {
+			listROMs(argv[i], paths);
+		}
+	}
+
+	if (paths.empty()) {
+		std::cout << "No test ROM provided (use -h for help)" << std::endl;
+		return 1;
+	}
+
+	std::vector<TestResult> results(paths.size());
+	std::mutex printing;
+	size_t passed = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	{
+		ThreadPool pool(threads);
+		std::cout << "[INFO] Running " << paths.size() << " test ROMs on " << pool.Size() << " threads" << std::endl;
+
+		for (size_t i = 0; i < paths.size(); ++i) {
+			pool.Submit([&, i] {
+				results[i] = runTest(paths[i], options);
+
+				std::lock_guard<std::mutex> lock(printing);
+				const TestResult& result = results[i];
+				passed += result.passed ? 1 : 0;
+				std::cout << (result.passed ? "[PASS] " : "[FAIL] ") << result.path << " (" << result.reason << ", "
+					<< result.frames << " frames, " << std::fixed << std::setprecision(2) << result.seconds << "s)" << std::endl;
+			});
+		}
+		pool.Wait();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << std::endl << passed << "/" << results.size() << " passed in " << std::fixed << std::setprecision(2)
+		<< seconds << "s" << std::endl;
+	if (!writeJUnit(reportFile, results, seconds)) {
+		std::cout << "[WARNING] Could not write report " << reportFile << std::endl;
+	} else {
+		std::cout << "[INFO] Report written to " << reportFile << std::endl;
+	}
+
+	return passed == results.size() ? 0 : 1;
+}